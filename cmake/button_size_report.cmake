@@ -0,0 +1,32 @@
+# Print the memory taken by buttons and callbacks on the target.
+#
+# Run by the button_size_report target, the sizes are those of the button_size_* symbols
+# of the built component library:
+#     cmake --build build --target button_size_report
+#
+# Inputs: NM, the nm of the toolchain, and LIB, the component library.
+
+execute_process(COMMAND ${NM} -S --defined-only ${LIB}
+                OUTPUT_VARIABLE symbols
+                RESULT_VARIABLE result)
+if(NOT result EQUAL 0)
+    message(FATAL_ERROR "button size report: ${NM} failed on ${LIB}")
+endif()
+
+foreach(name button cb cb_table handle_slot group)
+    if(NOT symbols MATCHES "[0-9a-fA-F]+ ([0-9a-fA-F]+) [A-Za-z] button_size_${name}\n")
+        message(FATAL_ERROR "button size report: button_size_${name} not found in ${LIB}")
+    endif()
+    math(EXPR size_${name} "0x${CMAKE_MATCH_1}")
+endforeach()
+
+math(EXPR per_button "${size_button} + ${size_handle_slot}")
+math(EXPR per_group "${size_group} + ${size_cb_table}")
+math(EXPR group_500 "${per_group} + 500 * ${per_button}")
+
+message("button size report")
+message("  per button:               ${per_button} bytes (button ${size_button}, handle slot ${size_handle_slot}), plus the heap block header if created alone")
+message("  per callback:             ${size_cb} bytes")
+message("  per callback table:       ${size_cb_table} bytes, one per button with its own callbacks, shared by a group")
+message("  per group:                ${per_group} bytes with its callback table")
+message("  500 buttons in a group:   ${group_500} bytes, plus ${size_cb} bytes per group callback")
@@ -19,21 +19,24 @@ static void onButtonSingleClickRepeatCb(void *button_handle, void *usr_data)
     Serial.println("Button single click repeat");
 }
 
+// Button owns its handle, kept in static storage for the life of the sketch
+static Button btn;
+
 void setup()
 {
     // put your setup code here, to run once:
     Serial.begin(115200);
 
     // initializing a button
-    Button *btn = new Button(GPIO_NUM_9, false);
+    btn = Button(GPIO_NUM_9, false);
 
-    btn->attachPressDownEventCb(&onButtonPressDownCb, NULL);
-    btn->attachPressUpEventCb(&onButtonPressUpCb, NULL);
-    btn->attachPressDownEventCb(&onButtonPressDownRepeatCb, NULL);
-    btn->attachSingleClickEventCb(&onButtonSingleClickCb,NULL);
-    btn->attachSingleClickEventCb(&onButtonSingleClickRepeatCb,NULL);
-    btn->unregisterPressDownEventCb(&onButtonPressDownCb);
-    btn->detachSingleClickEvent();
+    btn.attachPressDownEventCb(&onButtonPressDownCb, NULL);
+    btn.attachPressUpEventCb(&onButtonPressUpCb, NULL);
+    btn.attachPressDownEventCb(&onButtonPressDownRepeatCb, NULL);
+    btn.attachSingleClickEventCb(&onButtonSingleClickCb,NULL);
+    btn.attachSingleClickEventCb(&onButtonSingleClickRepeatCb,NULL);
+    btn.unregisterPressDownEventCb(&onButtonPressDownCb);
+    btn.detachSingleClickEvent();
 }
 
 void loop()
@@ -17,6 +17,15 @@ static const char *TAG = "arduino-button";
         ESP_LOGE(TAG, "%s(%d): %s, Error Code: %d", __FUNCTION__, __LINE__, message, result); \
     }
 
+// Callables attached to buttons, kept out of the Button object so that moving a Button keeps them in place
+typedef struct {
+    button_handle_t handle;
+    button_event_t event;
+    ButtonFunction function;
+} ButtonFunctionSlot;
+
+static ButtonFunctionSlot s_function_slots[CONFIG_BUTTON_CALLBACK_SLOTS];
+
 // Constructor for button using GPIO pin
 Button::Button(gpio_num_t pin, bool pullup)
 {
@@ -42,7 +51,7 @@ Button::Button(gpio_num_t pin, bool pullup)
 }
 
 // Constructor for button using ADC pin
-Button::Button(gpio_num_t pin, bool pullup, uint8_t adc_channel, uint8_t button_index, uint16_t min, uint16_t max)
+Button::Button(gpio_num_t pin, bool pullup, uint8_t adc_channel, uint8_t button_index, uint16_t min, uint16_t max, bool autoCalibrate)
 {
     _button_pin = pin;
 
@@ -59,6 +68,7 @@ Button::Button(gpio_num_t pin, bool pullup, uint8_t adc_channel, uint8_t button_
             .button_index = button_index, // Set button index
             .min = min, // Set minimum ADC reading
             .max = max, // Set maximum ADC reading
+            .auto_calibrate = autoCalibrate, // Learn the voltages of the channel
 #if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 0, 0)
             .adc_handle = NULL           /**< handle of adc unit, if NULL will create new one internal, else will use the handle */
 #endif
@@ -70,6 +80,174 @@ Button::Button(gpio_num_t pin, bool pullup, uint8_t adc_channel, uint8_t button_
     ESP_LOGI(TAG, "Button created");
 }
 
+// Constructor for virtual button
+Button::Button(const button_virtual_config_t &config)
+{
+    _button_pin = GPIO_NUM_NC;
+
+    // Configure button fed by injectLevel()
+    button_config_t cfg = {};
+    cfg.type = BUTTON_TYPE_VIRTUAL; // Set button type as virtual
+    cfg.long_press_time = CONFIG_BUTTON_LONG_PRESS_TIME_MS; // Set long press time
+    cfg.short_press_time = CONFIG_BUTTON_SHORT_PRESS_TIME_MS; // Set short press time
+    cfg.virtual_button_config = config;
+    // Create button handle
+    _handle = iot_button_create(&cfg);
+    // Print button created message for debugging purposes
+    ESP_LOGI(TAG, "Button created");
+}
+
+// Destructor, deletes the button if not deleted by del()
+Button::~Button()
+{
+    if (_handle) {
+        CHECK_ESP_ERROR(iot_button_delete(_handle), "delete button fail");
+        detachFunctions(BUTTON_EVENT_MAX);
+    }
+}
+
+// Move constructor, takes over the handle
+Button::Button(Button &&other) noexcept
+    : _button_pin(other._button_pin), _handle(other._handle)
+{
+    other._button_pin = GPIO_NUM_NC;
+    other._handle = NULL;
+}
+
+// Move assignment, deletes the current button and takes over the handle
+Button &Button::operator=(Button &&other) noexcept
+{
+    if (this != &other) {
+        if (_handle) {
+            CHECK_ESP_ERROR(iot_button_delete(_handle), "delete button fail");
+            detachFunctions(BUTTON_EVENT_MAX);
+        }
+        _button_pin = other._button_pin;
+        _handle = other._handle;
+        other._button_pin = GPIO_NUM_NC;
+        other._handle = NULL;
+    }
+    return *this;
+}
+
+// Attach a callable to a free slot, its invoker is registered with the slot storage as usr_data
+void Button::attachFunction(button_event_config_t config, ButtonFunction &&function)
+{
+    if (!_handle) {
+        ESP_LOGE(TAG, "Button not created");
+        return;
+    }
+    if (!function) {
+        ESP_LOGE(TAG, "Callback function not defined");
+        return;
+    }
+    for (ButtonFunctionSlot &slot : s_function_slots) {
+        if (!slot.function) {
+            slot.function = std::move(function);
+            esp_err_t ret = iot_button_register_event_cb(_handle, config, slot.function.invoker(), slot.function.storage());
+            if (ret != ESP_OK) {
+                slot.function.reset();
+                CHECK_ESP_ERROR(ret, "attach callback fail");
+                return;
+            }
+            slot.handle = _handle;
+            slot.event = config.event;
+            return;
+        }
+    }
+    ESP_LOGE(TAG, "No free callback slot, raise CONFIG_BUTTON_CALLBACK_SLOTS");
+}
+
+// Release the callables of an event once unregistered, BUTTON_EVENT_MAX for all of them
+void Button::detachFunctions(button_event_t event)
+{
+    for (ButtonFunctionSlot &slot : s_function_slots) {
+        if (slot.function && slot.handle == _handle && (BUTTON_EVENT_MAX == event || slot.event == event)) {
+            slot.function.reset();
+            slot.handle = NULL;
+        }
+    }
+}
+
+// Methods to attach callables
+void Button::attachPressDownEventCb(ButtonFunction function)
+{
+    button_event_config_t btn_cfg = {};
+    btn_cfg.event = BUTTON_PRESS_DOWN;
+    attachFunction(btn_cfg, std::move(function));
+}
+
+void Button::attachPressUpEventCb(ButtonFunction function)
+{
+    button_event_config_t btn_cfg = {};
+    btn_cfg.event = BUTTON_PRESS_UP;
+    attachFunction(btn_cfg, std::move(function));
+}
+
+void Button::attachPressRepeatEventCb(ButtonFunction function)
+{
+    button_event_config_t btn_cfg = {};
+    btn_cfg.event = BUTTON_PRESS_REPEAT;
+    attachFunction(btn_cfg, std::move(function));
+}
+
+void Button::attachSingleClickEventCb(ButtonFunction function)
+{
+    button_event_config_t btn_cfg = {};
+    btn_cfg.event = BUTTON_SINGLE_CLICK;
+    attachFunction(btn_cfg, std::move(function));
+}
+
+void Button::attachDoubleClickEventCb(ButtonFunction function)
+{
+    button_event_config_t btn_cfg = {};
+    btn_cfg.event = BUTTON_DOUBLE_CLICK;
+    attachFunction(btn_cfg, std::move(function));
+}
+
+void Button::attachLongPressStartEventCb(ButtonFunction function)
+{
+    button_event_config_t btn_cfg = {};
+    btn_cfg.event = BUTTON_LONG_PRESS_START;
+    attachFunction(btn_cfg, std::move(function));
+}
+
+void Button::attachLongPressHoldEventCb(ButtonFunction function)
+{
+    button_event_config_t btn_cfg = {};
+    btn_cfg.event = BUTTON_LONG_PRESS_HOLD;
+    attachFunction(btn_cfg, std::move(function));
+}
+
+void Button::attachPressRepeatDoneEventCb(ButtonFunction function)
+{
+    button_event_config_t btn_cfg = {};
+    btn_cfg.event = BUTTON_PRESS_REPEAT_DONE;
+    attachFunction(btn_cfg, std::move(function));
+}
+
+void Button::attachLongPressUpEventCb(ButtonFunction function)
+{
+    button_event_config_t btn_cfg = {};
+    btn_cfg.event = BUTTON_LONG_PRESS_UP;
+    attachFunction(btn_cfg, std::move(function));
+}
+
+void Button::attachButtonNonePressEventCb(ButtonFunction function)
+{
+    button_event_config_t btn_cfg = {};
+    btn_cfg.event = BUTTON_NONE_PRESS;
+    attachFunction(btn_cfg, std::move(function));
+}
+
+void Button::attachMultipleClickEventCb(ButtonFunction function, int clicks)
+{
+    button_event_config_t btn_cfg = {};
+    btn_cfg.event = BUTTON_MULTIPLE_CLICK;
+    btn_cfg.event_data.multiple_clicks.clicks = clicks;
+    attachFunction(btn_cfg, std::move(function));
+}
+
 /* 0. Button Press Down*/
 
 // Method to attach callback function for button press down event
@@ -101,6 +279,7 @@ void Button::detachPressDownEvent(void)
         return;
     }
     CHECK_ESP_ERROR(iot_button_unregister_cb(_handle, BUTTON_PRESS_DOWN), "detach pressdown event fail");
+    detachFunctions(BUTTON_PRESS_DOWN);
 }
 
 /* 1. Button Press Up*/
@@ -138,6 +317,8 @@ void Button::detachPressUpEvent(void)
     }
 
     CHECK_ESP_ERROR(iot_button_unregister_cb(_handle, BUTTON_PRESS_UP), "detach press up event fail");
+
+    detachFunctions(BUTTON_PRESS_UP);
 }
 
 /*2. Button Press Repeat*/
@@ -174,6 +355,8 @@ void Button::detachPressRepeatEvent(void)
     }
 
     CHECK_ESP_ERROR(iot_button_unregister_cb(_handle, BUTTON_PRESS_REPEAT), "detach press repeat event fail");
+
+    detachFunctions(BUTTON_PRESS_REPEAT);
 }
 
 /*3. Button Single Click*/
@@ -209,6 +392,8 @@ void Button::detachSingleClickEvent(void)
     }
 
     CHECK_ESP_ERROR(iot_button_unregister_cb(_handle, BUTTON_SINGLE_CLICK), "detach single click event fail");
+
+    detachFunctions(BUTTON_SINGLE_CLICK);
 }
 
 /*4. Button Double Click*/
@@ -244,6 +429,8 @@ void Button::detachDoubleClickEvent(void)
     }
 
     CHECK_ESP_ERROR(iot_button_unregister_cb(_handle, BUTTON_DOUBLE_CLICK), "detach double click event Fail");
+
+    detachFunctions(BUTTON_DOUBLE_CLICK);
 }
 
 /*5. Button Long Press Start*/
@@ -278,6 +465,8 @@ void Button::detachLongPressStartEvent(void)
     }
 
     CHECK_ESP_ERROR(iot_button_unregister_cb(_handle, BUTTON_LONG_PRESS_START), "Detach Callback Fail");
+
+    detachFunctions(BUTTON_LONG_PRESS_START);
 }
 
 /*6. Button Long Press Hold*/
@@ -313,6 +502,8 @@ void Button::detachLongPressHoldEvent(void)
     }
 
     CHECK_ESP_ERROR(iot_button_unregister_cb(_handle, BUTTON_LONG_PRESS_HOLD), "detach long press hold event fail");
+
+    detachFunctions(BUTTON_LONG_PRESS_HOLD);
 }
 
 /*7. Button Press Repeat Done*/
@@ -348,6 +539,8 @@ void Button::detachPressRepeatDoneEvent(void)
     }
 
     CHECK_ESP_ERROR(iot_button_unregister_cb(_handle, BUTTON_PRESS_REPEAT_DONE), "detach press repeat done event fail");
+
+    detachFunctions(BUTTON_PRESS_REPEAT_DONE);
 }
 
 /*8. Button Multiple Clicks*/
@@ -414,6 +607,8 @@ void Button::detachLongPressUpEvent(void)
     }
 
     CHECK_ESP_ERROR(iot_button_unregister_cb(_handle, BUTTON_LONG_PRESS_UP), "detach long press up event Fail");
+
+    detachFunctions(BUTTON_LONG_PRESS_UP);
 }
 
 /*Other Methods*/
@@ -426,9 +621,16 @@ void Button::del(void)
         return;
     }
     CHECK_ESP_ERROR(iot_button_delete(_handle), "delete button fail");
+    detachFunctions(BUTTON_EVENT_MAX);
     _handle = NULL;
 }
 
+// Method to get the handle of the button, NULL if empty or deleted
+button_handle_t Button::getHandle(void) const
+{
+    return _handle;
+}
+
 // Method to count call back
 int Button::countCallBack(void)
 {
@@ -517,3 +719,59 @@ void Button::stop(void)
 {
     CHECK_ESP_ERROR(iot_button_stop(), "button stop fail");
 }
+
+// Method to set the auto-repeat of the long press hold event
+void Button::setHoldConfig(const button_hold_config_t &config)
+{
+    if (!_handle) {
+        ESP_LOGE(TAG, "Button not created");
+        return;
+    } else {
+        CHECK_ESP_ERROR(iot_button_set_hold_config(_handle, &config), "set hold config fail");
+    }
+}
+
+// Method to set several timings at once, taken whole by the scan
+void Button::setTiming(const button_timing_config_t &config)
+{
+    if (!_handle) {
+        ESP_LOGE(TAG, "Button not created");
+        return;
+    } else {
+        CHECK_ESP_ERROR(iot_button_set_timing(_handle, &config), "set timing fail");
+    }
+}
+
+// Method to set the click count reported without waiting the short press window
+void Button::setMaxClicks(uint8_t max_clicks)
+{
+    if (!_handle) {
+        ESP_LOGE(TAG, "Button not created");
+        return;
+    } else {
+        CHECK_ESP_ERROR(iot_button_set_max_clicks(_handle, max_clicks), "set max clicks fail");
+    }
+}
+
+// Method to prepare buttons for sleep
+void Button::enterSleep(button_sleep_mode_t mode)
+{
+    CHECK_ESP_ERROR(iot_button_enter_sleep(mode), "button enter sleep fail");
+}
+
+// Method to restore buttons after wakeup
+void Button::exitSleep(void)
+{
+    CHECK_ESP_ERROR(iot_button_exit_sleep(), "button exit sleep fail");
+}
+
+// Method to push a level to a virtual button
+void Button::injectLevel(uint8_t level, int64_t timestamp)
+{
+    if (!_handle) {
+        ESP_LOGE(TAG, "Button not created");
+        return;
+    } else {
+        CHECK_ESP_ERROR(iot_button_inject_level(_handle, level, timestamp), "button inject level fail");
+    }
+}
@@ -8,18 +8,33 @@
 #define BUTTON_H
 #include "original/iot_button.h"
 #include "original/arduino_config.h"
+#include "ButtonFunction.h"
 
 // Define a function pointer type for callbacks
 typedef void (*callbackFunction)(void *button_handle, void *usr_data);
 
 // Define the Button class
+// A Button owns its handle: it is deleted with the object, moved and never copied
 class Button {
 public:
+    // Constructor for an empty button, constant-initialized in static storage and assigned later
+    constexpr Button() : _button_pin(GPIO_NUM_NC), _handle(NULL) {}
+
     // Constructors for gpio button
     Button(gpio_num_t pin, bool pullup);
 
-    // Constructors for gpio button
-    Button(gpio_num_t pin, bool pullup, uint8_t adc_channel, uint8_t button_index, uint16_t min, uint16_t max);
+    // Constructors for adc button, autoCalibrate learns the voltages of the channel starting from min and max
+    Button(gpio_num_t pin, bool pullup, uint8_t adc_channel, uint8_t button_index, uint16_t min, uint16_t max, bool autoCalibrate = false);
+
+    // Constructors for virtual button, levels are pushed by injectLevel()
+    Button(const button_virtual_config_t &config);
+
+    ~Button();
+    Button(const Button &) = delete;
+    Button &operator=(const Button &) = delete;
+    // The moved-from button is left empty
+    Button(Button &&other) noexcept;
+    Button &operator=(Button &&other) noexcept;
 
     /*Attach Methods*/
     void attachPressDownEventCb(callbackFunction newFunction, void *usr_data);
@@ -34,6 +49,19 @@ public:
     void attachButtonNonePressEventCb(callbackFunction newFunction, void *usr_data);
     void attachMultipleClickEventCb(callbackFunction newFunction, int clicks, void *usr_data);
 
+    /*Attach Methods for callables, e.g. [this](void *button_handle) { ... }, released by detach or delete*/
+    void attachPressDownEventCb(ButtonFunction function);
+    void attachPressUpEventCb(ButtonFunction function);
+    void attachPressRepeatEventCb(ButtonFunction function);
+    void attachSingleClickEventCb(ButtonFunction function);
+    void attachDoubleClickEventCb(ButtonFunction function);
+    void attachLongPressStartEventCb(ButtonFunction function);
+    void attachLongPressHoldEventCb(ButtonFunction function);
+    void attachPressRepeatDoneEventCb(ButtonFunction function);
+    void attachLongPressUpEventCb(ButtonFunction function);
+    void attachButtonNonePressEventCb(ButtonFunction function);
+    void attachMultipleClickEventCb(ButtonFunction function, int clicks);
+
     /*Detach Methods*/
     void detachPressDownEvent(void);
     void detachPressUpEvent(void);
@@ -60,6 +88,7 @@ public:
 
     // Other methods
     void del(void);
+    button_handle_t getHandle(void) const;
     int countCallBack(void);
     int countEvent(button_event_t event);
     int getEvent(void);
@@ -67,10 +96,19 @@ public:
     int getTickTime(void);
     int getLongPressHoldCount(void);
     void setParam(button_param_t param, void *value);
+    void setHoldConfig(const button_hold_config_t &config);
+    void setTiming(const button_timing_config_t &config);
+    void setMaxClicks(uint8_t max_clicks);
     void resume(void);
     void stop(void);
+    void enterSleep(button_sleep_mode_t mode);
+    void exitSleep(void);
+    void injectLevel(uint8_t level, int64_t timestamp = 0);
 
 private:
+    void attachFunction(button_event_config_t config, ButtonFunction &&function);
+    void detachFunctions(button_event_t event);
+
     // Private variables
     gpio_num_t _button_pin;
     button_handle_t _handle;
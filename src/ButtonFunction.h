@@ -0,0 +1,130 @@
+/*
+ * SPDX-FileCopyrightText: 2023-2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef BUTTON_FUNCTION_H
+#define BUTTON_FUNCTION_H
+#include <stddef.h>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include "original/arduino_config.h"
+
+// Callable taking the button handle, e.g. a lambda with captures, stored in place.
+// The captures must fit in CONFIG_BUTTON_CALLBACK_CAPTURE_SIZE bytes, checked at compile time,
+// so it never allocates. The invoker has the signature of a button callback and is registered
+// as is, with the storage as usr_data: a call costs one indirect call, like a function pointer.
+class ButtonFunction {
+public:
+    typedef void (*Invoker)(void *button_handle, void *storage);
+
+    constexpr ButtonFunction() : _invoke(NULL), _ops(NULL), _storage() {}
+
+    template <typename F, typename Fn = typename std::decay<F>::type,
+              typename = typename std::enable_if<!std::is_same<Fn, ButtonFunction>::value>::type>
+    ButtonFunction(F &&f) : _invoke(&invoke<Fn>), _ops(&Ops<Fn>::ops)
+    {
+        static_assert(sizeof(Fn) <= CONFIG_BUTTON_CALLBACK_CAPTURE_SIZE, "captures too large, raise CONFIG_BUTTON_CALLBACK_CAPTURE_SIZE");
+        static_assert(alignof(Fn) <= alignof(max_align_t), "captures over aligned");
+        new (_storage) Fn(std::forward<F>(f));
+    }
+
+    ButtonFunction(ButtonFunction &&other) noexcept : _invoke(other._invoke), _ops(other._ops)
+    {
+        if (_ops) {
+            _ops->move(_storage, other._storage);
+        }
+        other._invoke = NULL;
+        other._ops = NULL;
+    }
+
+    ButtonFunction &operator=(ButtonFunction &&other) noexcept
+    {
+        if (this != &other) {
+            reset();
+            _invoke = other._invoke;
+            _ops = other._ops;
+            if (_ops) {
+                _ops->move(_storage, other._storage);
+            }
+            other._invoke = NULL;
+            other._ops = NULL;
+        }
+        return *this;
+    }
+
+    ButtonFunction(const ButtonFunction &) = delete;
+    ButtonFunction &operator=(const ButtonFunction &) = delete;
+
+    ~ButtonFunction()
+    {
+        reset();
+    }
+
+    // Destroy the callable, the function is left empty
+    void reset(void)
+    {
+        if (_ops) {
+            _ops->destroy(_storage);
+        }
+        _invoke = NULL;
+        _ops = NULL;
+    }
+
+    explicit operator bool() const
+    {
+        return _invoke != NULL;
+    }
+
+    void operator()(void *button_handle)
+    {
+        _invoke(button_handle, _storage);
+    }
+
+    // Callback and usr_data to register, valid as long as the function is not moved or reset
+    Invoker invoker(void) const
+    {
+        return _invoke;
+    }
+    void *storage(void)
+    {
+        return _storage;
+    }
+
+private:
+    struct Operations {
+        void (*move)(void *dst, void *src);
+        void (*destroy)(void *storage);
+    };
+
+    template <typename Fn>
+    struct Ops {
+        static void move(void *dst, void *src)
+        {
+            new (dst) Fn(std::move(*static_cast<Fn *>(src)));
+            static_cast<Fn *>(src)->~Fn();
+        }
+        static void destroy(void *storage)
+        {
+            static_cast<Fn *>(storage)->~Fn();
+        }
+        static constexpr Operations ops = {move, destroy};
+    };
+
+    template <typename Fn>
+    static void invoke(void *button_handle, void *storage)
+    {
+        (*static_cast<Fn *>(storage))(button_handle);
+    }
+
+    Invoker _invoke;
+    const Operations *_ops;
+    alignas(max_align_t) unsigned char _storage[CONFIG_BUTTON_CALLBACK_CAPTURE_SIZE];
+};
+
+template <typename Fn>
+constexpr ButtonFunction::Operations ButtonFunction::Ops<Fn>::ops;
+
+#endif
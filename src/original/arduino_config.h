@@ -10,12 +10,33 @@
 #define CONFIG_ADC_BUTTON_MAX_BUTTON_PER_CHANNEL 8       //range 1 10
 #define CONFIG_ADC_BUTTON_MAX_CHANNEL 3                 // range 1 5
 #define CONFIG_ADC_BUTTON_SAMPLE_TIMES 1                // range 1 4
-#define CONFIG_BUTTON_DEBOUNCE_TICKS 2                  //range  1 8
+#define CONFIG_ADC_BUTTON_CAL_SHIFT 4                   //range  1-8, a learned voltage moves 1/2^n of the way to each reading
+#define CONFIG_ADC_BUTTON_CAL_TRACK_MV 150              //range  20-500, readings further from every learned voltage are not learned
+#define CONFIG_ADC_BUTTON_LADDER_MIN_GAP_MV 60          //range  0-500, ladder key combinations closer than this are logged at init
+#define CONFIG_ADC_BUTTON_IIR_SHIFT 2                   //range  1-6, BUTTON_ADC_FILTER_IIR moves 1/2^n of the way to each reading
+#define CONFIG_ADC_BUTTON_CONTINUOUS 0                  //range  0-1, the ADC converts in the background and the scan only reads the results, needs IDF 5
+#define CONFIG_ADC_BUTTON_CONTINUOUS_FREQ_HZ 20000      //range  611-83333, conversions per second shared by the channels in continuous mode
+#define CONFIG_EXPANDER_BUTTON_MAX_DEVICE 4             //range  1-8, GPIO expanders with buttons
+#define CONFIG_SHIFT_BUTTON_MAX_CHAIN 2                 //range  1-8, shift register chains with buttons
+#define CONFIG_TOUCH_BUTTON_THRESHOLD_PERMILLE 100     //range  10-500, change of a touch pad reading from its baseline that is a touch, in 1/1000
+#define CONFIG_TOUCH_BUTTON_READ_MS 20                 //range  5-200, touch pads are read at least this often, and on a touch interrupt
+#define CONFIG_TOUCH_BUTTON_BASELINE_SHIFT 7           //range  3-10, an untouched baseline moves 1/2^n of the way to each reading
+#define CONFIG_ENCODER_VELOCITY_WINDOW_MS 100          //range  20-1000, BUTTON_ENCODER_VELOCITY is the detents of a window of this length
+#define CONFIG_BUTTON_DEBOUNCE_TICKS 2                  //range  1 255
+#define CONFIG_BUTTON_DEBOUNCE_STABLE_TIME_US 5000      //range  0-50000, used by BUTTON_DEBOUNCE_GPIO_EDGE
 #define CONFIG_BUTTON_SHORT_PRESS_TIME_MS 180           //range  50-800
 #define CONFIG_BUTTON_LONG_PRESS_TIME_MS 1500           //range  500-5000
 #define CONFIG_BUTTON_PERIOD_TIME_MS 5                  // range  2-20
 #define CONFIG_BUTTON_SERIAL_TIME_MS 20                 //range  2-1000
 #define CONFIG_BUTTON_LONG_PRESS_TOLERANCE_MS 20
+#define CONFIG_BUTTON_SLEEP_MAX_RECORD 16               //range  1-64, buttons whose state is kept across sleep
+#define CONFIG_BUTTON_CB_QUEUE_LEN 16                   //range  1-64, queued callback calls per context
+#define CONFIG_BUTTON_CB_TASK_STACK 3072                //range  2048-8192
+#define CONFIG_BUTTON_CB_HIGH_PRIORITY 20               //range  1-24, below the esp_timer task
+#define CONFIG_BUTTON_CB_BACKGROUND_PRIORITY 1          //range  1-24
+#define CONFIG_BUTTON_SCAN_IRAM 0                       //0 or 1, scan from the esp_timer ISR in IRAM, keeps running while the flash cache is off
+#define CONFIG_BUTTON_CALLBACK_CAPTURE_SIZE 16          //range  8-64, bytes of captures of a Button callable
+#define CONFIG_BUTTON_CALLBACK_SLOTS 16                 //range  1-64, Button callables attached at once
 
 #define BUTTON_VER_MINOR  (1)   // ignore this
 #define BUTTON_VER_PATCH  (1)   // ignore this
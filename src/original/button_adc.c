@@ -4,22 +4,29 @@
  */
 
 #include <string.h>
+#include <stdlib.h>
 #include <inttypes.h>
 #include "esp_log.h"
 #include "esp_timer.h"
 #include "esp_idf_version.h"
-#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 0, 0)
 #include "soc/soc_caps.h"
+#include "arduino_config.h"
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 0, 0)
 #include "esp_adc/adc_oneshot.h"
 #include "esp_adc/adc_cali.h"
 #include "esp_adc/adc_cali_scheme.h"
+#if CONFIG_ADC_BUTTON_CONTINUOUS
+#include "esp_adc/adc_continuous.h"
+#endif
+#elif CONFIG_ADC_BUTTON_CONTINUOUS
+#error "CONFIG_ADC_BUTTON_CONTINUOUS needs ESP-IDF 5.0 or later"
 #else
 #include "driver/gpio.h"
 #include "driver/adc.h"
 #include "esp_adc_cal.h"
 #endif
+#include "esp_bit_defs.h"
 #include "button_adc.h"
-#include "arduino_config.h"
 
 
 static const char *TAG = "adc button";
@@ -34,27 +41,69 @@ static const char *TAG = "adc button";
 #define DEFAULT_VREF    1100
 #define NO_OF_SAMPLES   CONFIG_ADC_BUTTON_SAMPLE_TIMES     //Multisampling
 
-#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 0, 0)
+#if CONFIG_ADC_BUTTON_CONTINUOUS
+#define ADC_BUTTON_WIDTH        SOC_ADC_DIGI_MAX_BITWIDTH
+#define ADC1_BUTTON_CHANNEL_MAX SOC_ADC_MAX_CHANNEL_NUM
+#define ADC_BUTTON_ATTEN        ADC_ATTEN_DB_11
+#define ADC_BUTTON_RAW_MAX      (BIT(SOC_ADC_DIGI_MAX_BITWIDTH) - 1)
+#define ADC_BUTTON_FRAME_SIZE   (SOC_ADC_DIGI_DATA_BYTES_PER_CONV * 64)
+#if CONFIG_IDF_TARGET_ESP32 || CONFIG_IDF_TARGET_ESP32S2
+#define ADC_BUTTON_OUTPUT_TYPE  ADC_DIGI_OUTPUT_FORMAT_TYPE1
+#define ADC_BUTTON_GET_CHANNEL(p_data)  ((p_data)->type1.channel)
+#define ADC_BUTTON_GET_DATA(p_data)     ((p_data)->type1.data)
+#else
+#define ADC_BUTTON_OUTPUT_TYPE  ADC_DIGI_OUTPUT_FORMAT_TYPE2
+#define ADC_BUTTON_GET_CHANNEL(p_data)  ((p_data)->type2.channel)
+#define ADC_BUTTON_GET_DATA(p_data)     ((p_data)->type2.data)
+#endif
+#elif ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 0, 0)
 #define ADC_BUTTON_WIDTH        SOC_ADC_RTC_MAX_BITWIDTH
 #define ADC1_BUTTON_CHANNEL_MAX SOC_ADC_MAX_CHANNEL_NUM
 #define ADC_BUTTON_ATTEN        ADC_ATTEN_DB_11
+#define ADC_BUTTON_RAW_MAX      (BIT(SOC_ADC_RTC_MAX_BITWIDTH) - 1)
 #else
 #define ADC_BUTTON_WIDTH        ADC_WIDTH_MAX-1
 #define ADC1_BUTTON_CHANNEL_MAX ADC1_CHANNEL_MAX
 #define ADC_BUTTON_ATTEN        ADC_ATTEN_DB_11
+#define ADC_BUTTON_RAW_MAX      (BIT(SOC_ADC_MAX_BITWIDTH) - 1)
 #endif
 #define ADC_BUTTON_ADC_UNIT     ADC_UNIT_1
 #define ADC_BUTTON_MAX_CHANNEL  CONFIG_ADC_BUTTON_MAX_CHANNEL
 #define ADC_BUTTON_MAX_BUTTON   CONFIG_ADC_BUTTON_MAX_BUTTON_PER_CHANNEL
+#define ADC_BUTTON_CAL_FRAC     4       /**< learned and filtered readings are kept in 1/16 raw code */
+#define ADC_BUTTON_MEDIAN_LEN   5
+#define ADC_BUTTON_NONE         0xff
 
 typedef struct {
     uint16_t min;
     uint16_t max;
+    uint16_t raw_min;    /* first raw code above min */
+    uint16_t raw_max;    /* first raw code above max */
+    uint32_t centroid;   /* learned reading of the button, in 1/16 raw code */
 } button_data_t;
 
+typedef struct {
+    uint16_t bound;      /* voltage in mv while the table is built, then the first raw code of the next combination */
+    uint16_t mask;       /* keys pressed */
+} adc_ladder_entry_t;
+
 typedef struct {
     uint8_t channel;
     uint8_t is_init;
+    uint8_t calibrate;      /* learn the voltages, set by any button of the channel */
+    uint8_t idle_learned;
+    uint8_t pressed;        /* button of the last reading when calibrated, ADC_BUTTON_NONE if idle */
+    uint8_t filter;         /* button_adc_filter_t of the channel */
+    uint8_t samples;        /* readings pushed to the filter since the last decision */
+    uint8_t median_pos;
+    uint8_t primed;         /* the filter holds a reading */
+    uint16_t median[ADC_BUTTON_MEDIAN_LEN];  /* last readings of BUTTON_ADC_FILTER_MEDIAN */
+    uint32_t iir;           /* output of BUTTON_ADC_FILTER_IIR, or the last reading, in 1/16 raw code */
+    uint16_t raw;           /* the last filtered reading */
+    uint32_t idle;          /* learned idle reading, in 1/16 raw code */
+    uint16_t mask;          /* keys of the last reading of a ladder */
+    uint16_t ladder_num;
+    adc_ladder_entry_t *ladder;  /* key combinations of a ladder, by voltage */
     button_data_t btns[ADC_BUTTON_MAX_BUTTON];  /* all button on the channel */
     uint64_t last_time;  /* the last time of adc sample */
 } btn_adc_channel_t;
@@ -64,11 +113,15 @@ typedef struct {
 #if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 0, 0)
     adc_cali_handle_t adc1_cali_handle;
     adc_oneshot_unit_handle_t adc1_handle;
+#if CONFIG_ADC_BUTTON_CONTINUOUS
+    adc_continuous_handle_t adc1_cont_handle;
+#endif
 #else
     esp_adc_cal_characteristics_t adc_chars;
 #endif
     btn_adc_channel_t ch[ADC_BUTTON_MAX_CHANNEL];
     uint8_t ch_num;
+    uint32_t cal_track;     /* CONFIG_ADC_BUTTON_CAL_TRACK_MV in 1/16 raw code */
 } adc_button_t;
 
 static adc_button_t g_button = {0};
@@ -93,6 +146,109 @@ static int find_channel(uint8_t channel)
     return -1;
 }
 
+static uint32_t adc_raw_to_mv(int raw)
+{
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 0, 0)
+    int voltage = 0;
+    adc_cali_raw_to_voltage(g_button.adc1_cali_handle, raw, &voltage);
+    return voltage;
+#else
+    return esp_adc_cal_raw_to_voltage(raw, &g_button.adc_chars);
+#endif
+}
+
+/**
+ * @brief First raw code read at mv or above, ADC_BUTTON_RAW_MAX + 1 if none. Thresholds are
+ *        converted once, so the scan compares raw codes and never runs the calibration.
+ */
+static uint16_t adc_mv_to_raw(uint32_t mv)
+{
+    uint32_t lo = 0;
+    uint32_t hi = ADC_BUTTON_RAW_MAX + 1;
+    while (lo < hi) {
+        uint32_t mid = (lo + hi) / 2;
+        if (adc_raw_to_mv(mid) >= mv) {
+            hi = mid;
+        } else {
+            lo = mid + 1;
+        }
+    }
+    return lo;
+}
+
+static int adc_ladder_compare(const void *a, const void *b)
+{
+    const adc_ladder_entry_t *x = a, *y = b;
+    if (x->bound != y->bound) {
+        return x->bound < y->bound ? -1 : 1;
+    }
+    /**< of the combinations at the same voltage, the one with fewer keys is decoded */
+    return __builtin_popcount(x->mask) - __builtin_popcount(y->mask);
+}
+
+/**
+ * @brief Voltage of every key combination of the ladder, sorted, then each one decoded up to
+ *        the midpoint with the next one.
+ */
+static esp_err_t adc_ladder_build(btn_adc_channel_t *ch, const button_adc_ladder_config_t *config)
+{
+    uint32_t max_pressed = config->max_pressed ? config->max_pressed : config->key_num;
+    uint32_t num = 0;
+    for (uint32_t mask = 0; mask < BIT(config->key_num); mask++) {
+        num += __builtin_popcount(mask) <= max_pressed;
+    }
+    adc_ladder_entry_t *table = calloc(num, sizeof(adc_ladder_entry_t));
+    ADC_BTN_CHECK(NULL != table, "ladder table alloc failed", ESP_ERR_NO_MEM);
+
+    size_t n = 0;
+    for (uint32_t mask = 0; mask < BIT(config->key_num); mask++) {
+        if (__builtin_popcount(mask) > max_pressed) {
+            continue;
+        }
+        /**< V = Vref / (1 + Rpull * (1/R1 + 1/R2 + ...)) */
+        float g = 0;
+        for (int k = 0; k < config->key_num; k++) {
+            if (mask & BIT(k)) {
+                g += (float)config->pull_up_ohm / config->key_ohm[k];
+            }
+        }
+        table[n].bound = (uint16_t)(config->vref_mv / (1 + g) + 0.5f);
+        table[n].mask = mask;
+        n++;
+    }
+    qsort(table, num, sizeof(adc_ladder_entry_t), adc_ladder_compare);
+
+    for (size_t i = 0; i + 1 < num; i++) {
+        uint16_t next = table[i + 1].bound;
+        if (next - table[i].bound < CONFIG_ADC_BUTTON_LADDER_MIN_GAP_MV) {
+            ESP_LOGW(TAG, "ladder keys 0x%x and 0x%x are %d mv apart", table[i].mask, table[i + 1].mask, next - table[i].bound);
+        }
+        /**< the midpoint belongs to this combination */
+        table[i].bound = adc_mv_to_raw(table[i].bound + (next - table[i].bound) / 2 + 1);
+    }
+    table[num - 1].bound = UINT16_MAX;
+
+    ch->ladder = table;
+    ch->ladder_num = num;
+    ch->mask = 0;
+    return ESP_OK;
+}
+
+static uint16_t adc_ladder_decode(const btn_adc_channel_t *ch, uint16_t raw)
+{
+    size_t lo = 0;
+    size_t hi = ch->ladder_num - 1;
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        if (raw < ch->ladder[mid].bound) {
+            hi = mid;
+        } else {
+            lo = mid + 1;
+        }
+    }
+    return ch->ladder[lo].mask;
+}
+
 #if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 0, 0)
 static esp_err_t adc_calibration_init(adc_unit_t unit, adc_atten_t atten, adc_cali_handle_t *out_handle)
 {
@@ -143,16 +299,132 @@ static esp_err_t adc_calibration_init(adc_unit_t unit, adc_atten_t atten, adc_ca
 }
 #endif
 
+static void adc_filter_push(btn_adc_channel_t *ch, uint16_t raw)
+{
+    if (!ch->primed) {
+        /**< the first reading fills the filter, no ramp from 0 */
+        for (size_t i = 0; i < ADC_BUTTON_MEDIAN_LEN; i++) {
+            ch->median[i] = raw;
+        }
+        ch->iir = (uint32_t)raw << ADC_BUTTON_CAL_FRAC;
+        ch->primed = 1;
+    }
+    if (BUTTON_ADC_FILTER_MEDIAN == ch->filter) {
+        ch->median[ch->median_pos] = raw;
+        ch->median_pos = (ch->median_pos + 1) % ADC_BUTTON_MEDIAN_LEN;
+    } else if (BUTTON_ADC_FILTER_IIR == ch->filter) {
+        ch->iir += ((int32_t)((uint32_t)raw << ADC_BUTTON_CAL_FRAC) - (int32_t)ch->iir) >> CONFIG_ADC_BUTTON_IIR_SHIFT;
+    } else {
+        ch->iir = (uint32_t)raw << ADC_BUTTON_CAL_FRAC;
+    }
+    if (ch->samples < UINT8_MAX) {
+        ch->samples++;
+    }
+}
+
+static uint16_t adc_filter_output(const btn_adc_channel_t *ch)
+{
+    if (BUTTON_ADC_FILTER_MEDIAN == ch->filter) {
+        uint16_t sorted[ADC_BUTTON_MEDIAN_LEN];
+        for (size_t i = 0; i < ADC_BUTTON_MEDIAN_LEN; i++) {
+            size_t j = i;
+            for (; j > 0 && sorted[j - 1] > ch->median[i]; j--) {
+                sorted[j] = sorted[j - 1];
+            }
+            sorted[j] = ch->median[i];
+        }
+        return sorted[ADC_BUTTON_MEDIAN_LEN / 2];
+    }
+    return (ch->iir + BIT(ADC_BUTTON_CAL_FRAC - 1)) >> ADC_BUTTON_CAL_FRAC;
+}
+
+#if CONFIG_ADC_BUTTON_CONTINUOUS
+/**
+ * @brief (Re)start the conversions of all the channels in use, after a channel is added or removed
+ */
+static esp_err_t adc_continuous_restart(void)
+{
+    if (g_button.adc1_cont_handle) {
+        adc_continuous_stop(g_button.adc1_cont_handle);
+        adc_continuous_deinit(g_button.adc1_cont_handle);
+        g_button.adc1_cont_handle = NULL;
+    }
+    adc_digi_pattern_config_t pattern[ADC_BUTTON_MAX_CHANNEL] = {0};
+    uint32_t num = 0;
+    for (size_t i = 0; i < ADC_BUTTON_MAX_CHANNEL; i++) {
+        if (g_button.ch[i].is_init) {
+            pattern[num].atten = ADC_BUTTON_ATTEN;
+            pattern[num].channel = g_button.ch[i].channel;
+            pattern[num].unit = ADC_BUTTON_ADC_UNIT;
+            pattern[num].bit_width = ADC_BUTTON_WIDTH;
+            num++;
+        }
+    }
+    if (0 == num) {
+        return ESP_OK;
+    }
+
+    adc_continuous_handle_cfg_t handle_config = {
+        .max_store_buf_size = ADC_BUTTON_FRAME_SIZE * 4,
+        .conv_frame_size = ADC_BUTTON_FRAME_SIZE,
+    };
+    esp_err_t ret = adc_continuous_new_handle(&handle_config, &g_button.adc1_cont_handle);
+    ADC_BTN_CHECK(ret == ESP_OK, "adc continuous new handle fail!", ret);
+    adc_continuous_config_t config = {
+        .pattern_num = num,
+        .adc_pattern = pattern,
+        .sample_freq_hz = CONFIG_ADC_BUTTON_CONTINUOUS_FREQ_HZ,
+        .conv_mode = ADC_CONV_SINGLE_UNIT_1,
+        .format = ADC_BUTTON_OUTPUT_TYPE,
+    };
+    ret = adc_continuous_config(g_button.adc1_cont_handle, &config);
+    if (ret == ESP_OK) {
+        ret = adc_continuous_start(g_button.adc1_cont_handle);
+    }
+    if (ret != ESP_OK) {
+        adc_continuous_deinit(g_button.adc1_cont_handle);
+        g_button.adc1_cont_handle = NULL;
+    }
+    ADC_BTN_CHECK(ret == ESP_OK, "adc continuous start fail!", ret);
+    return ESP_OK;
+}
+
+/**
+ * @brief Feed the conversions done since the last call to the filters, never waits
+ */
+static void adc_continuous_drain(void)
+{
+    uint8_t frame[ADC_BUTTON_FRAME_SIZE];
+    uint32_t len = 0;
+    while (g_button.adc1_cont_handle && ESP_OK == adc_continuous_read(g_button.adc1_cont_handle, frame, sizeof(frame), &len, 0)) {
+        for (uint32_t i = 0; i + SOC_ADC_DIGI_RESULT_BYTES <= len; i += SOC_ADC_DIGI_RESULT_BYTES) {
+            adc_digi_output_data_t *p = (adc_digi_output_data_t *)&frame[i];
+            int ch_index = find_channel(ADC_BUTTON_GET_CHANNEL(p));
+            if (ch_index >= 0 && g_button.ch[ch_index].is_init) {
+                adc_filter_push(&g_button.ch[ch_index], ADC_BUTTON_GET_DATA(p));
+            }
+        }
+    }
+}
+#endif
+
 esp_err_t button_adc_init(const button_adc_config_t *config)
 {
     ADC_BTN_CHECK(NULL != config, "Pointer of config is invalid", ESP_ERR_INVALID_ARG);
     ADC_BTN_CHECK(config->adc_channel < ADC1_BUTTON_CHANNEL_MAX, "channel out of range", ESP_ERR_NOT_SUPPORTED);
     ADC_BTN_CHECK(config->button_index < ADC_BUTTON_MAX_BUTTON, "button_index out of range", ESP_ERR_NOT_SUPPORTED);
-    ADC_BTN_CHECK(config->max > 0, "key max voltage invalid", ESP_ERR_INVALID_ARG);
+    if (config->ladder) {
+        ADC_BTN_CHECK(config->ladder->key_num <= ADC_BUTTON_MAX_BUTTON && config->button_index < config->ladder->key_num, "button_index out of the ladder", ESP_ERR_NOT_SUPPORTED);
+        ADC_BTN_CHECK(NULL != config->ladder->key_ohm && config->ladder->pull_up_ohm > 0 && config->ladder->vref_mv > 0, "ladder config invalid", ESP_ERR_INVALID_ARG);
+    } else {
+        ADC_BTN_CHECK(config->max > 0, "key max voltage invalid", ESP_ERR_INVALID_ARG);
+    }
 
     int ch_index = find_channel(config->adc_channel);
     if (ch_index >= 0) { /**< the channel has been initialized */
         ADC_BTN_CHECK(g_button.ch[ch_index].btns[config->button_index].max == 0, "The button_index has been used", ESP_ERR_INVALID_STATE);
+        ADC_BTN_CHECK(!g_button.ch[ch_index].is_init || (NULL != g_button.ch[ch_index].ladder) == (NULL != config->ladder),
+                      "the channel decodes either voltage windows or a ladder", ESP_ERR_INVALID_STATE);
     } else { /**< this is a new channel */
         int unused_ch_index = find_unused_channel();
         ADC_BTN_CHECK(unused_ch_index >= 0, "exceed max channel number, can't create a new channel", ESP_ERR_INVALID_STATE);
@@ -161,7 +433,11 @@ esp_err_t button_adc_init(const button_adc_config_t *config)
 
     /** initialize adc */
     if (0 == g_button.is_configured) {
-#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 0, 0)
+#if CONFIG_ADC_BUTTON_CONTINUOUS
+        if (NULL != config->adc_handle) {
+            ESP_LOGW(TAG, "the adc_handle is not used, the buttons read the ADC in continuous mode");
+        }
+#elif ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 0, 0)
         esp_err_t ret;
         if (NULL == config->adc_handle) {
             //ADC1 Init
@@ -193,25 +469,58 @@ esp_err_t button_adc_init(const button_adc_config_t *config)
     /** initialize adc channel */
     if (0 == g_button.ch[ch_index].is_init) {
 #if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 0, 0)
+        esp_err_t ret;
+#if !CONFIG_ADC_BUTTON_CONTINUOUS
         //ADC1 Config
         adc_oneshot_chan_cfg_t oneshot_config = {
             .bitwidth = ADC_BUTTON_WIDTH,
             .atten = ADC_BUTTON_ATTEN,
         };
-        esp_err_t ret = adc_oneshot_config_channel(g_button.adc1_handle, config->adc_channel, &oneshot_config);
+        ret = adc_oneshot_config_channel(g_button.adc1_handle, config->adc_channel, &oneshot_config);
         ADC_BTN_CHECK(ret == ESP_OK, "adc oneshot config channel fail!", ESP_FAIL);
+#endif
         //-------------ADC1 Calibration Init---------------//
         ret = adc_calibration_init(ADC_BUTTON_ADC_UNIT, ADC_BUTTON_ATTEN, &g_button.adc1_cali_handle);
         ADC_BTN_CHECK(ret == ESP_OK, "ADC1 Calibration Init False", 0);
 #else
         adc1_config_channel_atten(config->adc_channel, ADC_BUTTON_ATTEN);
 #endif
+        if (config->ladder) {
+            ADC_BTN_CHECK(ESP_OK == adc_ladder_build(&g_button.ch[ch_index], config->ladder), "ladder init failed", ESP_ERR_NO_MEM);
+        }
+        if (0 == g_button.cal_track) {
+            uint32_t full_mv = adc_raw_to_mv(ADC_BUTTON_RAW_MAX);
+            g_button.cal_track = ((uint64_t)CONFIG_ADC_BUTTON_CAL_TRACK_MV * ADC_BUTTON_RAW_MAX << ADC_BUTTON_CAL_FRAC) / (full_mv ? full_mv : 1);
+        }
         g_button.ch[ch_index].channel = config->adc_channel;
         g_button.ch[ch_index].is_init = 1;
+        g_button.ch[ch_index].calibrate = 0;
+        g_button.ch[ch_index].idle_learned = 0;
+        g_button.ch[ch_index].pressed = ADC_BUTTON_NONE;
+        g_button.ch[ch_index].filter = config->filter;
+        g_button.ch[ch_index].samples = 0;
+        g_button.ch[ch_index].median_pos = 0;
+        g_button.ch[ch_index].primed = 0;
         g_button.ch[ch_index].last_time = 0;
+#if CONFIG_ADC_BUTTON_CONTINUOUS
+        ADC_BTN_CHECK(ESP_OK == adc_continuous_restart(), "adc continuous init failed", ESP_FAIL);
+#endif
+    }
+    button_data_t *btn = &g_button.ch[ch_index].btns[config->button_index];
+    if (config->ladder) {
+        /**< the key is decoded from the whole range */
+        btn->max = UINT16_MAX;
+        btn->min = 0;
+    } else {
+        btn->max = config->max;
+        btn->min = config->min;
+        btn->raw_min = adc_mv_to_raw(config->min + 1);
+        btn->raw_max = adc_mv_to_raw(config->max + 1);
+        btn->centroid = (uint32_t)adc_mv_to_raw((config->min + config->max) / 2) << ADC_BUTTON_CAL_FRAC;
+    }
+    if (config->auto_calibrate && !config->ladder) {
+        g_button.ch[ch_index].calibrate = 1;
     }
-    g_button.ch[ch_index].btns[config->button_index].max = config->max;
-    g_button.ch[ch_index].btns[config->button_index].min = config->min;
     g_button.ch_num++;
 
     return ESP_OK;
@@ -238,7 +547,13 @@ esp_err_t button_adc_deinit(uint8_t channel, int button_index)
     if (unused_button == ADC_BUTTON_MAX_BUTTON && g_button.ch[ch_index].is_init) {  /**< if all button is unused, deinit the channel */
         g_button.ch[ch_index].is_init = 0;
         g_button.ch[ch_index].channel = ADC1_BUTTON_CHANNEL_MAX;
+        free(g_button.ch[ch_index].ladder);
+        g_button.ch[ch_index].ladder = NULL;
+        g_button.ch[ch_index].ladder_num = 0;
         ESP_LOGD(TAG, "all button is unused on channel%d, deinit the channel", g_button.ch[ch_index].channel);
+#if CONFIG_ADC_BUTTON_CONTINUOUS
+        adc_continuous_restart();
+#endif
     }
 
     /** check channel usage on the adc*/
@@ -253,14 +568,15 @@ esp_err_t button_adc_deinit(uint8_t channel, int button_index)
         memset(&g_button, 0, sizeof(adc_button_t));
         ESP_LOGD(TAG, "all channel is unused, , deinit adc");
     }
-#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 0, 0)
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 0, 0) && !CONFIG_ADC_BUTTON_CONTINUOUS
     esp_err_t ret = adc_oneshot_del_unit(g_button.adc1_handle);
     ADC_BTN_CHECK(ret == ESP_OK, "adc oneshot deinit fail", ESP_FAIL);
 #endif
     return ESP_OK;
 }
 
-static uint32_t get_adc_volatge(uint8_t channel)
+#if !CONFIG_ADC_BUTTON_CONTINUOUS
+static uint16_t get_adc_raw(uint8_t channel)
 {
     uint32_t adc_reading = 0;
 #if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 0, 0)
@@ -269,27 +585,72 @@ static uint32_t get_adc_volatge(uint8_t channel)
         adc_oneshot_read(g_button.adc1_handle, channel, &adc_raw);
         adc_reading += adc_raw;
     }
-    adc_reading /= NO_OF_SAMPLES;
-    //Convert adc_reading to voltage in mV
-    int voltage = 0;
-    adc_cali_raw_to_voltage(g_button.adc1_cali_handle, adc_reading, &voltage);
-    ESP_LOGV(TAG, "Raw: %"PRIu32"\tVoltage: %dmV", adc_reading, voltage);
 #else
     //Multisampling
     for (int i = 0; i < NO_OF_SAMPLES; i++) {
         adc_reading += adc1_get_raw(channel);
     }
+#endif
     adc_reading /= NO_OF_SAMPLES;
-    //Convert adc_reading to voltage in mV
-    uint32_t voltage = esp_adc_cal_raw_to_voltage(adc_reading, &g_button.adc_chars);
-    ESP_LOGV(TAG, "Raw: %"PRIu32"\tVoltage: %"PRIu32"mV", adc_reading, voltage);
+    ESP_LOGV(TAG, "Raw: %"PRIu32, adc_reading);
+    return adc_reading;
+}
 #endif
-    return voltage;
+
+/**
+ * @brief Nearest learned reading of the channel to a reading, the winner moves towards the reading.
+ *
+ * The idle level is learned from the first reading outside every window. A drift of the idle
+ * level scales the readings of the buttons with it, as the supply of a resistor ladder does,
+ * so a button keeps up with the drift even if it is not pressed for a long time.
+ */
+static uint8_t adc_button_classify(btn_adc_channel_t *ch, uint16_t raw)
+{
+    int32_t v = (int32_t)raw << ADC_BUTTON_CAL_FRAC;
+    if (!ch->idle_learned) {
+        for (size_t i = 0; i < ADC_BUTTON_MAX_BUTTON; i++) {
+            if (ch->btns[i].max && raw >= ch->btns[i].raw_min && raw < ch->btns[i].raw_max) {
+                return i;
+            }
+        }
+        ch->idle = v;
+        ch->idle_learned = 1;
+        return ADC_BUTTON_NONE;
+    }
+
+    uint8_t nearest = ADC_BUTTON_NONE;
+    int32_t best = abs(v - (int32_t)ch->idle);
+    for (size_t i = 0; i < ADC_BUTTON_MAX_BUTTON; i++) {
+        if (ch->btns[i].max) {
+            int32_t d = abs(v - (int32_t)ch->btns[i].centroid);
+            if (d < best) {
+                best = d;
+                nearest = i;
+            }
+        }
+    }
+    /**< a reading in between is a press or a release on its way, not a level to learn */
+    if (best > (int32_t)g_button.cal_track) {
+        return nearest;
+    }
+    if (ADC_BUTTON_NONE != nearest) {
+        ch->btns[nearest].centroid += (v - (int32_t)ch->btns[nearest].centroid) >> CONFIG_ADC_BUTTON_CAL_SHIFT;
+    } else {
+        int32_t step = (v - (int32_t)ch->idle) >> CONFIG_ADC_BUTTON_CAL_SHIFT;
+        if (step && ch->idle) {
+            for (size_t i = 0; i < ADC_BUTTON_MAX_BUTTON; i++) {
+                if (ch->btns[i].max) {
+                    ch->btns[i].centroid += (int64_t)ch->btns[i].centroid * step / (int32_t)ch->idle;
+                }
+            }
+        }
+        ch->idle += step;
+    }
+    return nearest;
 }
 
 uint8_t button_adc_get_key_level(void *button_index)
 {
-    static uint16_t vol = 0;
     uint32_t ch = ADC_BUTTON_SPLIT_CHANNEL(button_index);
     uint32_t index = ADC_BUTTON_SPLIT_INDEX(button_index);
     ADC_BTN_CHECK(ch < ADC1_BUTTON_CHANNEL_MAX, "channel out of range", 0);
@@ -297,15 +658,54 @@ uint8_t button_adc_get_key_level(void *button_index)
     int ch_index = find_channel(ch);
     ADC_BTN_CHECK(ch_index >= 0, "The button_index is not init", 0);
 
+    btn_adc_channel_t *channel = &g_button.ch[ch_index];
     /** It starts only when the elapsed time is more than 1ms */
-    if ((esp_timer_get_time() - g_button.ch[ch_index].last_time) > 1000) {
-        vol = get_adc_volatge(ch);
-        g_button.ch[ch_index].last_time = esp_timer_get_time();
+    if ((esp_timer_get_time() - channel->last_time) > 1000) {
+#if CONFIG_ADC_BUTTON_CONTINUOUS
+        adc_continuous_drain();
+#else
+        adc_filter_push(channel, get_adc_raw(ch));
+#endif
+        channel->last_time = esp_timer_get_time();
+    }
+    if (channel->samples) {
+        channel->samples = 0;
+        channel->raw = adc_filter_output(channel);
+        if (channel->ladder) {
+            channel->mask = adc_ladder_decode(channel, channel->raw);
+        } else if (channel->calibrate) {
+            channel->pressed = adc_button_classify(channel, channel->raw);
+        }
     }
 
-    if (vol <= g_button.ch[ch_index].btns[index].max &&
-            vol > g_button.ch[ch_index].btns[index].min) {
+    if (channel->ladder) {
+        return (channel->mask >> index) & 1;
+    }
+    if (channel->calibrate) {
+        return channel->pressed == index;
+    }
+    if (channel->raw < channel->btns[index].raw_max &&
+            channel->raw >= channel->btns[index].raw_min) {
         return 1;
     }
     return 0;
 }
+
+esp_err_t button_adc_get_calibration(uint8_t channel, int button_index, uint16_t *voltage)
+{
+    ADC_BTN_CHECK(NULL != voltage, "Pointer of voltage is invalid", ESP_ERR_INVALID_ARG);
+    ADC_BTN_CHECK(button_index >= ADC_BUTTON_IDLE_INDEX && button_index < ADC_BUTTON_MAX_BUTTON, "button_index out of range", ESP_ERR_INVALID_ARG);
+    int ch_index = find_channel(channel);
+    ADC_BTN_CHECK(ch_index >= 0, "can't find the channel", ESP_ERR_INVALID_ARG);
+    btn_adc_channel_t *ch = &g_button.ch[ch_index];
+    ADC_BTN_CHECK(ch->calibrate, "the channel is not calibrated", ESP_ERR_INVALID_STATE);
+
+    if (ADC_BUTTON_IDLE_INDEX == button_index) {
+        ADC_BTN_CHECK(ch->idle_learned, "the idle level is not learned yet", ESP_ERR_INVALID_STATE);
+        *voltage = adc_raw_to_mv((ch->idle + BIT(ADC_BUTTON_CAL_FRAC - 1)) >> ADC_BUTTON_CAL_FRAC);
+    } else {
+        ADC_BTN_CHECK(ch->btns[button_index].max, "the button_index is not init", ESP_ERR_INVALID_ARG);
+        *voltage = adc_raw_to_mv((ch->btns[button_index].centroid + BIT(ADC_BUTTON_CAL_FRAC - 1)) >> ADC_BUTTON_CAL_FRAC);
+    }
+    return ESP_OK;
+}
@@ -20,6 +20,31 @@ extern "C" {
 #define ADC_BUTTON_COMBINE(channel, index) ((channel)<<8 | (index))
 #define ADC_BUTTON_SPLIT_INDEX(data) ((uint32_t)(data)&0xff)
 #define ADC_BUTTON_SPLIT_CHANNEL(data) (((uint32_t)(data) >> 8) & 0xff)
+#define ADC_BUTTON_IDLE_INDEX (-1)      /**< button_index of the level with no button pressed, for button_adc_get_calibration */
+
+/**
+ * @brief Resistor ladder of a channel. Each key connects its resistor from the ADC pin to ground
+ *        and the pin is pulled up to vref_mv, so keys pressed together put their resistors in
+ *        parallel and each combination gives its own voltage.
+ *
+ */
+typedef struct {
+    uint16_t vref_mv;                                /**< supply of the pull-up resistor in mv */
+    uint8_t key_num;                                 /**< number of keys, the button_index of each is its position in key_ohm */
+    uint8_t max_pressed;                             /**< most keys pressed at once told apart, 0 for key_num */
+    uint32_t pull_up_ohm;                            /**< pull-up resistor in ohm */
+    const uint32_t *key_ohm;                         /**< resistor of each key in ohm */
+} button_adc_ladder_config_t;
+
+/**
+ * @brief Filter of the readings of a channel
+ *
+ */
+typedef enum {
+    BUTTON_ADC_FILTER_NONE = 0,                      /**< the latest reading */
+    BUTTON_ADC_FILTER_MEDIAN,                        /**< median of the last 5 readings, drops short spikes */
+    BUTTON_ADC_FILTER_IIR,                           /**< low-pass of the readings, 1/2^CONFIG_ADC_BUTTON_IIR_SHIFT of each reading, smooths wide-band noise */
+} button_adc_filter_t;
 
 /**
  * @brief adc button configuration
@@ -30,6 +55,9 @@ typedef struct {
     uint8_t button_index;                            /**< button index on the channel */
     uint16_t min;                                    /**< min voltage in mv corresponding to the button */
     uint16_t max;                                    /**< max voltage in mv corresponding to the button */
+    bool auto_calibrate;                             /**< learn the voltage of each button and of the idle level on the channel, min and max only give the starting point */
+    const button_adc_ladder_config_t *ladder;        /**< decode the channel as a resistor ladder, min and max are unused, the same for all buttons of the channel. NULL for voltage windows */
+    button_adc_filter_t filter;                      /**< filter of the readings, set by the first button of the channel */
 #if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 0, 0)
     adc_oneshot_unit_handle_t *adc_handle;           /**< handle of adc unit, if NULL will create new one internal, else will use the handle */
 #endif
@@ -71,6 +99,20 @@ esp_err_t button_adc_deinit(uint8_t channel, int button_index);
  */
 uint8_t button_adc_get_key_level(void *button_index);
 
+/**
+ * @brief Get a voltage learned by the auto calibration of a channel
+ *
+ * @param channel ADC channel
+ * @param button_index Button index on the channel, or ADC_BUTTON_IDLE_INDEX for the idle level
+ * @param voltage Learned voltage in mv
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG   Arguments is invalid.
+ *      - ESP_ERR_INVALID_STATE The channel is not calibrated, or the idle level is not learned yet.
+ */
+esp_err_t button_adc_get_calibration(uint8_t channel, int button_index, uint16_t *voltage);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,206 @@
+/* SPDX-FileCopyrightText: 2022-2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <string.h>
+#include "esp_log.h"
+#include "esp_attr.h"
+#include "esp_timer.h"
+#include "driver/gpio.h"
+#include "button_debounce.h"
+#ifdef BUTTON_DEBOUNCE_GLITCH_FILTER_SUPPORTED
+#include "driver/gpio_filter.h"
+#endif
+#include "arduino_config.h"
+#include "button_iram.h"
+
+static const char *TAG = "button debounce";
+
+#define DEBOUNCE_BTN_CHECK(a, str, ret_val)                       \
+    if (!(a))                                                     \
+    {                                                             \
+        ESP_LOGE(TAG, "%s(%d): %s", __FUNCTION__, __LINE__, str); \
+        return (ret_val);                                         \
+    }
+
+#define DEBOUNCE_TICKS      CONFIG_BUTTON_DEBOUNCE_TICKS
+#define STABLE_TIME_US      CONFIG_BUTTON_DEBOUNCE_STABLE_TIME_US
+
+static bool g_isr_service_installed = false;
+
+void IRAM_ATTR button_debounce_notify_edge(button_debounce_t *db, int64_t time_us)
+{
+    db->edge_time_us = (uint32_t)time_us;
+}
+
+static void IRAM_ATTR button_debounce_gpio_isr(void *arg)
+{
+    button_debounce_notify_edge((button_debounce_t *)arg, esp_timer_get_time());
+}
+
+static esp_err_t button_debounce_edge_init(button_debounce_t *db)
+{
+    esp_err_t ret;
+    if (!g_isr_service_installed) {
+        ret = gpio_install_isr_service(0);
+        /**< the service may have been installed by the application */
+        DEBOUNCE_BTN_CHECK(ESP_OK == ret || ESP_ERR_INVALID_STATE == ret, "gpio isr service install failed", ESP_FAIL);
+        g_isr_service_installed = true;
+    }
+
+#ifdef BUTTON_DEBOUNCE_GLITCH_FILTER_SUPPORTED
+    gpio_pin_glitch_filter_config_t filter_cfg = {
+        .clk_src = GLITCH_FILTER_CLK_SRC_DEFAULT,
+        .gpio_num = db->gpio_num,
+    };
+    gpio_glitch_filter_handle_t filter = NULL;
+    if (ESP_OK == gpio_new_pin_glitch_filter(&filter_cfg, &filter)) {
+        gpio_glitch_filter_enable(filter);
+        db->glitch_filter = filter;
+    } else {
+        ESP_LOGW(TAG, "No glitch filter for GPIO%d, only the interrupt is used", db->gpio_num);
+    }
+#endif
+
+    gpio_set_intr_type(db->gpio_num, GPIO_INTR_ANYEDGE);
+    ret = gpio_isr_handler_add(db->gpio_num, button_debounce_gpio_isr, db);
+    DEBOUNCE_BTN_CHECK(ESP_OK == ret, "gpio isr handler add failed", ESP_FAIL);
+    gpio_intr_enable(db->gpio_num);
+    return ESP_OK;
+}
+
+esp_err_t button_debounce_init(button_debounce_t *db, button_debounce_type_t type, int gpio_num, uint8_t level)
+{
+    DEBOUNCE_BTN_CHECK(NULL != db, "Pointer of debounce is invalid", ESP_ERR_INVALID_ARG);
+
+    memset(db, 0, sizeof(button_debounce_t));
+    db->level = level;
+    db->active_level = !level;
+    db->ticks[0] = DEBOUNCE_TICKS;
+    db->ticks[1] = DEBOUNCE_TICKS;
+    db->gpio_num = -1;
+    db->type = BUTTON_DEBOUNCE_SOFTWARE;
+    db->edge_time_us = (uint32_t)esp_timer_get_time();
+
+    if (BUTTON_DEBOUNCE_GPIO_EDGE == type) {
+        if (!GPIO_IS_VALID_GPIO(gpio_num)) {
+            ESP_LOGW(TAG, "GPIO edge debounce needs a GPIO button, use software debounce");
+            return ESP_OK;
+        }
+        db->gpio_num = gpio_num;
+        db->type = BUTTON_DEBOUNCE_GPIO_EDGE;
+        esp_err_t ret = button_debounce_edge_init(db);
+        if (ESP_OK != ret) {
+            button_debounce_deinit(db);
+            return ret;
+        }
+    }
+    return ESP_OK;
+}
+
+esp_err_t button_debounce_set_algo(button_debounce_t *db, const button_debounce_config_t *config)
+{
+    DEBOUNCE_BTN_CHECK(NULL != db, "Pointer of debounce is invalid", ESP_ERR_INVALID_ARG);
+    button_debounce_config_t cfg = {0};
+    if (config) {
+        cfg = *config;
+    }
+    uint8_t press_ticks = cfg.press_ticks ? cfg.press_ticks : DEBOUNCE_TICKS;
+    uint8_t release_ticks = cfg.release_ticks ? cfg.release_ticks : DEBOUNCE_TICKS;
+
+    /**< every algorithm is a set of parameters of the same kernel */
+    switch (cfg.algo) {
+    case BUTTON_DEBOUNCE_ALGO_COUNTER:
+        release_ticks = press_ticks;
+        db->decay = 0;
+        break;
+    case BUTTON_DEBOUNCE_ALGO_INTEGRATOR:
+        release_ticks = press_ticks;
+        db->decay = 1;
+        break;
+    case BUTTON_DEBOUNCE_ALGO_ASYMMETRIC:
+        db->decay = 0;
+        break;
+    case BUTTON_DEBOUNCE_ALGO_EAGER:
+        press_ticks = 1;
+        db->decay = 0;
+        break;
+    default:
+        ESP_LOGE(TAG, "Unsupported debounce algorithm");
+        return ESP_ERR_INVALID_ARG;
+    }
+    db->ticks[0] = release_ticks;
+    db->ticks[1] = press_ticks;
+    db->cnt = 0;
+    return ESP_OK;
+}
+
+void button_debounce_deinit(button_debounce_t *db)
+{
+    if (db->gpio_num >= 0) {
+        gpio_intr_disable(db->gpio_num);
+        gpio_isr_handler_remove(db->gpio_num);
+        db->gpio_num = -1;
+    }
+#ifdef BUTTON_DEBOUNCE_GLITCH_FILTER_SUPPORTED
+    if (db->glitch_filter) {
+        gpio_glitch_filter_disable(db->glitch_filter);
+        gpio_del_glitch_filter(db->glitch_filter);
+        db->glitch_filter = NULL;
+    }
+#endif
+    db->type = BUTTON_DEBOUNCE_SOFTWARE;
+}
+
+void button_debounce_suspend(button_debounce_t *db)
+{
+    if (db->gpio_num >= 0) {
+        gpio_intr_disable(db->gpio_num);
+    }
+}
+
+void button_debounce_resume(button_debounce_t *db)
+{
+    if (db->gpio_num >= 0) {
+        /**< gpio_wakeup_enable() made it a level interrupt and gpio_wakeup_disable() cleared it */
+        gpio_set_intr_type(db->gpio_num, GPIO_INTR_ANYEDGE);
+        /**< the edges during sleep were not seen, the level read on wakeup must be stable first */
+        db->edge_time_us = (uint32_t)esp_timer_get_time();
+        gpio_intr_enable(db->gpio_num);
+    }
+}
+
+bool BUTTON_SCAN_ATTR button_debounce_update(button_debounce_t *db, uint8_t raw_level)
+{
+    if (BUTTON_DEBOUNCE_GPIO_EDGE == db->type) {
+        if (raw_level == db->level) {
+            return false;
+        }
+        /**< the interrupt pushes edge_time_us forward on every bounce */
+        uint32_t now = (uint32_t)esp_timer_get_time();
+        if ((uint32_t)(now - db->edge_time_us) < STABLE_TIME_US) {
+            return false;
+        }
+        db->level = raw_level;
+        return true;
+    }
+
+    /**
+     * Branch-free kernel: a differing scan counts up, an agreeing scan restarts the count,
+     * or counts down when decay is set. The level flips when the count reaches the
+     * threshold of the level being entered.
+     */
+    uint32_t diff = (raw_level ^ db->level) & 1;
+    uint32_t cnt = db->cnt;
+    uint32_t thr = db->ticks[(raw_level ^ db->active_level ^ 1) & 1];
+    cnt = diff * (cnt + 1) + (1 - diff) * db->decay * (cnt - (cnt != 0));
+    uint32_t flip = diff & (cnt >= thr);
+    db->level ^= flip;
+    db->cnt = cnt * (1 - flip);
+
+    if (flip) {
+        db->edge_time_us = (uint32_t)esp_timer_get_time();
+    }
+    return flip;
+}
@@ -0,0 +1,141 @@
+/* SPDX-FileCopyrightText: 2022-2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "esp_idf_version.h"
+#include "soc/soc_caps.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if SOC_GPIO_SUPPORT_PIN_GLITCH_FILTER && ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 1, 0)
+#define BUTTON_DEBOUNCE_GLITCH_FILTER_SUPPORTED 1
+#endif
+
+/**
+ * @brief Debounce backend
+ *
+ */
+typedef enum {
+    BUTTON_DEBOUNCE_SOFTWARE = 0,   /**< scanned levels are filtered by the selected button_debounce_algo_t */
+    BUTTON_DEBOUNCE_GPIO_EDGE,      /**< edges are timestamped by the GPIO interrupt (and glitch filter if supported),
+                                         level is accepted once stable for CONFIG_BUTTON_DEBOUNCE_STABLE_TIME_US. GPIO buttons only */
+} button_debounce_type_t;
+
+/**
+ * @brief Debounce algorithm of the software backend
+ *
+ */
+typedef enum {
+    BUTTON_DEBOUNCE_ALGO_COUNTER = 0,   /**< level must differ for N consecutive scans, any agreeing scan restarts the count */
+    BUTTON_DEBOUNCE_ALGO_INTEGRATOR,    /**< differing scans count up, agreeing scans count down, tolerates sparse noise */
+    BUTTON_DEBOUNCE_ALGO_ASYMMETRIC,    /**< counter with separate press_ticks and release_ticks */
+    BUTTON_DEBOUNCE_ALGO_EAGER,         /**< press is accepted on the first scan, release after release_ticks */
+} button_debounce_algo_t;
+
+/**
+ * @brief Debounce algorithm configuration
+ *
+ */
+typedef struct {
+    button_debounce_algo_t algo;        /**< debounce algorithm, default BUTTON_DEBOUNCE_ALGO_COUNTER */
+    uint8_t press_ticks;                /**< scans to accept a press, if 0 default to CONFIG_BUTTON_DEBOUNCE_TICKS. Used by INTEGRATOR, COUNTER and ASYMMETRIC */
+    uint8_t release_ticks;              /**< scans to accept a release, if 0 default to CONFIG_BUTTON_DEBOUNCE_TICKS. Used by ASYMMETRIC and EAGER */
+} button_debounce_config_t;
+
+/**
+ * @brief Debounce state of one button
+ *
+ */
+typedef struct {
+    uint8_t             type: 1;        /*! button_debounce_type_t*/
+    uint8_t             level: 1;       /*! Debounced level*/
+    uint8_t             active_level: 1;
+    uint8_t             decay: 1;       /*! Agreeing scans count down instead of restarting the count*/
+    uint8_t             cnt;            /*! Count towards a level change, software backend*/
+    uint8_t             ticks[2];       /*! Scans to accept a release [0] and a press [1]*/
+    int8_t              gpio_num;       /*! GPIO with edge interrupt, -1 if none*/
+    volatile uint32_t   edge_time_us;   /*! Time of the last edge, low 32 bits of esp_timer_get_time()*/
+#ifdef BUTTON_DEBOUNCE_GLITCH_FILTER_SUPPORTED
+    void                *glitch_filter;
+#endif
+} button_debounce_t;
+
+/**
+ * @brief Initialize the debounce state of a button
+ *
+ * @param db pointer of debounce state
+ * @param type debounce backend, BUTTON_DEBOUNCE_GPIO_EDGE falls back to BUTTON_DEBOUNCE_SOFTWARE if gpio_num is invalid
+ * @param gpio_num GPIO of the button, -1 if the button is not a GPIO button
+ * @param level initial debounced level, the button is released at init so the other level is the active level
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG   Arguments is invalid.
+ *      - ESP_FAIL              GPIO interrupt install failed.
+ */
+esp_err_t button_debounce_init(button_debounce_t *db, button_debounce_type_t type, int gpio_num, uint8_t level);
+
+/**
+ * @brief Select the algorithm of the software backend. The edge backend keeps its stable time.
+ *
+ * @param db pointer of debounce state
+ * @param config pointer of algorithm configuration, NULL for the default counter
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG   Arguments is invalid.
+ */
+esp_err_t button_debounce_set_algo(button_debounce_t *db, const button_debounce_config_t *config);
+
+/**
+ * @brief Release the interrupt and glitch filter used by the debounce state
+ *
+ * @param db pointer of debounce state
+ */
+void button_debounce_deinit(button_debounce_t *db);
+
+/**
+ * @brief Disable the edge interrupt of BUTTON_DEBOUNCE_GPIO_EDGE before the GPIO is made a wakeup source,
+ *        which turns it into a level interrupt. Does nothing for the software backend.
+ *
+ * @param db pointer of debounce state
+ */
+void button_debounce_suspend(button_debounce_t *db);
+
+/**
+ * @brief Restore the edge interrupt of BUTTON_DEBOUNCE_GPIO_EDGE after gpio_wakeup_disable()
+ *
+ * @param db pointer of debounce state
+ */
+void button_debounce_resume(button_debounce_t *db);
+
+/**
+ * @brief Feed a raw level sampled by the scan
+ *
+ * @param db pointer of debounce state
+ * @param raw_level level read from the button hal
+ *
+ * @return true if the debounced level changed, the new level is db->level and the time of the edge is db->edge_time_us
+ */
+bool button_debounce_update(button_debounce_t *db, uint8_t raw_level);
+
+/**
+ * @brief Report an edge of the raw level. Called from the GPIO interrupt of BUTTON_DEBOUNCE_GPIO_EDGE,
+ *        it can also be called by other edge sources or by tests to feed recorded edges.
+ *
+ * @param db pointer of debounce state
+ * @param time_us time of the edge, see esp_timer_get_time()
+ */
+void button_debounce_notify_edge(button_debounce_t *db, int64_t time_us);
+
+#ifdef __cplusplus
+}
+#endif
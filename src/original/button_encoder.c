@@ -0,0 +1,120 @@
+/* SPDX-FileCopyrightText: 2022-2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <stdlib.h>
+#include "esp_log.h"
+#include "driver/gpio.h"
+#include "arduino_config.h"
+#include "button_iram.h"
+#include "button_gpio.h"
+#include "button_encoder.h"
+
+static const char *TAG = "encoder button";
+
+#define ENCODER_BTN_CHECK(a, str, ret_val)                        \
+    if (!(a))                                                     \
+    {                                                             \
+        ESP_LOGE(TAG, "%s(%d): %s", __FUNCTION__, __LINE__, str); \
+        return (ret_val);                                         \
+    }
+
+#define ENCODER_SKIP            2   /**< both outputs changed between two scans */
+#define ENCODER_WINDOW_TICKS    (CONFIG_ENCODER_VELOCITY_WINDOW_MS / CONFIG_BUTTON_PERIOD_TIME_MS > 0 ? CONFIG_ENCODER_VELOCITY_WINDOW_MS / CONFIG_BUTTON_PERIOD_TIME_MS : 1)
+
+/**
+ * Transition of the outputs, indexed by last << 2 | current with A in bit 0 and B in bit 1.
+ * A leading B goes 00, 01, 11, 10: +1 per transition.
+ */
+static const DRAM_ATTR int8_t s_encoder_table[16] = {
+    0, 1, -1, ENCODER_SKIP,
+    -1, 0, ENCODER_SKIP, 1,
+    1, ENCODER_SKIP, 0, -1,
+    ENCODER_SKIP, -1, 1, 0,
+};
+
+static inline uint8_t BUTTON_SCAN_ATTR encoder_ab(const button_encoder_t *encoder, uint64_t levels)
+{
+    return ((levels >> encoder->gpio_a) & 1) | (((levels >> encoder->gpio_b) & 1) << 1);
+}
+
+esp_err_t button_encoder_init(const button_encoder_config_t *config, button_encoder_t **encoder)
+{
+    ENCODER_BTN_CHECK(NULL != config && NULL != encoder, "Pointer of config is invalid", ESP_ERR_INVALID_ARG);
+    ENCODER_BTN_CHECK(GPIO_IS_VALID_GPIO(config->gpio_a) && GPIO_IS_VALID_GPIO(config->gpio_b) && config->gpio_a != config->gpio_b,
+                      "GPIO number error", ESP_ERR_INVALID_ARG);
+    uint8_t per_detent = config->steps_per_detent ? config->steps_per_detent : 4;
+    ENCODER_BTN_CHECK(1 == per_detent || 2 == per_detent || 4 == per_detent, "steps_per_detent is not 1, 2 or 4", ESP_ERR_INVALID_ARG);
+
+    button_encoder_t *enc = calloc(1, sizeof(button_encoder_t));
+    ENCODER_BTN_CHECK(NULL != enc, "encoder alloc failed", ESP_ERR_NO_MEM);
+    esp_err_t ret = button_gpio_init_mask((1ULL << config->gpio_a) | (1ULL << config->gpio_b), 0);
+    if (ESP_OK != ret) {
+        free(enc);
+        ESP_LOGE(TAG, "encoder gpio init failed");
+        return ret;
+    }
+    enc->gpio_a = config->gpio_a;
+    enc->gpio_b = config->gpio_b;
+    enc->per_detent = per_detent;
+    enc->reverse = config->reverse;
+    /**< the detents are counted from the position at init */
+    enc->ab = encoder_ab(enc, button_gpio_snapshot());
+    *encoder = enc;
+    return ESP_OK;
+}
+
+esp_err_t button_encoder_deinit(button_encoder_t *encoder)
+{
+    ENCODER_BTN_CHECK(NULL != encoder, "Pointer of encoder is invalid", ESP_ERR_INVALID_ARG);
+    gpio_reset_pin(encoder->gpio_a);
+    gpio_reset_pin(encoder->gpio_b);
+    free(encoder);
+    return ESP_OK;
+}
+
+uint8_t BUTTON_SCAN_ATTR button_encoder_scan(button_encoder_t *encoder, uint64_t levels)
+{
+    uint8_t report = 0;
+    uint8_t ab = encoder_ab(encoder, levels);
+    int8_t move = s_encoder_table[encoder->ab << 2 | ab];
+    encoder->ab = ab;
+    encoder->steps = 0;
+    if (ENCODER_SKIP == move) {
+        /**< a transition was missed between two scans, the turn most likely goes on the same way */
+        move = 2 * encoder->dir;
+    } else if (move) {
+        encoder->dir = move;
+    }
+    if (move) {
+        encoder->acc += move;
+        /**< back on a detent, a bounce around it adds up to 0 */
+        if (0 == encoder->acc % encoder->per_detent) {
+            int16_t steps = encoder->acc / encoder->per_detent;
+            encoder->acc = 0;
+            if (steps) {
+                encoder->steps = encoder->reverse ? -steps : steps;
+                encoder->position += encoder->steps;
+                encoder->window_steps += encoder->steps;
+                report |= BUTTON_ENCODER_REPORT_STEP;
+            }
+        }
+    }
+
+    /**< the window runs while the encoder turns, and ends once more with a velocity of 0 */
+    if (encoder->window_steps || encoder->velocity) {
+        if (++encoder->window_ticks >= ENCODER_WINDOW_TICKS) {
+            encoder->velocity = (int32_t)encoder->window_steps * 1000 / (ENCODER_WINDOW_TICKS * CONFIG_BUTTON_PERIOD_TIME_MS);
+            encoder->window_steps = 0;
+            encoder->window_ticks = 0;
+            report |= BUTTON_ENCODER_REPORT_VELOCITY;
+        }
+    }
+    return report;
+}
+
+uint8_t BUTTON_SCAN_ATTR button_encoder_get_key_level(void *encoder)
+{
+    return 0;
+}
@@ -0,0 +1,93 @@
+/* SPDX-FileCopyrightText: 2022-2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BUTTON_ENCODER_REPORT_STEP      (1 << 0)    /**< button_encoder_scan(): the encoder moved by steps detents */
+#define BUTTON_ENCODER_REPORT_VELOCITY  (1 << 1)    /**< button_encoder_scan(): a velocity window ended */
+
+/**
+ * @brief Rotary encoder configuration. The encoder switches to ground, the GPIOs are pulled up.
+ *
+ */
+typedef struct {
+    int32_t gpio_a;                 /**< A output of the encoder, CLK on most modules */
+    int32_t gpio_b;                 /**< B output of the encoder, DT on most modules */
+    uint8_t steps_per_detent;       /**< quadrature transitions per detent: 4, 2 or 1. 0 for 4 */
+    uint8_t reverse;                /**< swap the direction, positive is A leading B otherwise */
+} button_encoder_config_t;
+
+/**
+ * @brief State of an encoder, read by the scan for the events
+ *
+ */
+typedef struct {
+    int32_t gpio_a;
+    int32_t gpio_b;
+    int32_t position;               /**< detents since init, A leading B is positive */
+    int16_t steps;                  /**< detents of the last scan */
+    int16_t velocity;               /**< detents per second over the last CONFIG_ENCODER_VELOCITY_WINDOW_MS */
+    int16_t window_steps;           /**< detents of the current velocity window */
+    uint16_t window_ticks;          /**< scans of the current velocity window */
+    uint8_t ab;                     /**< last levels, A in bit 0 and B in bit 1 */
+    uint8_t per_detent;
+    int8_t acc;                     /**< transitions since the last detent */
+    int8_t dir;                     /**< direction of the last transition, for a skipped one */
+    uint8_t reverse;
+} button_encoder_t;
+
+/**
+ * @brief Initialize a rotary encoder, it must rest on a detent
+ *
+ * @param config pointer of configuration struct
+ * @param encoder state of the encoder, for button_encoder_scan
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG   Arguments is invalid.
+ *      - ESP_ERR_NO_MEM        No memory
+ */
+esp_err_t button_encoder_init(const button_encoder_config_t *config, button_encoder_t **encoder);
+
+/**
+ * @brief Deinitialize a rotary encoder
+ *
+ * @param encoder state of the encoder
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG   Arguments is invalid.
+ */
+esp_err_t button_encoder_deinit(button_encoder_t *encoder);
+
+/**
+ * @brief Decode the levels of a scan
+ *
+ * @param encoder state of the encoder
+ * @param levels levels of all the GPIOs, bit n for GPIO n, see button_gpio_snapshot()
+ *
+ * @return BUTTON_ENCODER_REPORT_STEP and BUTTON_ENCODER_REPORT_VELOCITY bits, steps and velocity are updated
+ */
+uint8_t button_encoder_scan(button_encoder_t *encoder, uint64_t levels);
+
+/**
+ * @brief Level of an encoder for the press state machine, never pressed
+ *
+ * @param encoder state of the encoder
+ *
+ * @return 0
+ */
+uint8_t button_encoder_get_key_level(void *encoder);
+
+#ifdef __cplusplus
+}
+#endif
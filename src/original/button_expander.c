@@ -0,0 +1,141 @@
+/* SPDX-FileCopyrightText: 2022-2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <string.h>
+#include "esp_log.h"
+#include "driver/gpio.h"
+#include "esp_bit_defs.h"
+#include "arduino_config.h"
+#include "button_expander.h"
+#include "button_scan.h"
+
+static const char *TAG = "expander button";
+
+#define EXPANDER_BTN_CHECK(a, str, ret_val)                       \
+    if (!(a))                                                     \
+    {                                                             \
+        ESP_LOGE(TAG, "%s(%d): %s", __FUNCTION__, __LINE__, str); \
+        return (ret_val);                                         \
+    }
+
+#define EXPANDER_MAX_DEVICE     CONFIG_EXPANDER_BUTTON_MAX_DEVICE
+#define EXPANDER_MAX_BYTES      4
+
+typedef struct {
+    button_expander_bus_config_t bus;
+    uint32_t port;          /* ports of the last read */
+    uint32_t pins;          /* pins with a button */
+    uint32_t epoch;         /* scan pass of the last read check */
+} expander_device_t;
+
+static expander_device_t g_device[EXPANDER_MAX_DEVICE] = {0};
+
+static bool expander_same_bus(const button_expander_bus_config_t *a, const button_expander_bus_config_t *b)
+{
+    return a->read == b->read && a->bus_ctx == b->bus_ctx && a->input_reg == b->input_reg;
+}
+
+static esp_err_t expander_read(expander_device_t *dev)
+{
+    uint8_t data[EXPANDER_MAX_BYTES] = {0};
+    esp_err_t ret = dev->bus.read(dev->bus.bus_ctx, dev->bus.input_reg, data, dev->bus.port_bytes);
+    if (ESP_OK != ret) {
+        /**< the buttons keep the last levels, the read is tried again on the next scan */
+        return ret;
+    }
+    uint32_t port = 0;
+    for (int i = 0; i < dev->bus.port_bytes; i++) {
+        port |= (uint32_t)data[i] << (8 * i);
+    }
+    dev->port = port;
+    return ESP_OK;
+}
+
+static bool expander_int_shared(int index)
+{
+    for (int i = 0; i < EXPANDER_MAX_DEVICE; i++) {
+        if (i != index && g_device[i].pins && g_device[i].bus.int_gpio == g_device[index].bus.int_gpio) {
+            return true;
+        }
+    }
+    return false;
+}
+
+esp_err_t button_expander_init(const button_expander_config_t *config, void **hardware_data)
+{
+    EXPANDER_BTN_CHECK(NULL != config && NULL != hardware_data, "Pointer of config is invalid", ESP_ERR_INVALID_ARG);
+    const button_expander_bus_config_t *bus = config->bus;
+    EXPANDER_BTN_CHECK(NULL != bus && NULL != bus->read, "expander bus is invalid", ESP_ERR_INVALID_ARG);
+    EXPANDER_BTN_CHECK(bus->port_bytes > 0 && bus->port_bytes <= EXPANDER_MAX_BYTES, "port_bytes out of range", ESP_ERR_INVALID_ARG);
+    EXPANDER_BTN_CHECK(config->pin < 8 * bus->port_bytes, "pin out of range", ESP_ERR_INVALID_ARG);
+    EXPANDER_BTN_CHECK(bus->int_gpio < 0 || GPIO_IS_VALID_GPIO(bus->int_gpio), "INT GPIO number error", ESP_ERR_INVALID_ARG);
+
+    int index = -1;
+    for (int i = 0; i < EXPANDER_MAX_DEVICE; i++) {
+        if (g_device[i].pins && expander_same_bus(&g_device[i].bus, bus)) {
+            index = i;
+            break;
+        }
+    }
+    if (index >= 0) { /**< the expander has been initialized */
+        EXPANDER_BTN_CHECK(!(g_device[index].pins & BIT(config->pin)), "The pin has been used", ESP_ERR_INVALID_STATE);
+        EXPANDER_BTN_CHECK(g_device[index].bus.port_bytes == bus->port_bytes && g_device[index].bus.int_gpio == bus->int_gpio,
+                           "the buttons of an expander need the same bus config", ESP_ERR_INVALID_ARG);
+    } else { /**< this is a new expander */
+        for (int i = 0; i < EXPANDER_MAX_DEVICE; i++) {
+            if (0 == g_device[i].pins) {
+                index = i;
+                break;
+            }
+        }
+        EXPANDER_BTN_CHECK(index >= 0, "exceed max expander number, can't add a new expander", ESP_ERR_NO_MEM);
+        expander_device_t *dev = &g_device[index];
+        memset(dev, 0, sizeof(expander_device_t));
+        dev->bus = *bus;
+        EXPANDER_BTN_CHECK(ESP_OK == expander_read(dev), "expander read failed", ESP_FAIL);
+        if (bus->int_gpio >= 0) {
+            /**< INT is open drain on most expanders, it may be wired to several of them */
+            gpio_config_t gpio_conf = {
+                .pin_bit_mask = (1ULL << bus->int_gpio),
+                .mode = GPIO_MODE_INPUT,
+                .pull_up_en = GPIO_PULLUP_ENABLE,
+                .pull_down_en = GPIO_PULLDOWN_DISABLE,
+                .intr_type = GPIO_INTR_DISABLE,
+            };
+            gpio_config(&gpio_conf);
+        }
+        dev->epoch = button_scan_epoch();
+    }
+    g_device[index].pins |= BIT(config->pin);
+    *hardware_data = (void *)EXPANDER_BUTTON_COMBINE(index, config->pin);
+    return ESP_OK;
+}
+
+esp_err_t button_expander_deinit(void *hardware_data)
+{
+    uint32_t index = EXPANDER_BUTTON_SPLIT_DEVICE(hardware_data);
+    uint32_t pin = EXPANDER_BUTTON_SPLIT_PIN(hardware_data);
+    EXPANDER_BTN_CHECK(index < EXPANDER_MAX_DEVICE && (g_device[index].pins & BIT(pin)), "The button is not init", ESP_ERR_INVALID_ARG);
+
+    g_device[index].pins &= ~BIT(pin);
+    if (0 == g_device[index].pins && g_device[index].bus.int_gpio >= 0 && !expander_int_shared(index)) {
+        gpio_reset_pin(g_device[index].bus.int_gpio);
+    }
+    return ESP_OK;
+}
+
+uint8_t button_expander_get_key_level(void *hardware_data)
+{
+    expander_device_t *dev = &g_device[EXPANDER_BUTTON_SPLIT_DEVICE(hardware_data)];
+    /** one read for all the buttons of the expander in a scan pass */
+    uint32_t epoch = button_scan_epoch();
+    if (epoch != dev->epoch) {
+        dev->epoch = epoch;
+        if (dev->bus.int_gpio < 0 || 0 == gpio_get_level(dev->bus.int_gpio)) {
+            expander_read(dev);
+        }
+    }
+    return (dev->port >> EXPANDER_BUTTON_SPLIT_PIN(hardware_data)) & 1;
+}
@@ -0,0 +1,85 @@
+/* SPDX-FileCopyrightText: 2022-2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define EXPANDER_BUTTON_COMBINE(device, pin) ((device)<<8 | (pin))
+#define EXPANDER_BUTTON_SPLIT_PIN(data) ((uint32_t)(data)&0xff)
+#define EXPANDER_BUTTON_SPLIT_DEVICE(data) (((uint32_t)(data) >> 8) & 0xff)
+
+/**
+ * @brief GPIO expander, e.g. MCP23017 or PCA9555 on I2C, MCP23S17 on SPI. All its input ports
+ *        are read in one bus transaction per scan, shared by the buttons on it.
+ *
+ *        The expander is set up by the application, pins as inputs and, with int_gpio, the
+ *        interrupt on change enabled.
+ */
+typedef struct {
+    esp_err_t (*read)(void *bus_ctx, uint8_t reg, uint8_t *data, size_t len);  /**< read len bytes from register reg on, in one transaction */
+    void *bus_ctx;                   /**< passed to read, e.g. the i2c_master_dev_handle_t of the expander */
+    uint8_t input_reg;               /**< first input port register, 0x12 (GPIOA) on MCP23017, 0x00 on PCA9555 */
+    uint8_t port_bytes;              /**< bytes of input ports read, 1 to 4 */
+    int32_t int_gpio;                /**< GPIO of the active low INT output, the ports are only read while it is asserted. -1 to read on every scan */
+} button_expander_bus_config_t;
+
+/**
+ * @brief Expander button configuration
+ *
+ */
+typedef struct {
+    const button_expander_bus_config_t *bus;  /**< expander of the button, the buttons with the same read, bus_ctx and input_reg share it */
+    uint8_t pin;                              /**< bit of the button in the ports read, bit 0 of the first byte is pin 0 */
+    uint8_t active_level;                     /**< level of the pin when pressed */
+} button_expander_config_t;
+
+/**
+ * @brief Initialize an expander button, the expander is read once when its first button is added
+ *
+ * @param config pointer of configuration struct
+ * @param hardware_data device and pin of the button, for button_expander_get_key_level
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG   Arguments is invalid.
+ *      - ESP_ERR_INVALID_STATE The pin is already used
+ *      - ESP_ERR_NO_MEM        No free device, see CONFIG_EXPANDER_BUTTON_MAX_DEVICE
+ *      - ESP_FAIL              The expander could not be read
+ */
+esp_err_t button_expander_init(const button_expander_config_t *config, void **hardware_data);
+
+/**
+ * @brief Deinitialize an expander button, the expander is released with its last button
+ *
+ * @param hardware_data device and pin of the button
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG   Arguments is invalid.
+ */
+esp_err_t button_expander_deinit(void *hardware_data);
+
+/**
+ * @brief Get the level of a button from the ports of its expander
+ *
+ * @param hardware_data device and pin of the button
+ *
+ * @return level
+ *
+ * @note The ports are read at most once per scan period, the other buttons of the expander
+ *       use the value read.
+ */
+uint8_t button_expander_get_key_level(void *hardware_data);
+
+#ifdef __cplusplus
+}
+#endif
@@ -6,6 +6,13 @@
 #include "esp_log.h"
 #include "driver/gpio.h"
 #include "button_gpio.h"
+#include "button_iram.h"
+#include "soc/soc.h"
+#include "soc/soc_caps.h"
+#include "soc/gpio_reg.h"
+#if CONFIG_BUTTON_SCAN_IRAM
+#include "hal/gpio_ll.h"
+#endif
 
 static const char *TAG = "gpio button";
 
@@ -21,20 +28,25 @@ esp_err_t button_gpio_init(const button_gpio_config_t *config)
     GPIO_BTN_CHECK(NULL != config, "Pointer of config is invalid", ESP_ERR_INVALID_ARG);
     GPIO_BTN_CHECK(GPIO_IS_VALID_GPIO(config->gpio_num), "GPIO number error", ESP_ERR_INVALID_ARG);
 
+    return button_gpio_init_mask(1ULL << config->gpio_num, config->active_level);
+}
+
+esp_err_t button_gpio_init_mask(uint64_t pin_bit_mask, uint8_t active_level)
+{
+    GPIO_BTN_CHECK(0 != pin_bit_mask, "GPIO mask is empty", ESP_ERR_INVALID_ARG);
+
     gpio_config_t gpio_conf;
     gpio_conf.intr_type = GPIO_INTR_DISABLE;
     gpio_conf.mode = GPIO_MODE_INPUT;
-    gpio_conf.pin_bit_mask = (1ULL << config->gpio_num);
-    if (config->active_level) {
+    gpio_conf.pin_bit_mask = pin_bit_mask;
+    if (active_level) {
         gpio_conf.pull_down_en = GPIO_PULLDOWN_ENABLE;
         gpio_conf.pull_up_en = GPIO_PULLUP_DISABLE;
     } else {
         gpio_conf.pull_down_en = GPIO_PULLDOWN_DISABLE;
         gpio_conf.pull_up_en = GPIO_PULLUP_ENABLE;
     }
-    gpio_config(&gpio_conf);
-
-    return ESP_OK;
+    return gpio_config(&gpio_conf);
 }
 
 esp_err_t button_gpio_deinit(int gpio_num)
@@ -42,7 +54,22 @@ esp_err_t button_gpio_deinit(int gpio_num)
     return gpio_reset_pin(gpio_num);;
 }
 
-uint8_t button_gpio_get_key_level(void *gpio_num)
+uint8_t BUTTON_SCAN_ATTR button_gpio_get_key_level(void *gpio_num)
 {
+#if CONFIG_BUTTON_SCAN_IRAM
+    /**< gpio_get_level() is in flash */
+    return (uint8_t)gpio_ll_get_level(&GPIO, (uint32_t)gpio_num);
+#else
     return (uint8_t)gpio_get_level((uint32_t)gpio_num);
+#endif
+}
+
+uint64_t BUTTON_SCAN_ATTR button_gpio_snapshot(void)
+{
+    /**< one read of the input registers, instead of one call per pin */
+    uint64_t levels = REG_READ(GPIO_IN_REG);
+#if SOC_GPIO_PIN_COUNT > 32
+    levels |= (uint64_t)REG_READ(GPIO_IN1_REG) << 32;
+#endif
+    return levels;
 }
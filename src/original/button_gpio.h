@@ -6,6 +6,7 @@
 #pragma once
 
 #include "driver/gpio.h"
+#include "button_debounce.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -18,6 +19,7 @@ extern "C" {
 typedef struct {
     int32_t gpio_num;              /**< num of gpio */
     uint8_t active_level;          /**< gpio level when press down */
+    button_debounce_type_t debounce;    /**< debounce backend, default BUTTON_DEBOUNCE_SOFTWARE */
 } button_gpio_config_t;
 
 /**
@@ -31,6 +33,18 @@ typedef struct {
  */
 esp_err_t button_gpio_init(const button_gpio_config_t *config);
 
+/**
+ * @brief Initialize several gpio buttons with the same active level in one gpio_config() call
+ * 
+ * @param pin_bit_mask bit mask of the gpio of the buttons
+ * @param active_level gpio level when press down
+ * 
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG   pin_bit_mask is empty or invalid.
+ */
+esp_err_t button_gpio_init_mask(uint64_t pin_bit_mask, uint8_t active_level);
+
 /**
  * @brief Deinitialize gpio button
  * 
@@ -49,6 +63,13 @@ esp_err_t button_gpio_deinit(int gpio_num);
  */
 uint8_t button_gpio_get_key_level(void *gpio_num);
 
+/**
+ * @brief Get the levels of all the gpio at once, for the inputs decoded from several gpio
+ *
+ * @return Levels, bit n for gpio n
+ */
+uint64_t button_gpio_snapshot(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,22 @@
+/* SPDX-FileCopyrightText: 2022-2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include "esp_attr.h"
+#include "arduino_config.h"
+
+/**
+ * @brief Placement of the scan path, private to the component.
+ *
+ * With CONFIG_BUTTON_SCAN_IRAM the scan runs from the esp_timer interrupt and every function
+ * it reaches is placed in IRAM, so the buttons keep being scanned while the flash cache is
+ * disabled. Switches are compiled without jump tables, which would be placed in flash.
+ */
+#if CONFIG_BUTTON_SCAN_IRAM
+#define BUTTON_SCAN_ATTR    IRAM_ATTR __attribute__((optimize("no-jump-tables")))
+#else
+#define BUTTON_SCAN_ATTR
+#endif
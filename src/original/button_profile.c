@@ -0,0 +1,145 @@
+/* SPDX-FileCopyrightText: 2022-2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <string.h>
+#include "esp_log.h"
+#include "arduino_config.h"
+#include "button_profile.h"
+
+static const char *TAG = "button profile";
+
+#define PROFILE_CHECK(a, str, ret_val)                            \
+    if (!(a))                                                     \
+    {                                                             \
+        ESP_LOGE(TAG, "%s(%d): %s", __FUNCTION__, __LINE__, str); \
+        return (ret_val);                                         \
+    }
+
+static uint16_t get_u16(const uint8_t *p)
+{
+    return p[0] | p[1] << 8;
+}
+
+static uint32_t get_u32(const uint8_t *p)
+{
+    return get_u16(p) | (uint32_t)get_u16(p + 2) << 16;
+}
+
+static void put_u16(uint8_t *p, uint16_t value)
+{
+    p[0] = value;
+    p[1] = value >> 8;
+}
+
+static void put_u32(uint8_t *p, uint32_t value)
+{
+    put_u16(p, value);
+    put_u16(p + 2, value >> 16);
+}
+
+/**< CRC-32 of zlib, without a table: a profile is checked once at startup */
+static uint32_t profile_crc32(const uint8_t *data, size_t len)
+{
+    uint32_t crc = 0xffffffff;
+    for (size_t i = 0; i < len; i++) {
+        crc ^= data[i];
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc >> 1) ^ (0xedb88320 & -(crc & 1));
+        }
+    }
+    return ~crc;
+}
+
+size_t button_profile_size(const void *header)
+{
+    const uint8_t *p = (const uint8_t *)header;
+    if (BUTTON_PROFILE_MAGIC != get_u32(p) || p[5] < BUTTON_PROFILE_ENTRY_SIZE) {
+        return 0;
+    }
+    return BUTTON_PROFILE_HEADER_SIZE + (size_t)p[5] * get_u16(p + 6);
+}
+
+static void profile_decode(const uint8_t *p, button_profile_entry_t *entry)
+{
+    entry->target = p[0];
+    entry->debounce_ticks = p[1];
+    entry->index = get_u16(p + 2);
+    entry->short_press_ms = get_u16(p + 4);
+    entry->long_press_ms = get_u16(p + 6);
+    entry->serial_ms = get_u16(p + 8);
+    entry->tolerance_ms = get_u16(p + 10);
+}
+
+void button_profile_get_entry(const void *data, uint16_t index, button_profile_entry_t *entry)
+{
+    const uint8_t *p = (const uint8_t *)data;
+    profile_decode(p + BUTTON_PROFILE_HEADER_SIZE + (size_t)p[5] * index, entry);
+}
+
+esp_err_t button_profile_check(const void *data, size_t len, uint16_t *entry_num)
+{
+    PROFILE_CHECK(NULL != data, "Pointer of profile is invalid", ESP_ERR_INVALID_ARG);
+    PROFILE_CHECK(len >= BUTTON_PROFILE_HEADER_SIZE, "profile is truncated", ESP_ERR_INVALID_SIZE);
+    const uint8_t *p = (const uint8_t *)data;
+    PROFILE_CHECK(BUTTON_PROFILE_MAGIC == get_u32(p), "not a button profile", ESP_ERR_INVALID_VERSION);
+    PROFILE_CHECK(BUTTON_PROFILE_VERSION == p[4] && p[5] >= BUTTON_PROFILE_ENTRY_SIZE, "unsupported profile version", ESP_ERR_INVALID_VERSION);
+    size_t size = button_profile_size(p);
+    PROFILE_CHECK(len >= size, "profile is truncated", ESP_ERR_INVALID_SIZE);
+    PROFILE_CHECK(get_u32(p + 8) == profile_crc32(p + BUTTON_PROFILE_HEADER_SIZE, size - BUTTON_PROFILE_HEADER_SIZE),
+                  "profile crc error", ESP_ERR_INVALID_CRC);
+
+    uint16_t num = get_u16(p + 6);
+    for (uint16_t i = 0; i < num; i++) {
+        button_profile_entry_t entry;
+        button_profile_get_entry(p, i, &entry);
+        if (entry.target >= BUTTON_PROFILE_TARGET_MAX) {
+            ESP_LOGE(TAG, "entry %u: invalid target %u", i, entry.target);
+            return ESP_ERR_INVALID_STATE;
+        }
+        /**< the same limits as the timings of a button_config_t */
+        if ((entry.short_press_ms && entry.short_press_ms < CONFIG_BUTTON_PERIOD_TIME_MS) ||
+                (entry.long_press_ms && entry.long_press_ms < CONFIG_BUTTON_PERIOD_TIME_MS) ||
+                (entry.serial_ms && entry.serial_ms < CONFIG_BUTTON_PERIOD_TIME_MS)) {
+            ESP_LOGE(TAG, "entry %u: a time is shorter than the scan period", i);
+            return ESP_ERR_INVALID_STATE;
+        }
+        if (entry.short_press_ms && entry.long_press_ms && entry.short_press_ms >= entry.long_press_ms) {
+            ESP_LOGE(TAG, "entry %u: short press time is not less than long press time", i);
+            return ESP_ERR_INVALID_STATE;
+        }
+    }
+    if (entry_num) {
+        *entry_num = num;
+    }
+    return ESP_OK;
+}
+
+size_t button_profile_pack(const button_profile_entry_t *entries, uint16_t entry_num, uint8_t *out, size_t size)
+{
+    size_t len = BUTTON_PROFILE_HEADER_SIZE + (size_t)BUTTON_PROFILE_ENTRY_SIZE * entry_num;
+    if (NULL == out) {
+        return len;
+    }
+    if (size < len || (entry_num && NULL == entries)) {
+        return 0;
+    }
+    memset(out, 0, len);
+    put_u32(out, BUTTON_PROFILE_MAGIC);
+    out[4] = BUTTON_PROFILE_VERSION;
+    out[5] = BUTTON_PROFILE_ENTRY_SIZE;
+    put_u16(out + 6, entry_num);
+    for (uint16_t i = 0; i < entry_num; i++) {
+        uint8_t *p = out + BUTTON_PROFILE_HEADER_SIZE + BUTTON_PROFILE_ENTRY_SIZE * i;
+        p[0] = entries[i].target;
+        p[1] = entries[i].debounce_ticks;
+        put_u16(p + 2, entries[i].index);
+        put_u16(p + 4, entries[i].short_press_ms);
+        put_u16(p + 6, entries[i].long_press_ms);
+        put_u16(p + 8, entries[i].serial_ms);
+        put_u16(p + 10, entries[i].tolerance_ms);
+    }
+    put_u32(out + 8, profile_crc32(out + BUTTON_PROFILE_HEADER_SIZE, len - BUTTON_PROFILE_HEADER_SIZE));
+    return len;
+}
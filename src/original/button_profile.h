@@ -0,0 +1,105 @@
+/* SPDX-FileCopyrightText: 2022-2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Binary timing profile, little endian:
+ *
+ *   header  magic "BTNP" (u32), version (u8), entry_size (u8), entry_num (u16), crc32 of the entries (u32)
+ *   entry   target (u8), debounce_ticks (u8), index (u16), short_press_ms, long_press_ms, serial_ms, tolerance_ms (u16)
+ *
+ * A value of 0 keeps the timing of the button. Entries are applied in order, so an entry for
+ * all the buttons is usually first and the entries of single buttons last. A later version may
+ * grow entry_size, the fields above stay at their offsets.
+ */
+#define BUTTON_PROFILE_MAGIC        0x504e5442      /**< "BTNP" */
+#define BUTTON_PROFILE_VERSION      1
+#define BUTTON_PROFILE_HEADER_SIZE  12
+#define BUTTON_PROFILE_ENTRY_SIZE   12
+
+/**
+ * @brief Buttons an entry applies to
+ *
+ */
+typedef enum {
+    BUTTON_PROFILE_ALL = 0,         /**< every button, index is unused */
+    BUTTON_PROFILE_GROUP,           /**< the buttons of groups[index] of button_profile_targets_t */
+    BUTTON_PROFILE_BUTTON,          /**< buttons[index] of button_profile_targets_t */
+    BUTTON_PROFILE_TARGET_MAX,
+} button_profile_target_t;
+
+/**
+ * @brief Timing of one entry, 0 keeps the value of the button
+ *
+ */
+typedef struct {
+    uint8_t target;                 /**< button_profile_target_t */
+    uint8_t debounce_ticks;         /**< scans to accept a press and a release, see CONFIG_BUTTON_DEBOUNCE_TICKS */
+    uint16_t index;                 /**< group or button of the entry */
+    uint16_t short_press_ms;        /**< see CONFIG_BUTTON_SHORT_PRESS_TIME_MS */
+    uint16_t long_press_ms;         /**< see CONFIG_BUTTON_LONG_PRESS_TIME_MS */
+    uint16_t serial_ms;             /**< see CONFIG_BUTTON_SERIAL_TIME_MS, also sets a fixed BUTTON_LONG_PRESS_HOLD rate */
+    uint16_t tolerance_ms;          /**< see CONFIG_BUTTON_LONG_PRESS_TOLERANCE_MS */
+} button_profile_entry_t;
+
+/**
+ * @brief Check a profile: header, size, crc and the values of every entry
+ *
+ * @param data profile
+ * @param len bytes of data, may be more than the profile, e.g. a whole partition
+ * @param entry_num entries of the profile, can be NULL
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG     Arguments is invalid.
+ *      - ESP_ERR_INVALID_SIZE    The profile is truncated
+ *      - ESP_ERR_INVALID_VERSION Not a profile or an unsupported version
+ *      - ESP_ERR_INVALID_CRC     The crc does not match
+ *      - ESP_ERR_INVALID_STATE   An entry has an invalid target or timing
+ */
+esp_err_t button_profile_check(const void *data, size_t len, uint16_t *entry_num);
+
+/**
+ * @brief Size of a profile from its header, for a loader reading the header first
+ *
+ * @param header BUTTON_PROFILE_HEADER_SIZE bytes of the profile
+ *
+ * @return bytes of the profile, 0 if the header is not a profile
+ */
+size_t button_profile_size(const void *header);
+
+/**
+ * @brief Get an entry of a checked profile
+ *
+ * @param data profile checked by button_profile_check()
+ * @param index entry, less than entry_num
+ * @param entry decoded entry
+ */
+void button_profile_get_entry(const void *data, uint16_t index, button_profile_entry_t *entry);
+
+/**
+ * @brief Pack entries into a profile
+ *
+ * @param entries entries of the profile
+ * @param entry_num number of entries
+ * @param out buffer of the profile, can be NULL to get the size
+ * @param size bytes of out
+ *
+ * @return bytes of the profile, 0 if out is too small
+ */
+size_t button_profile_pack(const button_profile_entry_t *entries, uint16_t entry_num, uint8_t *out, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
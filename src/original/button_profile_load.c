@@ -0,0 +1,88 @@
+/* SPDX-FileCopyrightText: 2022-2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <stdlib.h>
+#include "esp_log.h"
+#include "esp_idf_version.h"
+#include "esp_partition.h"
+#include "nvs.h"
+#include "iot_button.h"
+
+static const char *TAG = "button profile";
+
+#define PROFILE_CHECK(a, str, ret_val)                            \
+    if (!(a))                                                     \
+    {                                                             \
+        ESP_LOGE(TAG, "%s(%d): %s", __FUNCTION__, __LINE__, str); \
+        return (ret_val);                                         \
+    }
+
+esp_err_t iot_button_load_profile_nvs(const char *namespace_name, const char *key, const button_profile_targets_t *targets)
+{
+    PROFILE_CHECK(NULL != namespace_name && NULL != key, "Pointer of key is invalid", ESP_ERR_INVALID_ARG);
+    nvs_handle_t nvs;
+    esp_err_t ret = nvs_open(namespace_name, NVS_READONLY, &nvs);
+    if (ESP_OK != ret) {
+        ESP_LOGE(TAG, "open namespace %s failed: %s", namespace_name, esp_err_to_name(ret));
+        return ret;
+    }
+    size_t len = 0;
+    ret = nvs_get_blob(nvs, key, NULL, &len);
+    if (ESP_OK != ret) {
+        nvs_close(nvs);
+        ESP_LOGE(TAG, "profile %s not found: %s", key, esp_err_to_name(ret));
+        return ret;
+    }
+    void *profile = malloc(len);
+    if (NULL == profile) {
+        nvs_close(nvs);
+        ESP_LOGE(TAG, "profile alloc failed");
+        return ESP_ERR_NO_MEM;
+    }
+    ret = nvs_get_blob(nvs, key, profile, &len);
+    nvs_close(nvs);
+    if (ESP_OK == ret) {
+        ret = iot_button_apply_profile(profile, len, targets);
+    }
+    free(profile);
+    return ret;
+}
+
+esp_err_t iot_button_load_profile_partition(const char *label, const button_profile_targets_t *targets)
+{
+    PROFILE_CHECK(NULL != label, "Pointer of label is invalid", ESP_ERR_INVALID_ARG);
+    const esp_partition_t *partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, label);
+    PROFILE_CHECK(NULL != partition, "profile partition not found", ESP_ERR_NOT_FOUND);
+
+    /**< the header gives the size to map, an erased partition is not a profile */
+    uint8_t header[BUTTON_PROFILE_HEADER_SIZE];
+    esp_err_t ret = esp_partition_read(partition, 0, header, sizeof(header));
+    if (ESP_OK != ret) {
+        return ret;
+    }
+    size_t len = button_profile_size(header);
+    PROFILE_CHECK(len && len <= partition->size, "partition does not hold a button profile", ESP_ERR_INVALID_VERSION);
+
+    const void *profile;
+    /**< before 5.1 the partition mmap is the one of spi_flash */
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 1, 0)
+    esp_partition_mmap_handle_t map;
+    ret = esp_partition_mmap(partition, 0, len, ESP_PARTITION_MMAP_DATA, &profile, &map);
+#else
+    spi_flash_mmap_handle_t map;
+    ret = esp_partition_mmap(partition, 0, len, SPI_FLASH_MMAP_DATA, &profile, &map);
+#endif
+    if (ESP_OK != ret) {
+        ESP_LOGE(TAG, "profile mmap failed: %s", esp_err_to_name(ret));
+        return ret;
+    }
+    ret = iot_button_apply_profile(profile, len, targets);
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 1, 0)
+    esp_partition_munmap(map);
+#else
+    spi_flash_munmap(map);
+#endif
+    return ret;
+}
@@ -0,0 +1,28 @@
+/* SPDX-FileCopyrightText: 2022-2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Number of the current pass of the scan over the buttons, private to the component.
+ *
+ * The scan bumps it once at the start of each pass. The buttons of a device read on a shared
+ * bus keep the epoch of the last read and read the bus again only in a new pass, so a pass
+ * makes one bus read per device whatever the number of its buttons and the scan timing.
+ * Outside the scan the levels of the last read are returned.
+ *
+ * @return Epoch of the current pass, wraps around
+ */
+uint32_t button_scan_epoch(void);
+
+#ifdef __cplusplus
+}
+#endif
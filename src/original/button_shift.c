@@ -0,0 +1,198 @@
+/* SPDX-FileCopyrightText: 2022-2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+#include "driver/gpio.h"
+#include "arduino_config.h"
+#include "button_shift.h"
+#include "button_scan.h"
+
+static const char *TAG = "shift button";
+
+#define SHIFT_BTN_CHECK(a, str, ret_val)                          \
+    if (!(a))                                                     \
+    {                                                             \
+        ESP_LOGE(TAG, "%s(%d): %s", __FUNCTION__, __LINE__, str); \
+        return (ret_val);                                         \
+    }
+
+#define SHIFT_MAX_CHAIN     CONFIG_SHIFT_BUTTON_MAX_CHAIN
+
+typedef struct {
+    button_shift_chain_config_t cfg;
+    uint8_t *rx;            /* buffer of the transfer, DMA capable */
+    uint8_t *inputs;        /* inputs of the last read */
+    uint8_t *used;          /* pins with a button */
+    uint16_t btn_num;
+    uint32_t epoch;         /* scan pass of the last read */
+} shift_chain_t;
+
+static shift_chain_t g_chain[SHIFT_MAX_CHAIN] = {0};
+
+static bool shift_same_chain(const button_shift_chain_config_t *a, const button_shift_chain_config_t *b)
+{
+    return a->read == b->read && a->ctx == b->ctx && a->spi == b->spi && a->load_gpio == b->load_gpio;
+}
+
+static esp_err_t shift_transfer(shift_chain_t *chain)
+{
+    const button_shift_chain_config_t *cfg = &chain->cfg;
+    if (cfg->read) {
+        return cfg->read(cfg->ctx, chain->rx, cfg->chain_len);
+    }
+    /**< SH/LD low loads the inputs, high shifts them, H of the register next to us first */
+    gpio_set_level(cfg->load_gpio, 0);
+    gpio_set_level(cfg->load_gpio, 1);
+    if (cfg->spi) {
+        spi_transaction_t t = {
+            .length = 8 * cfg->chain_len,
+            .rxlength = 8 * cfg->chain_len,
+            .rx_buffer = chain->rx,
+        };
+        return spi_device_polling_transmit(cfg->spi, &t);
+    }
+    for (size_t i = 0; i < cfg->chain_len; i++) {
+        uint8_t byte = 0;
+        for (int bit = 7; bit >= 0; bit--) {
+            byte |= (gpio_get_level(cfg->data_gpio) ? 1 : 0) << bit;
+            gpio_set_level(cfg->clk_gpio, 1);
+            gpio_set_level(cfg->clk_gpio, 0);
+        }
+        chain->rx[i] = byte;
+    }
+    return ESP_OK;
+}
+
+static esp_err_t shift_read(shift_chain_t *chain)
+{
+    esp_err_t ret = shift_transfer(chain);
+    if (ESP_OK == ret) {
+        /**< the buttons keep the last levels if a transfer fails, it is tried again on the next scan */
+        memcpy(chain->inputs, chain->rx, chain->cfg.chain_len);
+    }
+    return ret;
+}
+
+static void shift_release(shift_chain_t *chain)
+{
+    if (NULL == chain->cfg.read) {
+        gpio_reset_pin(chain->cfg.load_gpio);
+        if (NULL == chain->cfg.spi) {
+            gpio_reset_pin(chain->cfg.clk_gpio);
+            gpio_reset_pin(chain->cfg.data_gpio);
+        }
+    }
+    heap_caps_free(chain->rx);
+    free(chain->inputs);
+    free(chain->used);
+    memset(chain, 0, sizeof(shift_chain_t));
+}
+
+static esp_err_t shift_chain_init(shift_chain_t *chain, const button_shift_chain_config_t *cfg)
+{
+    chain->cfg = *cfg;
+    /**< whole words, for DMA */
+    chain->rx = heap_caps_calloc(1, (cfg->chain_len + 3) & ~3, MALLOC_CAP_DMA);
+    chain->inputs = calloc(1, cfg->chain_len);
+    chain->used = calloc(1, cfg->chain_len);
+    if (NULL == chain->rx || NULL == chain->inputs || NULL == chain->used) {
+        ESP_LOGE(TAG, "chain buffer alloc failed");
+        shift_release(chain);
+        return ESP_ERR_NO_MEM;
+    }
+    if (NULL == cfg->read) {
+        gpio_config_t gpio_conf = {0};
+        gpio_conf.intr_type = GPIO_INTR_DISABLE;
+        gpio_conf.mode = GPIO_MODE_OUTPUT;
+        gpio_conf.pin_bit_mask = (1ULL << cfg->load_gpio);
+        if (NULL == cfg->spi) {
+            gpio_conf.pin_bit_mask |= (1ULL << cfg->clk_gpio);
+        }
+        gpio_config(&gpio_conf);
+        gpio_set_level(cfg->load_gpio, 1);
+        if (NULL == cfg->spi) {
+            gpio_set_level(cfg->clk_gpio, 0);
+            gpio_conf.mode = GPIO_MODE_INPUT;
+            gpio_conf.pin_bit_mask = (1ULL << cfg->data_gpio);
+            gpio_config(&gpio_conf);
+        }
+    }
+    if (ESP_OK != shift_read(chain)) {
+        ESP_LOGE(TAG, "chain read failed");
+        shift_release(chain);
+        return ESP_FAIL;
+    }
+    chain->epoch = button_scan_epoch();
+    return ESP_OK;
+}
+
+esp_err_t button_shift_init(const button_shift_config_t *config, void **hardware_data)
+{
+    SHIFT_BTN_CHECK(NULL != config && NULL != hardware_data, "Pointer of config is invalid", ESP_ERR_INVALID_ARG);
+    const button_shift_chain_config_t *cfg = config->chain;
+    SHIFT_BTN_CHECK(NULL != cfg && cfg->chain_len > 0 && cfg->chain_len <= UINT16_MAX / 8, "chain config is invalid", ESP_ERR_INVALID_ARG);
+    SHIFT_BTN_CHECK(config->pin < 8 * cfg->chain_len, "pin out of range", ESP_ERR_INVALID_ARG);
+    if (NULL == cfg->read) {
+        SHIFT_BTN_CHECK(GPIO_IS_VALID_GPIO(cfg->load_gpio), "load GPIO number error", ESP_ERR_INVALID_ARG);
+        SHIFT_BTN_CHECK(cfg->spi || (GPIO_IS_VALID_GPIO(cfg->clk_gpio) && GPIO_IS_VALID_GPIO(cfg->data_gpio)), "clk or data GPIO number error", ESP_ERR_INVALID_ARG);
+    }
+
+    int index = -1;
+    for (int i = 0; i < SHIFT_MAX_CHAIN; i++) {
+        if (g_chain[i].btn_num && shift_same_chain(&g_chain[i].cfg, cfg)) {
+            index = i;
+            break;
+        }
+    }
+    if (index >= 0) { /**< the chain has been initialized */
+        SHIFT_BTN_CHECK(g_chain[index].cfg.chain_len == cfg->chain_len, "the buttons of a chain need the same chain_len", ESP_ERR_INVALID_ARG);
+        SHIFT_BTN_CHECK(!(g_chain[index].used[config->pin / 8] & (1 << (config->pin % 8))), "The pin has been used", ESP_ERR_INVALID_STATE);
+    } else { /**< this is a new chain */
+        for (int i = 0; i < SHIFT_MAX_CHAIN; i++) {
+            if (0 == g_chain[i].btn_num) {
+                index = i;
+                break;
+            }
+        }
+        SHIFT_BTN_CHECK(index >= 0, "exceed max chain number, can't add a new chain", ESP_ERR_NO_MEM);
+        esp_err_t ret = shift_chain_init(&g_chain[index], cfg);
+        SHIFT_BTN_CHECK(ESP_OK == ret, "chain init failed", ret);
+    }
+    g_chain[index].used[config->pin / 8] |= 1 << (config->pin % 8);
+    g_chain[index].btn_num++;
+    *hardware_data = (void *)SHIFT_BUTTON_COMBINE(index, config->pin);
+    return ESP_OK;
+}
+
+esp_err_t button_shift_deinit(void *hardware_data)
+{
+    uint32_t index = SHIFT_BUTTON_SPLIT_CHAIN(hardware_data);
+    uint32_t pin = SHIFT_BUTTON_SPLIT_PIN(hardware_data);
+    SHIFT_BTN_CHECK(index < SHIFT_MAX_CHAIN && g_chain[index].btn_num && pin < 8 * g_chain[index].cfg.chain_len &&
+                    (g_chain[index].used[pin / 8] & (1 << (pin % 8))), "The button is not init", ESP_ERR_INVALID_ARG);
+
+    shift_chain_t *chain = &g_chain[index];
+    chain->used[pin / 8] &= ~(1 << (pin % 8));
+    if (0 == --chain->btn_num) {
+        shift_release(chain);
+    }
+    return ESP_OK;
+}
+
+uint8_t button_shift_get_key_level(void *hardware_data)
+{
+    shift_chain_t *chain = &g_chain[SHIFT_BUTTON_SPLIT_CHAIN(hardware_data)];
+    uint32_t pin = SHIFT_BUTTON_SPLIT_PIN(hardware_data);
+    /** one transfer for all the buttons of the chain in a scan pass */
+    uint32_t epoch = button_scan_epoch();
+    if (epoch != chain->epoch) {
+        chain->epoch = epoch;
+        shift_read(chain);
+    }
+    return (chain->inputs[pin / 8] >> (pin % 8)) & 1;
+}
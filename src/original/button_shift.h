@@ -0,0 +1,89 @@
+/* SPDX-FileCopyrightText: 2022-2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "driver/spi_master.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SHIFT_BUTTON_COMBINE(chain, pin) ((chain)<<16 | (pin))
+#define SHIFT_BUTTON_SPLIT_PIN(data) ((uint32_t)(data)&0xffff)
+#define SHIFT_BUTTON_SPLIT_CHAIN(data) (((uint32_t)(data) >> 16) & 0xff)
+
+/**
+ * @brief Chain of parallel-in shift registers, e.g. 74HC165, with the QH output of each register
+ *        to the SER input of the previous one. The whole chain is latched and shifted in once
+ *        per scan, shared by the buttons on it.
+ *
+ *        Byte 0 is the register next to the microcontroller, the first one shifted in. In each
+ *        byte, input A is bit 0 and input H, shifted in first, is bit 7.
+ */
+typedef struct {
+    esp_err_t (*read)(void *ctx, uint8_t *data, size_t len);  /**< latch the inputs and shift in len bytes, e.g. a mock on a host. NULL for the built-in transport */
+    void *ctx;                       /**< passed to read */
+    spi_device_handle_t spi;         /**< built-in transport: SPI device of the chain, mode 0, MISO to QH. DMA is used if the bus has a DMA channel. NULL to bit-bang clk_gpio and data_gpio */
+    int32_t load_gpio;               /**< built-in transport: SH/LD of the chain, pulsed low to latch the inputs */
+    int32_t clk_gpio;                /**< built-in transport without spi: CLK of the chain */
+    int32_t data_gpio;               /**< built-in transport without spi: QH of the register next to the microcontroller */
+    uint16_t chain_len;              /**< registers in the chain, 8 inputs each */
+} button_shift_chain_config_t;
+
+/**
+ * @brief Shift register button configuration
+ *
+ */
+typedef struct {
+    const button_shift_chain_config_t *chain;  /**< chain of the button, the buttons with the same read, ctx, spi and load_gpio share it */
+    uint16_t pin;                              /**< input of the button, 8 * register + input, see button_shift_chain_config_t */
+    uint8_t active_level;                      /**< level of the input when pressed */
+} button_shift_config_t;
+
+/**
+ * @brief Initialize a shift register button, the chain is set up and read when its first button is added
+ *
+ * @param config pointer of configuration struct
+ * @param hardware_data chain and pin of the button, for button_shift_get_key_level
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG   Arguments is invalid.
+ *      - ESP_ERR_INVALID_STATE The pin is already used
+ *      - ESP_ERR_NO_MEM        No free chain, see CONFIG_SHIFT_BUTTON_MAX_CHAIN, or no memory
+ *      - ESP_FAIL              The chain could not be read
+ */
+esp_err_t button_shift_init(const button_shift_config_t *config, void **hardware_data);
+
+/**
+ * @brief Deinitialize a shift register button, the chain is released with its last button
+ *
+ * @param hardware_data chain and pin of the button
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG   Arguments is invalid.
+ */
+esp_err_t button_shift_deinit(void *hardware_data);
+
+/**
+ * @brief Get the level of a button from the inputs of its chain
+ *
+ * @param hardware_data chain and pin of the button
+ *
+ * @return level
+ *
+ * @note The chain is read at most once per scan period, the other buttons of the chain
+ *       use the inputs read.
+ */
+uint8_t button_shift_get_key_level(void *hardware_data);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,314 @@
+/* SPDX-FileCopyrightText: 2022-2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <string.h>
+#include <inttypes.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "soc/soc_caps.h"
+#include "arduino_config.h"
+#include "button_touch.h"
+
+#if defined(SOC_TOUCH_SENSOR_VERSION)
+#define TOUCH_BUTTON_VERSION SOC_TOUCH_SENSOR_VERSION
+#elif defined(SOC_TOUCH_VERSION_1)
+#define TOUCH_BUTTON_VERSION 1
+#elif defined(SOC_TOUCH_VERSION_2)
+#define TOUCH_BUTTON_VERSION 2
+#else
+#define TOUCH_BUTTON_VERSION 0
+#endif
+
+#if TOUCH_BUTTON_VERSION == 1 || TOUCH_BUTTON_VERSION == 2
+#include "driver/touch_pad.h"
+#define TOUCH_BUTTON_SUPPORTED 1
+#else
+#define TOUCH_BUTTON_SUPPORTED 0
+#endif
+
+static const char *TAG = "touch button";
+
+#define TOUCH_BTN_CHECK(a, str, ret_val)                          \
+    if (!(a))                                                     \
+    {                                                             \
+        ESP_LOGE(TAG, "%s(%d): %s", __FUNCTION__, __LINE__, str); \
+        return (ret_val);                                         \
+    }
+
+#define TOUCH_BASELINE_FRAC     4   /**< the baseline is kept in 1/16 of a reading */
+#define TOUCH_BASELINE_FAST     2   /**< shift of a baseline following a reading further from a touch */
+#define TOUCH_READ_US           (CONFIG_TOUCH_BUTTON_READ_MS * 1000)
+
+void button_touch_tracker_init(button_touch_tracker_t *tracker, uint16_t threshold_permille, bool rising)
+{
+    memset(tracker, 0, sizeof(button_touch_tracker_t));
+    tracker->threshold_permille = threshold_permille;
+    tracker->rising = rising;
+}
+
+static uint32_t touch_tracker_delta(const button_touch_tracker_t *tracker)
+{
+    return (uint32_t)(((uint64_t)tracker->baseline * tracker->threshold_permille / 1000) >> TOUCH_BASELINE_FRAC);
+}
+
+bool button_touch_tracker_update(button_touch_tracker_t *tracker, uint32_t reading)
+{
+    if (0 == reading) {
+        return tracker->touched;
+    }
+    uint32_t scaled = reading << TOUCH_BASELINE_FRAC;
+    if (0 == tracker->baseline) {
+        /**< the first reading is the baseline, the pad must not be touched at init */
+        tracker->baseline = scaled;
+        return false;
+    }
+    uint32_t base = tracker->baseline >> TOUCH_BASELINE_FRAC;
+    int32_t delta = tracker->rising ? (int32_t)(reading - base) : (int32_t)(base - reading);
+    int32_t threshold = touch_tracker_delta(tracker);
+    if (threshold < 1) {
+        threshold = 1;
+    }
+
+    if (tracker->touched) {
+        /**< the baseline is frozen while touched, or a long press would be learned as the baseline */
+        if (delta < threshold - threshold / 4) {
+            tracker->touched = 0;
+        }
+        return tracker->touched;
+    }
+    if (delta >= threshold) {
+        tracker->touched = 1;
+        return true;
+    }
+    /**< a reading further from a touch is followed at once, e.g. a finger leaving during init */
+    int shift = delta < 0 ? TOUCH_BASELINE_FAST : CONFIG_TOUCH_BUTTON_BASELINE_SHIFT;
+    if (scaled > tracker->baseline) {
+        tracker->baseline += (scaled - tracker->baseline + (1U << shift) - 1) >> shift;
+    } else {
+        tracker->baseline -= (tracker->baseline - scaled + (1U << shift) - 1) >> shift;
+    }
+    return false;
+}
+
+uint32_t button_touch_tracker_threshold(const button_touch_tracker_t *tracker)
+{
+    if (0 == tracker->baseline) {
+        return 0;
+    }
+    uint32_t base = tracker->baseline >> TOUCH_BASELINE_FRAC;
+    uint32_t delta = touch_tracker_delta(tracker);
+    return tracker->rising ? base + delta : (base > delta ? base - delta : 0);
+}
+
+#if TOUCH_BUTTON_SUPPORTED
+
+typedef struct {
+    button_touch_tracker_t tracker[TOUCH_PAD_MAX];
+    uint32_t pad_mask;          /* pads with a button */
+    uint32_t touched_mask;      /* pads touched at the last read */
+    int64_t last_time;          /* time of the last read */
+    volatile bool isr_pending;  /* a touch interrupt since the last read */
+} touch_button_t;
+
+static touch_button_t g_touch = {0};
+
+static void touch_button_isr(void *arg)
+{
+    /**< the scan reads the pads, the threshold of the tracker decides, not the interrupt */
+#if TOUCH_BUTTON_VERSION == 1
+    touch_pad_clear_status();
+#else
+    touch_pad_read_intr_status_mask();
+#endif
+    g_touch.isr_pending = true;
+}
+
+static uint32_t touch_read_filtered(int32_t pad)
+{
+#if TOUCH_BUTTON_VERSION == 1
+    uint16_t value = 0;
+    if (ESP_OK != touch_pad_read_filtered(pad, &value)) {
+        return 0;
+    }
+#else
+    uint32_t value = 0;
+    if (ESP_OK != touch_pad_filter_read_smooth(pad, &value)) {
+        return 0;
+    }
+#endif
+    return value;
+}
+
+static void touch_set_thresh(int32_t pad)
+{
+    const button_touch_tracker_t *tracker = &g_touch.tracker[pad];
+    if (0 == tracker->baseline) {
+        return;
+    }
+#if TOUCH_BUTTON_VERSION == 1
+    /**< the absolute reading under which the pad interrupts */
+    uint32_t thresh = button_touch_tracker_threshold(tracker);
+    touch_pad_set_thresh(pad, thresh > UINT16_MAX ? UINT16_MAX : thresh);
+#else
+    /**< the change from the benchmark of the peripheral */
+    touch_pad_set_thresh(pad, touch_tracker_delta(tracker));
+#endif
+}
+
+static void touch_read_all(void)
+{
+    uint32_t touched = 0;
+    for (int pad = 0; pad < TOUCH_PAD_MAX; pad++) {
+        if (!(g_touch.pad_mask & (1U << pad))) {
+            continue;
+        }
+        if (button_touch_tracker_update(&g_touch.tracker[pad], touch_read_filtered(pad))) {
+            touched |= 1U << pad;
+        }
+        touch_set_thresh(pad);
+    }
+    g_touch.touched_mask = touched;
+}
+
+static esp_err_t touch_sensor_start(void)
+{
+    esp_err_t ret = touch_pad_init();
+    TOUCH_BTN_CHECK(ESP_OK == ret, "touch pad init failed", ret);
+#if TOUCH_BUTTON_VERSION == 1
+    touch_pad_set_fsm_mode(TOUCH_FSM_MODE_TIMER);
+    touch_pad_set_voltage(TOUCH_HVOLT_2V7, TOUCH_LVOLT_0V5, TOUCH_HVOLT_ATTEN_1V);
+    ret = touch_pad_filter_start(CONFIG_TOUCH_BUTTON_READ_MS / 2 > 0 ? CONFIG_TOUCH_BUTTON_READ_MS / 2 : 1);
+    if (ESP_OK == ret) {
+        touch_pad_set_trigger_mode(TOUCH_TRIGGER_BELOW);
+        ret = touch_pad_isr_register(touch_button_isr, NULL);
+    }
+    if (ESP_OK == ret) {
+        ret = touch_pad_intr_enable();
+    }
+#else
+    touch_filter_config_t filter_info = {
+        .mode = TOUCH_PAD_FILTER_IIR_16,
+        .debounce_cnt = 1,
+        .noise_thr = 0,
+        .jitter_step = 4,
+        .smh_lvl = TOUCH_PAD_SMOOTH_IIR_2,
+    };
+    touch_pad_filter_set_config(&filter_info);
+    touch_pad_filter_enable();
+    touch_pad_set_fsm_mode(TOUCH_FSM_MODE_TIMER);
+    ret = touch_pad_isr_register(touch_button_isr, NULL, TOUCH_PAD_INTR_MASK_ACTIVE | TOUCH_PAD_INTR_MASK_INACTIVE);
+    if (ESP_OK == ret) {
+        ret = touch_pad_intr_enable(TOUCH_PAD_INTR_MASK_ACTIVE | TOUCH_PAD_INTR_MASK_INACTIVE);
+    }
+    if (ESP_OK == ret) {
+        ret = touch_pad_fsm_start();
+    }
+#endif
+    if (ESP_OK != ret) {
+        ESP_LOGE(TAG, "touch sensor start failed");
+        touch_pad_isr_deregister(touch_button_isr, NULL);
+        touch_pad_deinit();
+    }
+    return ret;
+}
+
+static void touch_sensor_stop(void)
+{
+#if TOUCH_BUTTON_VERSION == 1
+    touch_pad_intr_disable();
+    touch_pad_isr_deregister(touch_button_isr, NULL);
+    touch_pad_filter_stop();
+#else
+    touch_pad_intr_disable(TOUCH_PAD_INTR_MASK_ACTIVE | TOUCH_PAD_INTR_MASK_INACTIVE);
+    touch_pad_isr_deregister(touch_button_isr, NULL);
+    touch_pad_fsm_stop();
+    touch_pad_filter_disable();
+#endif
+    touch_pad_deinit();
+}
+
+esp_err_t button_touch_init(const button_touch_config_t *config)
+{
+    TOUCH_BTN_CHECK(NULL != config, "Pointer of config is invalid", ESP_ERR_INVALID_ARG);
+    TOUCH_BTN_CHECK(config->touch_pad >= 0 && config->touch_pad < TOUCH_PAD_MAX, "touch pad error", ESP_ERR_INVALID_ARG);
+#if TOUCH_BUTTON_VERSION == 2
+    /**< channel 0 is the internal denoise channel */
+    TOUCH_BTN_CHECK(config->touch_pad != TOUCH_PAD_NUM0, "touch pad 0 is not a button channel", ESP_ERR_INVALID_ARG);
+#endif
+    TOUCH_BTN_CHECK(!(g_touch.pad_mask & (1U << config->touch_pad)), "The touch pad has been used", ESP_ERR_INVALID_STATE);
+
+    esp_err_t ret = ESP_OK;
+    if (0 == g_touch.pad_mask) {
+        ret = touch_sensor_start();
+        TOUCH_BTN_CHECK(ESP_OK == ret, "touch sensor start failed", ret);
+    }
+#if TOUCH_BUTTON_VERSION == 1
+    ret = touch_pad_config(config->touch_pad, 0);
+#else
+    ret = touch_pad_config(config->touch_pad);
+#endif
+    if (ESP_OK != ret) {
+        ESP_LOGE(TAG, "touch pad %"PRIi32" config failed", config->touch_pad);
+        if (0 == g_touch.pad_mask) {
+            touch_sensor_stop();
+        }
+        return ret;
+    }
+    uint16_t permille = config->threshold_permille ? config->threshold_permille : CONFIG_TOUCH_BUTTON_THRESHOLD_PERMILLE;
+    button_touch_tracker_init(&g_touch.tracker[config->touch_pad], permille, TOUCH_BUTTON_VERSION != 1);
+    g_touch.pad_mask |= 1U << config->touch_pad;
+    /**< read on the first scan, the baseline is primed from it */
+    g_touch.isr_pending = true;
+    return ESP_OK;
+}
+
+esp_err_t button_touch_deinit(int32_t touch_pad)
+{
+    TOUCH_BTN_CHECK(touch_pad >= 0 && touch_pad < TOUCH_PAD_MAX && (g_touch.pad_mask & (1U << touch_pad)), "The button is not init", ESP_ERR_INVALID_ARG);
+    g_touch.pad_mask &= ~(1U << touch_pad);
+    g_touch.touched_mask &= ~(1U << touch_pad);
+#if TOUCH_BUTTON_VERSION == 1
+    touch_pad_set_thresh(touch_pad, 0);
+#else
+    touch_pad_clear_channel_mask(1U << touch_pad);
+#endif
+    if (0 == g_touch.pad_mask) {
+        touch_sensor_stop();
+        memset(&g_touch, 0, sizeof(touch_button_t));
+    }
+    return ESP_OK;
+}
+
+uint8_t button_touch_get_key_level(void *touch_pad)
+{
+    /** one read of all the pads, on an interrupt or every CONFIG_TOUCH_BUTTON_READ_MS */
+    int64_t now = esp_timer_get_time();
+    if (g_touch.isr_pending || now - g_touch.last_time >= TOUCH_READ_US) {
+        g_touch.isr_pending = false;
+        g_touch.last_time = now;
+        touch_read_all();
+    }
+    return (g_touch.touched_mask >> (uint32_t)touch_pad) & 1;
+}
+
+#else
+
+esp_err_t button_touch_init(const button_touch_config_t *config)
+{
+    ESP_LOGE(TAG, "touch sensor of this chip is not supported");
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t button_touch_deinit(int32_t touch_pad)
+{
+    return ESP_ERR_INVALID_ARG;
+}
+
+uint8_t button_touch_get_key_level(void *touch_pad)
+{
+    return 0;
+}
+
+#endif
@@ -0,0 +1,106 @@
+/* SPDX-FileCopyrightText: 2022-2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Touch pad button configuration
+ *
+ */
+typedef struct {
+    int32_t touch_pad;              /**< touch channel of the button, e.g. TOUCH_PAD_NUM2 */
+    uint16_t threshold_permille;    /**< change of the reading from the baseline that is a touch, in 1/1000 of the baseline. 0 for CONFIG_TOUCH_BUTTON_THRESHOLD_PERMILLE */
+} button_touch_config_t;
+
+/**
+ * @brief Baseline and touch state of a pad, from its filtered readings
+ *
+ *        The baseline follows the untouched reading slowly, see CONFIG_TOUCH_BUTTON_BASELINE_SHIFT,
+ *        so drifts of temperature and humidity are tracked. It follows at once a reading further
+ *        from a touch, and it is frozen while the pad is touched. A touch is released when the
+ *        change falls under 3/4 of the threshold.
+ */
+typedef struct {
+    uint32_t baseline;              /**< untouched reading in 1/16, 0 until the first reading */
+    uint16_t threshold_permille;
+    uint8_t rising;                 /**< the reading rises on a touch (touch sensor v2), else it falls (v1) */
+    uint8_t touched;
+} button_touch_tracker_t;
+
+/**
+ * @brief Initialize the tracker of a pad
+ *
+ * @param tracker tracker to initialize
+ * @param threshold_permille change of the reading from the baseline that is a touch, in 1/1000 of the baseline
+ * @param rising the reading rises on a touch
+ */
+void button_touch_tracker_init(button_touch_tracker_t *tracker, uint16_t threshold_permille, bool rising);
+
+/**
+ * @brief Feed a filtered reading to the tracker of a pad
+ *
+ * @param tracker tracker of the pad
+ * @param reading filtered reading, 0 is ignored (not measured yet)
+ *
+ * @return true if the pad is touched
+ */
+bool button_touch_tracker_update(button_touch_tracker_t *tracker, uint32_t reading);
+
+/**
+ * @brief Reading at which a touch is detected, for the interrupt threshold
+ *
+ * @param tracker tracker of the pad
+ *
+ * @return reading, 0 until the first reading
+ */
+uint32_t button_touch_tracker_threshold(const button_touch_tracker_t *tracker);
+
+/**
+ * @brief Initialize a touch pad button. The touch sensor is started with the first button
+ *
+ * @param config pointer of configuration struct
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG   Arguments is invalid.
+ *      - ESP_ERR_INVALID_STATE The pad is already used
+ *      - ESP_ERR_NOT_SUPPORTED The chip has no touch sensor supported by the button
+ */
+esp_err_t button_touch_init(const button_touch_config_t *config);
+
+/**
+ * @brief Deinitialize a touch pad button, the touch sensor is stopped with the last button
+ *
+ * @param touch_pad touch channel of the button
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG   Arguments is invalid.
+ */
+esp_err_t button_touch_deinit(int32_t touch_pad);
+
+/**
+ * @brief Get the touch state of a pad
+ *
+ * @param touch_pad touch channel of the button
+ *
+ * @return 1 if touched
+ *
+ * @note All the pads are read every CONFIG_TOUCH_BUTTON_READ_MS, or on the next scan after a
+ *       touch interrupt, the other scans use the state of the last read.
+ */
+uint8_t button_touch_get_key_level(void *touch_pad);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,107 @@
+/* SPDX-FileCopyrightText: 2022-2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <stdlib.h>
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "button_virtual.h"
+#include "button_iram.h"
+
+static const char *TAG = "virtual button";
+
+#define VIRTUAL_BTN_CHECK(a, str, ret_val)                        \
+    if (!(a))                                                     \
+    {                                                             \
+        ESP_LOGE(TAG, "%s(%d): %s", __FUNCTION__, __LINE__, str); \
+        return (ret_val);                                         \
+    }
+
+#define MAILBOX_LEVEL_SHIFT     31
+#define MAILBOX_WRITING         (1UL << 30)
+#define MAILBOX_SEQ_SHIFT       8
+#define MAILBOX_SEQ_MASK        0x3fffff
+#define MAILBOX_EDGES_MASK      0xff
+#define MAILBOX_LEVEL(word)     (((word) >> MAILBOX_LEVEL_SHIFT) & 1)
+#define MAILBOX_SEQ(word)       (((word) >> MAILBOX_SEQ_SHIFT) & MAILBOX_SEQ_MASK)
+#define MAILBOX_EDGES(word)     ((word) & MAILBOX_EDGES_MASK)
+
+esp_err_t button_virtual_init(const button_virtual_config_t *config, button_virtual_mailbox_t **mailbox)
+{
+    VIRTUAL_BTN_CHECK(NULL != config, "Pointer of config is invalid", ESP_ERR_INVALID_ARG);
+    VIRTUAL_BTN_CHECK(NULL != mailbox, "Pointer of mailbox is invalid", ESP_ERR_INVALID_ARG);
+
+    button_virtual_mailbox_t *mb = (button_virtual_mailbox_t *)calloc(1, sizeof(button_virtual_mailbox_t));
+    VIRTUAL_BTN_CHECK(NULL != mb, "Mailbox alloc failed", ESP_ERR_NO_MEM);
+    /**< the button starts released */
+    mb->word = (uint32_t)(!config->active_level) << MAILBOX_LEVEL_SHIFT;
+    *mailbox = mb;
+    return ESP_OK;
+}
+
+esp_err_t button_virtual_deinit(button_virtual_mailbox_t *mailbox)
+{
+    free(mailbox);
+    return ESP_OK;
+}
+
+uint8_t BUTTON_SCAN_ATTR button_virtual_get_key_level(void *mailbox)
+{
+    return MAILBOX_LEVEL(__atomic_load_n(&((button_virtual_mailbox_t *)mailbox)->word, __ATOMIC_RELAXED));
+}
+
+void button_virtual_post(button_virtual_mailbox_t *mailbox, uint8_t level, int64_t time_us)
+{
+    uint32_t old = __atomic_load_n(&mailbox->word, __ATOMIC_RELAXED);
+    level = level ? 1 : 0;
+    for (;;) {
+        if (MAILBOX_LEVEL(old) == level) {
+            return;
+        }
+        if (old & MAILBOX_WRITING) {
+            /**< another post of this button is writing its time, it is not spun against from its own core */
+            vTaskDelay(1);
+            old = __atomic_load_n(&mailbox->word, __ATOMIC_RELAXED);
+            continue;
+        }
+        uint32_t edges = MAILBOX_EDGES(old) + 1;
+        if (edges > BUTTON_VIRTUAL_EDGES_MAX) {
+            /**< drop the oldest press and release pair, the level sequence stays consistent */
+            edges -= 2;
+        }
+        uint32_t seq = (MAILBOX_SEQ(old) + 1) & MAILBOX_SEQ_MASK;
+        uint32_t new_word = ((uint32_t)level << MAILBOX_LEVEL_SHIFT) | MAILBOX_WRITING | (seq << MAILBOX_SEQ_SHIFT) | edges;
+        if (__atomic_compare_exchange_n(&mailbox->word, &old, new_word, true, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+            break;
+        }
+    }
+    /**< the edge is numbered by the swap, its time is published by clearing the flag */
+    __atomic_store_n(&mailbox->edge_time_us[MAILBOX_SEQ(old) % BUTTON_VIRTUAL_EDGES_MAX], (uint32_t)time_us, __ATOMIC_RELAXED);
+    __atomic_fetch_and(&mailbox->word, ~MAILBOX_WRITING, __ATOMIC_RELEASE);
+}
+
+bool BUTTON_SCAN_ATTR button_virtual_pending(const button_virtual_mailbox_t *mailbox)
+{
+    return MAILBOX_EDGES(__atomic_load_n(&mailbox->word, __ATOMIC_RELAXED)) != 0;
+}
+
+bool BUTTON_SCAN_ATTR button_virtual_take(button_virtual_mailbox_t *mailbox, uint8_t *level, uint32_t *time_us)
+{
+    uint32_t old = __atomic_load_n(&mailbox->word, __ATOMIC_ACQUIRE);
+    uint32_t time;
+    do {
+        /**< the time of the only pending edge may still be written, it is taken on the next scan */
+        if (0 == MAILBOX_EDGES(old) || ((old & MAILBOX_WRITING) && 1 == MAILBOX_EDGES(old))) {
+            return false;
+        }
+        /**< a post that would overwrite the time of the oldest edge drops it first, and the swap fails */
+        uint32_t edge = (MAILBOX_SEQ(old) - MAILBOX_EDGES(old)) & MAILBOX_SEQ_MASK;
+        time = __atomic_load_n(&mailbox->edge_time_us[edge % BUTTON_VIRTUAL_EDGES_MAX], __ATOMIC_RELAXED);
+    } while (!__atomic_compare_exchange_n(&mailbox->word, &old, old - 1, true, __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE));
+    *time_us = time;
+    /**< edges still pending after this one flip the latest level back */
+    *level = MAILBOX_LEVEL(old) ^ ((MAILBOX_EDGES(old) - 1) & 1);
+    return true;
+}
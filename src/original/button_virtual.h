@@ -0,0 +1,103 @@
+/* SPDX-FileCopyrightText: 2022-2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Virtual button configuration. The level is pushed by iot_button_inject_level
+ *        from any task, e.g. from a network, BLE or IPC handler, and is never polled.
+ *
+ */
+typedef struct {
+    uint8_t active_level;       /**< active level when press down */
+} button_virtual_config_t;
+
+#define BUTTON_VIRTUAL_EDGES_MAX    16      /*!< Level changes a virtual button queues between two scans, the oldest press and release are dropped beyond*/
+
+/**
+ * @brief Mailbox of a virtual button
+ *
+ *        word holds the latest injected level (bit 31), a flag set while an injection writes
+ *        the time of its edge (bit 30), the number of edges injected (bits 8-29) and the number
+ *        of level changes not yet consumed by the scan (bits 0-7). Edges alternate, so the level
+ *        after each pending edge is known from the latest level and the edges still pending.
+ */
+typedef struct {
+    uint32_t            word;
+    uint32_t            edge_time_us[BUTTON_VIRTUAL_EDGES_MAX];  /*! Time of each queued edge by edge number, low 32 bits of esp_timer_get_time()*/
+} button_virtual_mailbox_t;
+
+/**
+ * @brief Allocate the mailbox of a virtual button
+ *
+ * @param config pointer of virtual button configuration
+ * @param mailbox mailbox allocated, released by button_virtual_deinit
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG   Arguments is invalid.
+ *      - ESP_ERR_NO_MEM        Mailbox alloc failed.
+ */
+esp_err_t button_virtual_init(const button_virtual_config_t *config, button_virtual_mailbox_t **mailbox);
+
+/**
+ * @brief Release the mailbox of a virtual button
+ *
+ * @param mailbox mailbox to release
+ *
+ * @return
+ *      - ESP_OK on success
+ */
+esp_err_t button_virtual_deinit(button_virtual_mailbox_t *mailbox);
+
+/**
+ * @brief Get the latest injected level, pending level changes are not consumed
+ *
+ * @param mailbox mailbox of the button
+ *
+ * @return level
+ */
+uint8_t button_virtual_get_key_level(void *mailbox);
+
+/**
+ * @brief Post a level, safe from any task. Posts to the same button take turns, the scan never waits for them
+ *
+ * @param mailbox mailbox of the button
+ * @param level level injected
+ * @param time_us time of the level change, see esp_timer_get_time()
+ */
+void button_virtual_post(button_virtual_mailbox_t *mailbox, uint8_t level, int64_t time_us);
+
+/**
+ * @brief Check if the scan has levels to consume
+ *
+ * @param mailbox mailbox of the button
+ *
+ * @return true if at least one level change is pending
+ */
+bool button_virtual_pending(const button_virtual_mailbox_t *mailbox);
+
+/**
+ * @brief Consume one pending level change, called by the scan
+ *
+ * @param mailbox mailbox of the button
+ * @param level level after the consumed change, unchanged if nothing is pending
+ * @param time_us time of the consumed change, unchanged if nothing is pending
+ *
+ * @return true if a level change was consumed
+ */
+bool button_virtual_take(button_virtual_mailbox_t *mailbox, uint8_t *level, uint32_t *time_us);
+
+#ifdef __cplusplus
+}
+#endif
@@ -9,17 +9,35 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/timers.h"
+#include "freertos/queue.h"
 #include "esp_log.h"
 #include "driver/gpio.h"
 #include "iot_button.h"
 #include "esp_timer.h"
+#include "esp_sleep.h"
+#include "esp_attr.h"
+#include "esp_bit_defs.h"
+#include "soc/soc_caps.h"
+#if SOC_PM_SUPPORT_EXT1_WAKEUP || SOC_PM_SUPPORT_EXT_WAKEUP
+#include "driver/rtc_io.h"
+#define BUTTON_DEEP_SLEEP_WAKEUP_SUPPORTED 1
+#endif
+#include "esp_idf_version.h"
 #include "sdkconfig.h"
 #include "arduino_config.h"
+#include "button_iram.h"
+#include "button_scan.h"
+#if CONFIG_BUTTON_SCAN_IRAM
+#if !CONFIG_ESP_TIMER_SUPPORTS_ISR_DISPATCH_METHOD
+#error "CONFIG_BUTTON_SCAN_IRAM needs CONFIG_ESP_TIMER_SUPPORTS_ISR_DISPATCH_METHOD"
+#endif
+#endif
 
 static const char *TAG = "button";
-static portMUX_TYPE s_button_lock = portMUX_INITIALIZER_UNLOCKED;
-#define BUTTON_ENTER_CRITICAL()           portENTER_CRITICAL(&s_button_lock)
-#define BUTTON_EXIT_CRITICAL()            portEXIT_CRITICAL(&s_button_lock)
+/**< guards the growth and the free list of the handle table, lookups, injections, the scan and the setters never take it */
+static portMUX_TYPE s_slot_lock = portMUX_INITIALIZER_UNLOCKED;
+#define SLOT_ENTER_CRITICAL()             portENTER_CRITICAL(&s_slot_lock)
+#define SLOT_EXIT_CRITICAL()              portEXIT_CRITICAL(&s_slot_lock)
 
 #define BTN_CHECK(a, str, ret_val)                                \
     if (!(a)) {                                                   \
@@ -32,84 +50,578 @@ static portMUX_TYPE s_button_lock = portMUX_INITIALIZER_UNLOCKED;
  *
  */
 typedef struct {
-    button_cb_t cb;
+    button_cb_t cb;                 /*! button_event_cb_t if typed is set*/
     void *usr_data;
     button_event_data_t event_data;
+    uint8_t typed: 1;
+    uint8_t from_group: 1;          /*! Registered on the group, copied when the button got its own table*/
+    uint8_t context;                /*! button_cb_context_t*/
 } button_cb_info_t;
 
+/**
+ * @brief Timing of a button, written by the API and taken whole by the scan, see button_timing_take()
+ *
+ */
+typedef struct {
+    uint16_t            long_press_ticks;
+    uint16_t            short_press_ticks;
+    uint16_t            serial_ticks;
+    uint16_t            tolerance_ms;
+    uint16_t            hold_start_ticks;
+    uint16_t            hold_min_ticks;
+    uint16_t            hold_ramp_ticks;
+    uint16_t            hold_coalesce_ticks;
+    uint8_t             debounce_ticks[2];    /*! Scans to accept a release [0] and a press [1]*/
+} button_timing_t;
+
+/**
+ * @brief Callbacks of a button in one allocation, grouped by event in event order
+ *
+ *        Only registered callbacks take memory. The callbacks of an event are
+ *        records[first[event]] to records[first[event + 1] - 1].
+ */
+typedef struct {
+    uint16_t            present;                        /*! Bit of an event is set if it has callbacks*/
+    uint8_t             first[BUTTON_EVENT_MAX + 1];    /*! first[BUTTON_EVENT_MAX] is the number of records, up to BUTTON_CB_MAX_NUM*/
+    button_cb_info_t    records[];
+} button_cb_table_t;
+
+/**
+ * @brief Callback call deferred to a worker task
+ *
+ */
+typedef struct {
+    button_cb_t cb;                 /*! NULL stops the worker*/
+    void *usr_data;
+    uint8_t typed;
+    button_event_info_t info;
+} button_cb_job_t;
+
 /**
  * @brief Structs to record individual key parameters
  *
  */
 typedef struct Button {
+    struct Button       *next;
+    struct Button       *prev;
+    button_cb_table_t   *cb_table;            /*! Callbacks, NULL if none*/
+    struct button_group *group;               /*! Group the button memory belongs to, NULL if created alone*/
+    void                *hardware_data;
+    uint8_t             (*hal_button_Level)(void *hardware_data);
+    esp_err_t           (*hal_button_deinit)(void *hardware_data);
+    button_handle_t     handle;               /*! Generation tagged handle given to the user*/
+    button_debounce_t   debounce;             /*! Debounced level and backend state*/
+    button_timing_t     timing;               /*! Last timing written, the scan uses its copy in the fields below*/
+    uint32_t            timing_seq;           /*! Incremented when a writer claims timing and when it is done, odd while claimed*/
+    uint32_t            timing_taken;         /*! timing_seq of the copy used by the scan*/
+    uint32_t            click_mask;           /*! Click counts needed by the registered callbacks, see iot_button_get_click_mask()*/
     uint16_t            ticks;
     uint16_t            long_press_ticks;     /*! Trigger ticks for long press*/
     uint16_t            short_press_ticks;    /*! Trigger ticks for repeat press*/
     uint16_t            long_press_hold_cnt;  /*! Record long press hold count*/
     uint16_t            long_press_ticks_default;
+    uint16_t            serial_ticks;         /*! Ticks between the press_time checks of a long press, and default hold rate*/
+    uint16_t            tolerance_ms;         /*! Long press press_time tolerance*/
+    uint16_t            hold_step;            /*! serial_ticks steps of the long press, press_time of LONG_PRESS_START/UP is checked on each*/
+    uint16_t            hold_next;            /*! Ticks of the next BUTTON_LONG_PRESS_HOLD repeat*/
+    uint16_t            hold_dispatch;        /*! Ticks of the next coalesced callback*/
+    uint16_t            hold_pending;         /*! Repeats due and not yet delivered*/
+    uint16_t            hold_start_ticks;     /*! Auto-repeat curve in ticks, see button_hold_config_t*/
+    uint16_t            hold_min_ticks;
+    uint16_t            hold_ramp_ticks;
+    uint16_t            hold_coalesce_ticks;
+    int16_t             count[2];             /*! Next LONG_PRESS_START [0] and last reached LONG_PRESS_UP [1] callback*/
+    uint8_t             max_clicks;           /*! Set by iot_button_set_max_clicks(), 0 to follow click_mask*/
+    uint8_t             click_limit;          /*! Clicks are classified at once when repeat reaches it*/
     uint8_t             repeat;
+    uint8_t             event;                /*! button_event_t*/
+    uint8_t             type;                 /*! button_type_t*/
     uint8_t             state: 3;
-    uint8_t             debounce_cnt: 3;
     uint8_t             active_level: 1;
-    uint8_t             button_level: 1;
-    button_event_t      event;
-    uint8_t             (*hal_button_Level)(void *hardware_data);
-    esp_err_t           (*hal_button_deinit)(void *hardware_data);
-    void                *hardware_data;
-    button_type_t       type;
-    button_cb_info_t    *cb_info[BUTTON_EVENT_MAX];
-    size_t              size[BUTTON_EVENT_MAX];
-    int                 count[2];
-    struct Button       *next;
+    uint8_t             cb_shared: 1;         /*! cb_table is the table of the group*/
 } button_dev_t;
 
+/**
+ * @brief Slot of the handle table
+ *
+ */
+typedef struct {
+    button_dev_t        *btn;                 /*! NULL if the slot is free*/
+    uint32_t            tag;                  /*! Generation of the handle using the slot << 16 | claims in progress, generation 0 if free*/
+    uint16_t            next_free;            /*! Index + 1 of the next free slot, 0 for the end of the free list*/
+} button_slot_t;
+
+#define SLOT_TABLE_MIN              8
+#define SLOT_TAG_GENERATION(tag)    ((tag) >> 16)
+#define SLOT_TAG_CLAIMS(tag)        ((tag) & 0xffff)
+#define SLOT_CHUNK_NUM              13        /*! SLOT_TABLE_MIN * (2^13 - 1) slots, the most a 16-bit index reaches*/
+
+/**
+ * @brief Buttons created by iot_button_create_group(), allocated in one block
+ *
+ */
+typedef struct button_group {
+    size_t              num;
+    button_dev_t        proto;                /*! Holds the callback tables shared by the group, never scanned*/
+    button_dev_t        btns[];
+} button_group_t;
+
+/**
+ * @brief Scan state of one button, kept in RTC memory across sleep
+ *
+ */
+typedef struct {
+    uint32_t            hardware_data;        /*! Used with type to find the button again after wakeup, see button_sleep_keeps_state()*/
+    uint8_t             type;
+    uint8_t             state;
+    uint8_t             repeat;
+    uint8_t             button_level;
+    uint16_t            ticks;
+    uint16_t            long_press_hold_cnt;
+} button_sleep_record_t;
+
+/**
+ * Sizes of the button structures for the target, read from the symbol sizes by cmake/button_size_report.cmake.
+ * Never referenced, so the linker drops them from the firmware.
+ */
+const button_dev_t button_size_button = {0};
+const button_slot_t button_size_handle_slot = {0};
+const button_group_t button_size_group = {0};
+const button_cb_table_t button_size_cb_table = {0};
+const button_cb_info_t button_size_cb = {0};
+
 //button handle list head.
 static button_dev_t *g_head_handle = NULL;
+static uint16_t g_button_num = 0;
+static button_slot_t *g_slot_chunks[SLOT_CHUNK_NUM];  /*! Chunk k holds SLOT_TABLE_MIN << k slots, never moved*/
+static uint16_t g_slot_num = 0;
+static uint32_t g_slot_lookups = 0;         /*! Lookups in progress, the chunks are released only when there are none*/
+static uint16_t g_slot_free = 0;            /*! Index + 1 of the first free slot*/
+static uint16_t g_generation = 0;
 static esp_timer_handle_t g_button_timer_handle = NULL;
+#if CONFIG_BUTTON_SCAN_IRAM
+static esp_timer_handle_t g_button_task_timer_handle = NULL;  /*! Scan of the buttons not read from IRAM*/
+#endif
+static QueueHandle_t g_cb_queue[BUTTON_CB_CONTEXT_MAX];  /*! Queue of the worker task of each context, [BUTTON_CB_CONTEXT_INLINE] unused*/
 static bool g_is_timer_running = false;
+#if CONFIG_BUTTON_SCAN_IRAM
+static BaseType_t g_cb_woken = pdFALSE;     /*! A worker was woken by the scan interrupt*/
+#endif
+static uint32_t g_scan_epoch = 0;           /*! Pass of the scan, see button_scan_epoch()*/
+
+static RTC_DATA_ATTR button_sleep_record_t s_sleep_record[CONFIG_BUTTON_SLEEP_MAX_RECORD];
+static RTC_DATA_ATTR uint8_t s_sleep_record_num = 0;
+static RTC_DATA_ATTR uint8_t s_sleep_mode = BUTTON_SLEEP_NONE;
 
 #define TICKS_INTERVAL    CONFIG_BUTTON_PERIOD_TIME_MS
-#define DEBOUNCE_TICKS    CONFIG_BUTTON_DEBOUNCE_TICKS //MAX 8
 #define SHORT_TICKS       (CONFIG_BUTTON_SHORT_PRESS_TIME_MS /TICKS_INTERVAL)
 #define LONG_TICKS        (CONFIG_BUTTON_LONG_PRESS_TIME_MS /TICKS_INTERVAL)
 #define SERIAL_TICKS      (CONFIG_BUTTON_SERIAL_TIME_MS /TICKS_INTERVAL)
 #define TOLERANCE         CONFIG_BUTTON_LONG_PRESS_TOLERANCE_MS
 
+/**
+ * Callbacks of an event: BUTTON_CB_INFO() is NULL if none, else BUTTON_CB_NUM() records
+ */
+#define BUTTON_CB_PRESENT(btn, ev)  ((btn)->cb_table && ((btn)->cb_table->present & BIT(ev)))
+#define BUTTON_CB_INFO(btn, ev)     (BUTTON_CB_PRESENT(btn, ev) ? &(btn)->cb_table->records[(btn)->cb_table->first[ev]] : NULL)
+#define BUTTON_CB_NUM(btn, ev)      ((btn)->cb_table ? (btn)->cb_table->first[(ev) + 1] - (btn)->cb_table->first[ev] : 0)
+
 #define CALL_EVENT_CB(ev)                                                   \
-    if (btn->cb_info[ev]) {                                                 \
-        for (int i = 0; i < btn->size[ev]; i++) {                           \
-            btn->cb_info[ev][i].cb(btn, btn->cb_info[ev][i].usr_data);      \
+    if (BUTTON_CB_PRESENT(btn, ev)) {                                       \
+        button_event_info_t info;                                           \
+        button_cb_info_t *cb_info = BUTTON_CB_INFO(btn, ev);                \
+        int num = BUTTON_CB_NUM(btn, ev);                                   \
+        button_fill_event_info(btn, &info);                                 \
+        for (int i = 0; i < num; i++) {                                     \
+            button_call_cb(btn, &cb_info[i], &info);                        \
         }                                                                   \
     }                                                                       \
 
+static esp_err_t button_register_com(button_dev_t *btn, button_event_config_t event_cfg, button_cb_t cb, bool typed, void *usr_data);
+static size_t button_cb_position(button_dev_t *btn, button_event_t event, const button_cb_info_t *record);
+static esp_err_t button_cb_insert(button_dev_t *btn, button_event_t event, size_t pos, const button_cb_info_t *record);
+
+#if CONFIG_BUTTON_SCAN_IRAM
+/**< no callback runs in the timer interrupt, the inline ones are run by the high priority worker */
+#define BUTTON_CB_LANE(context)     (BUTTON_CB_CONTEXT_INLINE == (context) ? BUTTON_CB_CONTEXT_HIGH : (context))
+/**< the HAL of the other buttons may be in flash or not safe in an interrupt, e.g. the ADC driver */
+#define BUTTON_READ_FROM_IRAM(btn)  (BUTTON_TYPE_GPIO == (btn)->type || BUTTON_TYPE_VIRTUAL == (btn)->type || BUTTON_TYPE_ENCODER == (btn)->type)
+#else
+#define BUTTON_CB_LANE(context)     (context)
+#endif
+
 #define TIME_TO_TICKS(time, congfig_time)  (0 == (time))?congfig_time:(((time) / TICKS_INTERVAL))?((time) / TICKS_INTERVAL):1
 
+/**
+  * @brief  Snapshot of the button when an event is emitted, shared by all callbacks of the event.
+  */
+static inline void BUTTON_SCAN_ATTR button_fill_event_info(button_dev_t *btn, button_event_info_t *info)
+{
+    info->handle = btn->handle;
+    info->event = btn->event;
+    info->repeat = btn->repeat;
+    info->ticks_time = btn->ticks * TICKS_INTERVAL;
+    info->long_press_hold_cnt = btn->long_press_hold_cnt;
+    info->edge_time = btn->debounce.edge_time_us;
+    info->hold_repeats = 0;
+    if (BUTTON_TYPE_ENCODER == btn->type) {
+        const button_encoder_t *encoder = (const button_encoder_t *)btn->hardware_data;
+        info->encoder_steps = encoder->steps;
+        info->encoder_velocity = encoder->velocity;
+        info->encoder_position = encoder->position;
+    } else {
+        info->encoder_steps = 0;
+        info->encoder_velocity = 0;
+        info->encoder_position = 0;
+    }
+}
+
+static void button_cb_worker(void *arg)
+{
+    QueueHandle_t queue = (QueueHandle_t)arg;
+    button_cb_job_t job;
+    while (pdTRUE == xQueueReceive(queue, &job, portMAX_DELAY) && job.cb) {
+        if (job.typed) {
+            ((button_event_cb_t)job.cb)(&job.info, job.usr_data);
+        } else {
+            job.cb(job.info.handle, job.usr_data);
+        }
+    }
+    /**< the queue has been forgotten by button_cb_lanes_stop(), the jobs before the stop are done */
+    vQueueDelete(queue);
+    vTaskDelete(NULL);
+}
+
+/**
+  * @brief  Start the worker task of a callback context, if not running yet.
+  */
+static esp_err_t button_cb_lane_init(button_cb_context_t context)
+{
+    context = BUTTON_CB_LANE(context);
+    if (BUTTON_CB_CONTEXT_INLINE == context || g_cb_queue[context]) {
+        return ESP_OK;
+    }
+    QueueHandle_t queue = xQueueCreate(CONFIG_BUTTON_CB_QUEUE_LEN, sizeof(button_cb_job_t));
+    BTN_CHECK(NULL != queue, "callback queue create failed", ESP_ERR_NO_MEM);
+    UBaseType_t priority = (BUTTON_CB_CONTEXT_HIGH == context) ? CONFIG_BUTTON_CB_HIGH_PRIORITY : CONFIG_BUTTON_CB_BACKGROUND_PRIORITY;
+    if (pdPASS != xTaskCreate(button_cb_worker, "button_cb", CONFIG_BUTTON_CB_TASK_STACK, queue, priority, NULL)) {
+        vQueueDelete(queue);
+        ESP_LOGE(TAG, "callback task create failed");
+        return ESP_ERR_NO_MEM;
+    }
+    g_cb_queue[context] = queue;
+    return ESP_OK;
+}
+
+static void button_cb_lanes_stop(void)
+{
+    button_cb_job_t stop = {0};
+    for (int i = BUTTON_CB_CONTEXT_HIGH; i < BUTTON_CB_CONTEXT_MAX; i++) {
+        if (g_cb_queue[i]) {
+            xQueueSend(g_cb_queue[i], &stop, portMAX_DELAY);
+            g_cb_queue[i] = NULL;
+        }
+    }
+}
+
+static inline void BUTTON_SCAN_ATTR button_call_cb(button_dev_t *btn, const button_cb_info_t *cb_info, const button_event_info_t *info)
+{
+    button_cb_context_t lane = BUTTON_CB_LANE((button_cb_context_t)cb_info->context);
+    if (BUTTON_CB_CONTEXT_INLINE != lane) {
+        /**< never block the scan, a slow worker loses calls rather than delaying the other buttons */
+        button_cb_job_t job = {
+            .cb = cb_info->cb,
+            .usr_data = cb_info->usr_data,
+            .typed = cb_info->typed,
+            .info = *info,
+        };
+#if CONFIG_BUTTON_SCAN_IRAM
+        BaseType_t sent = xPortInIsrContext() ? xQueueSendFromISR(g_cb_queue[lane], &job, &g_cb_woken) : xQueueSend(g_cb_queue[lane], &job, 0);
+        if (pdTRUE != sent) {
+            ESP_DRAM_LOGW(DRAM_STR("button"), "callback queue %d full, event %d dropped", lane, info->event);
+        }
+#else
+        if (pdTRUE != xQueueSend(g_cb_queue[lane], &job, 0)) {
+            ESP_LOGW(TAG, "callback queue %d full, event %d dropped", lane, info->event);
+        }
+#endif
+    } else if (cb_info->typed) {
+        ((button_event_cb_t)cb_info->cb)(info, cb_info->usr_data);
+    } else {
+        cb_info->cb(btn->handle, cb_info->usr_data);
+    }
+}
+
+/**
+  * @brief  Ticks to the next BUTTON_LONG_PRESS_HOLD repeat on the auto-repeat curve.
+  */
+static inline uint16_t BUTTON_SCAN_ATTR button_hold_interval(const button_dev_t *btn)
+{
+    int32_t held = (int32_t)btn->ticks - btn->long_press_ticks;
+    /**< long_press_ticks may have been raised by iot_button_set_param() during the hold */
+    if (held < 0) {
+        held = 0;
+    }
+    if (held >= btn->hold_ramp_ticks) {
+        return btn->hold_min_ticks;
+    }
+    int32_t start = btn->hold_start_ticks;
+    return start - (start - btn->hold_min_ticks) * held / btn->hold_ramp_ticks;
+}
+
+/**
+  * @brief  Deliver the repeats due in one BUTTON_LONG_PRESS_HOLD callback.
+  */
+static void BUTTON_SCAN_ATTR button_hold_dispatch(button_dev_t *btn)
+{
+    btn->event = (uint8_t)BUTTON_LONG_PRESS_HOLD;
+    btn->long_press_hold_cnt += btn->hold_pending;
+    if (BUTTON_CB_PRESENT(btn, BUTTON_LONG_PRESS_HOLD)) {
+        button_event_info_t info;
+        button_fill_event_info(btn, &info);
+        info.hold_repeats = btn->hold_pending;
+        for (int i = 0; i < BUTTON_CB_NUM(btn, BUTTON_LONG_PRESS_HOLD); i++) {
+            button_call_cb(btn, &BUTTON_CB_INFO(btn, BUTTON_LONG_PRESS_HOLD)[i], &info);
+        }
+    }
+    btn->hold_pending = 0;
+    btn->hold_dispatch = btn->ticks + btn->hold_coalesce_ticks;
+}
+
+static void button_hold_timing(button_timing_t *timing, const button_hold_config_t *config)
+{
+    button_hold_config_t cfg = {0};
+    if (config) {
+        cfg = *config;
+    }
+    timing->hold_start_ticks = TIME_TO_TICKS(cfg.start_interval_ms, timing->serial_ticks);
+    timing->hold_ramp_ticks = cfg.ramp_ms / TICKS_INTERVAL;
+    if (0 == cfg.min_interval_ms || 0 == timing->hold_ramp_ticks) {
+        timing->hold_min_ticks = timing->hold_start_ticks;
+    } else {
+        timing->hold_min_ticks = TIME_TO_TICKS(cfg.min_interval_ms, timing->serial_ticks);
+    }
+    timing->hold_coalesce_ticks = cfg.coalesce_ms / TICKS_INTERVAL;
+}
+
+/**
+  * @brief  Merge the timing set by the user, the values at 0 are kept.
+  */
+static void button_timing_merge(button_timing_t *timing, const button_timing_config_t *config)
+{
+    if (config->long_press_time) {
+        timing->long_press_ticks = config->long_press_time / TICKS_INTERVAL;
+    }
+    if (config->short_press_time) {
+        timing->short_press_ticks = config->short_press_time / TICKS_INTERVAL;
+    }
+    if (config->serial_time) {
+        timing->serial_ticks = TIME_TO_TICKS(config->serial_time, SERIAL_TICKS);
+        button_hold_timing(timing, NULL);
+    }
+    if (config->long_press_tolerance) {
+        timing->tolerance_ms = config->long_press_tolerance;
+    }
+    if (config->debounce_press_ticks) {
+        timing->debounce_ticks[1] = config->debounce_press_ticks;
+    }
+    if (config->debounce_release_ticks) {
+        timing->debounce_ticks[0] = config->debounce_release_ticks;
+    }
+}
+
+/**
+  * @brief  Copy a timing to the fields used by the scan.
+  */
+static inline void BUTTON_SCAN_ATTR button_timing_apply(button_dev_t *btn, const button_timing_t *timing)
+{
+    btn->long_press_ticks = timing->long_press_ticks;
+    btn->short_press_ticks = timing->short_press_ticks;
+    btn->serial_ticks = timing->serial_ticks;
+    btn->tolerance_ms = timing->tolerance_ms;
+    btn->hold_start_ticks = timing->hold_start_ticks;
+    btn->hold_min_ticks = timing->hold_min_ticks;
+    btn->hold_ramp_ticks = timing->hold_ramp_ticks;
+    btn->hold_coalesce_ticks = timing->hold_coalesce_ticks;
+    btn->debounce.ticks[0] = timing->debounce_ticks[0];
+    btn->debounce.ticks[1] = timing->debounce_ticks[1];
+}
+
+/**
+  * @brief  Take the timing written since the last scan. A timing being written is left for the next scan,
+  *         so the scan never waits for a writer and never uses half of a timing.
+  */
+static inline void BUTTON_SCAN_ATTR button_timing_take(button_dev_t *btn)
+{
+    uint32_t seq = __atomic_load_n(&btn->timing_seq, __ATOMIC_ACQUIRE);
+    if (seq == btn->timing_taken || (seq & 1)) {
+        return;
+    }
+    button_timing_t timing = btn->timing;
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    if (__atomic_load_n(&btn->timing_seq, __ATOMIC_RELAXED) != seq) {
+        return;
+    }
+    btn->timing_taken = seq;
+    button_timing_apply(btn, &timing);
+}
+
+/**
+  * @brief  Claim the timing of a button to modify it in place, until button_timing_end(). Writers of
+  *         other buttons never contend and the scan is never locked out. A writer finding the timing
+  *         claimed yields a tick, so it never spins against a preempted writer of its own core.
+  */
+static button_timing_t *button_timing_begin(button_dev_t *btn)
+{
+    uint32_t seq = __atomic_load_n(&btn->timing_seq, __ATOMIC_RELAXED);
+    while ((seq & 1) || !__atomic_compare_exchange_n(&btn->timing_seq, &seq, seq + 1, true, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+        if (seq & 1) {
+            vTaskDelay(1);
+            seq = __atomic_load_n(&btn->timing_seq, __ATOMIC_RELAXED);
+        }
+    }
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    return &btn->timing;
+}
+
+/**
+  * @brief  Publish the timing claimed by button_timing_begin() to the scan.
+  */
+static void button_timing_end(button_dev_t *btn)
+{
+    __atomic_store_n(&btn->timing_seq, __atomic_load_n(&btn->timing_seq, __ATOMIC_RELAXED) + 1, __ATOMIC_RELEASE);
+}
+
+/**
+  * @brief  Read the timing of a button outside the scan, retried while a writer has it claimed.
+  */
+static void button_timing_read(button_dev_t *btn, button_timing_t *timing)
+{
+    for (;;) {
+        uint32_t seq = __atomic_load_n(&btn->timing_seq, __ATOMIC_ACQUIRE);
+        if (seq & 1) {
+            vTaskDelay(1);
+            continue;
+        }
+        *timing = btn->timing;
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&btn->timing_seq, __ATOMIC_RELAXED) == seq) {
+            return;
+        }
+    }
+}
+
+/**
+  * @brief  Bring the long press of a button down to the press_time of a callback being registered.
+  */
+static void button_lower_long_press(button_dev_t *btn, int32_t press_ticks)
+{
+    button_timing_t *timing = button_timing_begin(btn);
+    if (timing->short_press_ticks < press_ticks && press_ticks < timing->long_press_ticks) {
+        timing->long_press_ticks = press_ticks;
+    }
+    button_timing_end(btn);
+}
+
+/**
+  * @brief  Classify the clicks once the window is over, or as soon as no callback needs more clicks.
+  */
+static void BUTTON_SCAN_ATTR button_click_done(button_dev_t *btn)
+{
+    if (btn->repeat == 1) {
+        btn->event = (uint8_t)BUTTON_SINGLE_CLICK;
+        CALL_EVENT_CB(BUTTON_SINGLE_CLICK);
+    } else if (btn->repeat == 2) {
+        btn->event = (uint8_t)BUTTON_DOUBLE_CLICK;
+        CALL_EVENT_CB(BUTTON_DOUBLE_CLICK); // repeat hit
+    }
+
+    btn->event = (uint8_t)BUTTON_MULTIPLE_CLICK;
+
+    /** Calling the callbacks for MULTIPLE BUTTON CLICKS */
+    for (int i = 0; i < BUTTON_CB_NUM(btn, btn->event); i++) {
+        if (btn->repeat == BUTTON_CB_INFO(btn, btn->event)[i].event_data.multiple_clicks.clicks) {
+            button_event_info_t info;
+            button_fill_event_info(btn, &info);
+            do {
+                button_call_cb(btn, &BUTTON_CB_INFO(btn, btn->event)[i], &info);
+                i++;
+                if (i >= BUTTON_CB_NUM(btn, btn->event))
+                    break;
+            } while (BUTTON_CB_INFO(btn, btn->event)[i].event_data.multiple_clicks.clicks == btn->repeat);
+        }
+    }
+
+    btn->event = (uint8_t)BUTTON_PRESS_REPEAT_DONE;
+    CALL_EVENT_CB(BUTTON_PRESS_REPEAT_DONE); // repeat hit
+    btn->repeat = 0;
+    btn->state = 0;
+}
+
+/**
+  * @brief  Update the click counts needed by the callbacks after a registration change.
+  */
+static void button_update_clicks(button_dev_t *btn)
+{
+    uint32_t mask = 0;
+    if (BUTTON_CB_PRESENT(btn, BUTTON_SINGLE_CLICK)) {
+        mask |= BIT(1);
+    }
+    if (BUTTON_CB_PRESENT(btn, BUTTON_DOUBLE_CLICK)) {
+        mask |= BIT(2);
+    }
+    for (int i = 0; i < BUTTON_CB_NUM(btn, BUTTON_MULTIPLE_CLICK); i++) {
+        uint16_t clicks = BUTTON_CB_INFO(btn, BUTTON_MULTIPLE_CLICK)[i].event_data.multiple_clicks.clicks;
+        mask |= clicks < 32 ? BIT(clicks) : BUTTON_CLICK_MASK_ANY;
+    }
+    /**< these see every click, so the window is always waited out */
+    if (BUTTON_CB_PRESENT(btn, BUTTON_PRESS_REPEAT) || BUTTON_CB_PRESENT(btn, BUTTON_PRESS_REPEAT_DONE)) {
+        mask |= BUTTON_CLICK_MASK_ANY;
+    }
+    btn->click_mask = mask;
+
+    if (btn->max_clicks) {
+        btn->click_limit = btn->max_clicks;
+    } else if (0 == mask || (mask & BUTTON_CLICK_MASK_ANY)) {
+        /**< nothing registered: the events may be polled, keep the window */
+        btn->click_limit = BUTTON_MAX_CLICKS_WINDOW;
+    } else {
+        btn->click_limit = 31 - __builtin_clz(mask);
+    }
+}
+
 /**
   * @brief  Button driver core function, driver state machine.
   */
-static void button_handler(button_dev_t *btn)
+static void BUTTON_SCAN_ATTR button_handler(button_dev_t *btn)
 {
-    uint8_t read_gpio_level = btn->hal_button_Level(btn->hardware_data);
+    button_timing_take(btn);
 
     /** ticks counter working.. */
     if ((btn->state) > 0) {
         btn->ticks++;
     }
 
-    /**< button debounce handle */
-    if (read_gpio_level != btn->button_level) {
-        if (++(btn->debounce_cnt) >= DEBOUNCE_TICKS) {
-            btn->button_level = read_gpio_level;
-            btn->debounce_cnt = 0;
+    if (BUTTON_TYPE_VIRTUAL == btn->type) {
+        /**< injected levels are clean, one level change is consumed per scan so no press is lost */
+        uint8_t level;
+        button_virtual_mailbox_t *mailbox = (button_virtual_mailbox_t *)btn->hardware_data;
+        uint32_t time_us;
+        if (button_virtual_take(mailbox, &level, &time_us)) {
+            btn->debounce.level = level;
+            btn->debounce.edge_time_us = time_us;
         }
     } else {
-        btn->debounce_cnt = 0;
+        uint8_t read_gpio_level = btn->hal_button_Level(btn->hardware_data);
+
+        /**< button debounce handle */
+        button_debounce_update(&btn->debounce, read_gpio_level);
     }
 
     /** State machine */
     switch (btn->state) {
     case 0:
-        if (btn->button_level == btn->active_level) {
+        if (btn->debounce.level == btn->active_level) {
             btn->event = (uint8_t)BUTTON_PRESS_DOWN;
             CALL_EVENT_CB(BUTTON_PRESS_DOWN);
             btn->ticks = 0;
@@ -121,32 +633,41 @@ static void button_handler(button_dev_t *btn)
         break;
 
     case 1:
-        if (btn->button_level != btn->active_level) {
+        if (btn->debounce.level != btn->active_level) {
             btn->event = (uint8_t)BUTTON_PRESS_UP;
             CALL_EVENT_CB(BUTTON_PRESS_UP);
             btn->ticks = 0;
             btn->state = 2;
+            if (btn->repeat >= btn->click_limit) {
+                button_click_done(btn);
+            }
 
         } else if (btn->ticks > btn->long_press_ticks) {
             btn->event = (uint8_t)BUTTON_LONG_PRESS_START;
             btn->state = 4;
+            btn->hold_step = 0;
+            btn->hold_pending = 0;
+            btn->hold_next = btn->long_press_ticks + btn->hold_start_ticks;
+            btn->hold_dispatch = 0;
             /** Calling callbacks for BUTTON_LONG_PRESS_START */
-            uint16_t ticks_time = iot_button_get_ticks_time(btn);
-            if (btn->cb_info[btn->event] && btn->count[0] == 0) {
-                if (abs(ticks_time - (btn->long_press_ticks * TICKS_INTERVAL)) <= TOLERANCE && btn->cb_info[btn->event][btn->count[0]].event_data.long_press.press_time == (btn->long_press_ticks * TICKS_INTERVAL)) {
+            uint16_t ticks_time = btn->ticks * TICKS_INTERVAL;
+            if (BUTTON_CB_PRESENT(btn, btn->event) && btn->count[0] == 0) {
+                if (abs(ticks_time - (btn->long_press_ticks * TICKS_INTERVAL)) <= btn->tolerance_ms && BUTTON_CB_INFO(btn, btn->event)[btn->count[0]].event_data.long_press.press_time == (btn->long_press_ticks * TICKS_INTERVAL)) {
+                    button_event_info_t info;
+                    button_fill_event_info(btn, &info);
                     do {
-                        btn->cb_info[btn->event][btn->count[0]].cb(btn, btn->cb_info[btn->event][btn->count[0]].usr_data);
+                        button_call_cb(btn, &BUTTON_CB_INFO(btn, btn->event)[btn->count[0]], &info);
                         btn->count[0]++;
-                        if (btn->count[0] >= btn->size[btn->event])
+                        if (btn->count[0] >= BUTTON_CB_NUM(btn, btn->event))
                             break;
-                    } while (btn->cb_info[btn->event][btn->count[0]].event_data.long_press.press_time == btn->long_press_ticks * TICKS_INTERVAL);
+                    } while (BUTTON_CB_INFO(btn, btn->event)[btn->count[0]].event_data.long_press.press_time == btn->long_press_ticks * TICKS_INTERVAL);
                 }
             }
         }
         break;
 
     case 2:
-        if (btn->button_level == btn->active_level) {
+        if (btn->debounce.level == btn->active_level) {
             btn->event = (uint8_t)BUTTON_PRESS_DOWN;
             CALL_EVENT_CB(BUTTON_PRESS_DOWN);
             btn->event = (uint8_t)BUTTON_PRESS_REPEAT;
@@ -155,42 +676,20 @@ static void button_handler(button_dev_t *btn)
             btn->ticks = 0;
             btn->state = 3;
         } else if (btn->ticks > btn->short_press_ticks) {
-            if (btn->repeat == 1) {
-                btn->event = (uint8_t)BUTTON_SINGLE_CLICK;
-                CALL_EVENT_CB(BUTTON_SINGLE_CLICK);
-            } else if (btn->repeat == 2) {
-                btn->event = (uint8_t)BUTTON_DOUBLE_CLICK;
-                CALL_EVENT_CB(BUTTON_DOUBLE_CLICK); // repeat hit
-            }
-
-            btn->event = (uint8_t)BUTTON_MULTIPLE_CLICK;
-
-            /** Calling the callbacks for MULTIPLE BUTTON CLICKS */
-            for (int i = 0; i < btn->size[btn->event]; i++) {
-                if (btn->repeat == btn->cb_info[btn->event][i].event_data.multiple_clicks.clicks) {
-                    do {
-                        btn->cb_info[btn->event][i].cb(btn, btn->cb_info[btn->event][i].usr_data);
-                        i++;
-                        if (i >= btn->size[btn->event])
-                            break;
-                    } while (btn->cb_info[btn->event][i].event_data.multiple_clicks.clicks == btn->repeat);
-                }
-            }
-
-            btn->event = (uint8_t)BUTTON_PRESS_REPEAT_DONE;
-            CALL_EVENT_CB(BUTTON_PRESS_REPEAT_DONE); // repeat hit
-            btn->repeat = 0;
-            btn->state = 0;
+            button_click_done(btn);
         }
         break;
 
     case 3:
-        if (btn->button_level != btn->active_level) {
+        if (btn->debounce.level != btn->active_level) {
             btn->event = (uint8_t)BUTTON_PRESS_UP;
             CALL_EVENT_CB(BUTTON_PRESS_UP);
             if (btn->ticks < SHORT_TICKS) {
                 btn->ticks = 0;
                 btn->state = 2; //repeat press
+                if (btn->repeat >= btn->click_limit) {
+                    button_click_done(btn);
+                }
             } else {
                 btn->state = 0;
             }
@@ -198,20 +697,27 @@ static void button_handler(button_dev_t *btn)
         break;
 
     case 4:
-        if (btn->button_level == btn->active_level) {
+        if (btn->debounce.level == btn->active_level) {
             //continue hold trigger
-            if (btn->ticks >= (btn->long_press_hold_cnt + 1) * SERIAL_TICKS + btn->long_press_ticks) {
-                btn->event = (uint8_t)BUTTON_LONG_PRESS_HOLD;
-                btn->long_press_hold_cnt++;
-                CALL_EVENT_CB(BUTTON_LONG_PRESS_HOLD);
+            if (btn->ticks >= btn->hold_next) {
+                btn->hold_pending++;
+                btn->hold_next += button_hold_interval(btn);
+            }
+            if (btn->hold_pending && btn->ticks >= btn->hold_dispatch) {
+                button_hold_dispatch(btn);
+            }
+
+            if (btn->ticks >= (btn->hold_step + 1) * btn->serial_ticks + btn->long_press_ticks) {
+                btn->hold_step++;
 
                 /** Calling callbacks for BUTTON_LONG_PRESS_START based on press_time */
-                uint16_t ticks_time = iot_button_get_ticks_time(btn);
-                if (btn->cb_info[BUTTON_LONG_PRESS_START]) {
-                    button_cb_info_t *cb_info = btn->cb_info[BUTTON_LONG_PRESS_START];
+                uint16_t ticks_time = btn->ticks * TICKS_INTERVAL;
+                /**< the cursor is past the end once every callback has been called */
+                if (BUTTON_CB_PRESENT(btn, BUTTON_LONG_PRESS_START) && btn->count[0] < BUTTON_CB_NUM(btn, BUTTON_LONG_PRESS_START)) {
+                    button_cb_info_t *cb_info = BUTTON_CB_INFO(btn, BUTTON_LONG_PRESS_START);
                     uint16_t time = cb_info[btn->count[0]].event_data.long_press.press_time;
                     if (btn->long_press_ticks * TICKS_INTERVAL > time) {
-                        for (int i = btn->count[0] + 1; i < btn->size[BUTTON_LONG_PRESS_START]; i++) {
+                        for (int i = btn->count[0] + 1; i < BUTTON_CB_NUM(btn, BUTTON_LONG_PRESS_START); i++) {
                             time = cb_info[i].event_data.long_press.press_time;
                             if (btn->long_press_ticks * TICKS_INTERVAL <= time) {
                                 btn->count[0] = i;
@@ -219,22 +725,25 @@ static void button_handler(button_dev_t *btn)
                             }
                         }
                     }
-                    if (btn->count[0] < btn->size[BUTTON_LONG_PRESS_START] && abs(ticks_time - time) <= TOLERANCE) {
+                    if (btn->count[0] < BUTTON_CB_NUM(btn, BUTTON_LONG_PRESS_START) && abs(ticks_time - time) <= btn->tolerance_ms) {
+                        button_event_info_t info;
+                        button_fill_event_info(btn, &info);
+                        info.event = BUTTON_LONG_PRESS_START;
                         do {
-                            cb_info[btn->count[0]].cb(btn, cb_info[btn->count[0]].usr_data);
+                            button_call_cb(btn, &cb_info[btn->count[0]], &info);
                             btn->count[0]++;
-                            if (btn->count[0] >= btn->size[BUTTON_LONG_PRESS_START])
+                            if (btn->count[0] >= BUTTON_CB_NUM(btn, BUTTON_LONG_PRESS_START))
                                 break;
                         } while (time == cb_info[btn->count[0]].event_data.long_press.press_time);
                     }
                 }
 
                 /** Updating counter for BUTTON_LONG_PRESS_UP press_time */
-                if (btn->cb_info[BUTTON_LONG_PRESS_UP]) {
-                    button_cb_info_t *cb_info = btn->cb_info[BUTTON_LONG_PRESS_UP];
+                if (BUTTON_CB_PRESENT(btn, BUTTON_LONG_PRESS_UP) && btn->count[1] + 1 < BUTTON_CB_NUM(btn, BUTTON_LONG_PRESS_UP)) {
+                    button_cb_info_t *cb_info = BUTTON_CB_INFO(btn, BUTTON_LONG_PRESS_UP);
                     uint16_t time = cb_info[btn->count[1] + 1].event_data.long_press.press_time;
                     if (btn->long_press_ticks * TICKS_INTERVAL > time) {
-                        for (int i = btn->count[1] + 1; i < btn->size[BUTTON_LONG_PRESS_UP]; i++) {
+                        for (int i = btn->count[1] + 1; i < BUTTON_CB_NUM(btn, BUTTON_LONG_PRESS_UP); i++) {
                             time = cb_info[i].event_data.long_press.press_time;
                             if (btn->long_press_ticks * TICKS_INTERVAL <= time) {
                                 btn->count[1] = i;
@@ -242,24 +751,34 @@ static void button_handler(button_dev_t *btn)
                             }
                         }
                     }
-                    if(btn->count[1] + 1 < btn->size[BUTTON_LONG_PRESS_UP] && abs(ticks_time - time) <= TOLERANCE) {
+                    if(btn->count[1] + 1 < BUTTON_CB_NUM(btn, BUTTON_LONG_PRESS_UP) && abs(ticks_time - time) <= btn->tolerance_ms) {
                         do {
                             btn->count[1]++;
-                            if (btn->count[1] + 1 >= btn->size[BUTTON_LONG_PRESS_UP])
+                            if (btn->count[1] + 1 >= BUTTON_CB_NUM(btn, BUTTON_LONG_PRESS_UP))
                                 break;
                         } while (time == cb_info[btn->count[1] + 1].event_data.long_press.press_time);
                     }
                 }
             }
         } else { //releasd
+            /**< repeats still waiting for a coalesced callback are delivered before the release */
+            if (btn->hold_pending) {
+                button_hold_dispatch(btn);
+            }
 
             btn->event = BUTTON_LONG_PRESS_UP;
 
             /** calling callbacks for BUTTON_LONG_PRESS_UP press_time */
-            if (btn->cb_info[btn->event] && btn->count[1] >= 0) {
-                button_cb_info_t *cb_info = btn->cb_info[btn->event];
+            if (btn->count[1] >= BUTTON_CB_NUM(btn, btn->event)) {
+                /**< callbacks were unregistered during the long press */
+                btn->count[1] = BUTTON_CB_NUM(btn, btn->event) - 1;
+            }
+            if (BUTTON_CB_PRESENT(btn, btn->event) && btn->count[1] >= 0) {
+                button_cb_info_t *cb_info = BUTTON_CB_INFO(btn, btn->event);
+                button_event_info_t info;
+                button_fill_event_info(btn, &info);
                 do {
-                    cb_info[btn->count[1]].cb(btn, cb_info[btn->count[1]].usr_data);
+                    button_call_cb(btn, &cb_info[btn->count[1]], &info);
                     if (!btn->count[1])
                         break;
                     btn->count[1]--;
@@ -269,7 +788,7 @@ static void button_handler(button_dev_t *btn)
                 btn->count[1] = -1;
             }
             /** Reset counter */
-            if (btn->cb_info[BUTTON_LONG_PRESS_START]) {
+            if (BUTTON_CB_PRESENT(btn, BUTTON_LONG_PRESS_START)) {
                 btn->count[0] = 0;
             }
 
@@ -282,138 +801,440 @@ static void button_handler(button_dev_t *btn)
     }
 }
 
-static void button_cb(void *args)
+/**
+  * @brief  Encoder driver, the steps and velocity of a scan go through the callbacks of the buttons.
+  */
+static void BUTTON_SCAN_ATTR button_encoder_handler(button_dev_t *btn, uint64_t levels)
+{
+    uint8_t report = button_encoder_scan((button_encoder_t *)btn->hardware_data, levels);
+    btn->event = (uint8_t)BUTTON_NONE_PRESS;
+    if (report & BUTTON_ENCODER_REPORT_STEP) {
+        btn->event = (uint8_t)BUTTON_ENCODER_STEP;
+        CALL_EVENT_CB(BUTTON_ENCODER_STEP);
+    }
+    if (report & BUTTON_ENCODER_REPORT_VELOCITY) {
+        btn->event = (uint8_t)BUTTON_ENCODER_VELOCITY;
+        CALL_EVENT_CB(BUTTON_ENCODER_VELOCITY);
+    }
+}
+
+static void BUTTON_SCAN_ATTR button_cb(void *args)
 {
+#if CONFIG_BUTTON_SCAN_IRAM
+    /**< the interrupt timer scans the buttons read from IRAM, the task timer the others */
+    bool from_iram = (bool)(uintptr_t)args;
+#endif
     button_dev_t *target;
+    uint64_t levels = 0;
+    bool snapshot = false;
+    /**< the devices on a shared bus read it once per pass */
+    __atomic_add_fetch(&g_scan_epoch, 1, __ATOMIC_RELAXED);
     for (target = g_head_handle; target; target = target->next) {
+#if CONFIG_BUTTON_SCAN_IRAM
+        if (BUTTON_READ_FROM_IRAM(target) != from_iram) {
+            continue;
+        }
+#endif
+        if (BUTTON_TYPE_ENCODER == target->type) {
+            /**< the encoders of a scan share one read of the GPIO inputs */
+            if (!snapshot) {
+                levels = button_gpio_snapshot();
+                snapshot = true;
+            }
+            button_encoder_handler(target, levels);
+            continue;
+        }
+        /**< an idle virtual button has nothing to do until a level is injected */
+        if (BUTTON_TYPE_VIRTUAL == target->type && 0 == target->state &&
+                !button_virtual_pending((button_virtual_mailbox_t *)target->hardware_data)) {
+            continue;
+        }
         button_handler(target);
     }
+#if CONFIG_BUTTON_SCAN_IRAM
+    if (from_iram && g_cb_woken) {
+        g_cb_woken = pdFALSE;
+        esp_timer_isr_dispatch_need_yield();
+    }
+#endif
 }
 
-static button_dev_t *button_create_com(uint8_t active_level, uint8_t (*hal_get_key_state)(void *hardware_data), void *hardware_data, uint16_t long_press_ticks, uint16_t short_press_ticks)
+uint32_t button_scan_epoch(void)
 {
-    BTN_CHECK(NULL != hal_get_key_state, "Function pointer is invalid", NULL);
+    return __atomic_load_n(&g_scan_epoch, __ATOMIC_RELAXED);
+}
 
-    button_dev_t *btn = (button_dev_t *) calloc(1, sizeof(button_dev_t));
-    BTN_CHECK(NULL != btn, "Button memory alloc failed", NULL);
-    btn->hardware_data = hardware_data;
-    btn->event = BUTTON_NONE_PRESS;
-    btn->active_level = active_level;
-    btn->hal_button_Level = hal_get_key_state;
-    btn->button_level = !active_level;
-    btn->long_press_ticks = long_press_ticks;
-    btn->long_press_ticks_default = btn->long_press_ticks;
-    btn->short_press_ticks = short_press_ticks;
+#define HANDLE_INDEX(handle)        ((uint32_t)(uintptr_t)(handle) & 0xffff)
+#define HANDLE_GENERATION(handle)   ((uint32_t)(uintptr_t)(handle) >> 16)
 
-    /** Add handle to list */
-    btn->next = g_head_handle;
-    g_head_handle = btn;
+/**
+  * @brief  Slot of a handle index, chunk k holds the indexes from SLOT_TABLE_MIN * (2^k - 1) + 1.
+  */
+static inline button_slot_t *button_slot_at(uint32_t index)
+{
+    uint32_t i = index - 1;
+    uint32_t chunk = 31 - __builtin_clz(i / SLOT_TABLE_MIN + 1);
+    return &g_slot_chunks[chunk][i - SLOT_TABLE_MIN * ((1U << chunk) - 1)];
+}
 
-    if (false == g_is_timer_running) {
-        esp_timer_create_args_t button_timer;
-        button_timer.arg = NULL;
-        button_timer.callback = button_cb;
-        button_timer.dispatch_method = ESP_TIMER_TASK;
-        button_timer.name = "button_timer";
-        esp_timer_create(&button_timer, &g_button_timer_handle);
-        esp_timer_start_periodic(g_button_timer_handle, TICKS_INTERVAL * 1000U);
-        g_is_timer_running = true;
+/**
+  * @brief  Find the button of a handle, NULL if the handle is invalid or the button has been deleted.
+  *         Lock free: the chunks are never moved and are released only once no lookup is in progress.
+  */
+static inline button_dev_t *button_get_dev(button_handle_t handle)
+{
+    button_dev_t *btn = NULL;
+    uint32_t index = HANDLE_INDEX(handle);
+    __atomic_add_fetch(&g_slot_lookups, 1, __ATOMIC_SEQ_CST);
+    if (index != 0 && index <= __atomic_load_n(&g_slot_num, __ATOMIC_SEQ_CST)) {
+        button_slot_t *slot = button_slot_at(index);
+        if (SLOT_TAG_GENERATION(__atomic_load_n(&slot->tag, __ATOMIC_ACQUIRE)) == HANDLE_GENERATION(handle)) {
+            btn = slot->btn;
+        }
     }
-
+    __atomic_sub_fetch(&g_slot_lookups, 1, __ATOMIC_RELEASE);
     return btn;
 }
 
-static esp_err_t button_delete_com(button_dev_t *btn)
+/**
+  * @brief  Find the slot of a handle and claim it, NULL if the handle is invalid or the button has been deleted.
+  *         The button is not deleted before button_slot_unclaim(), and claims of different buttons never contend.
+  */
+static button_slot_t *button_slot_claim(button_handle_t handle)
 {
-    BTN_CHECK(NULL != btn, "Pointer of handle is invalid", ESP_ERR_INVALID_ARG);
-
-    button_dev_t **curr;
-    for (curr = &g_head_handle; *curr; ) {
-        button_dev_t *entry = *curr;
-        if (entry == btn) {
-            *curr = entry->next;
-            free(entry);
-        } else {
-            curr = &entry->next;
+    button_slot_t *claimed = NULL;
+    uint32_t index = HANDLE_INDEX(handle);
+    __atomic_add_fetch(&g_slot_lookups, 1, __ATOMIC_SEQ_CST);
+    if (index != 0 && index <= __atomic_load_n(&g_slot_num, __ATOMIC_SEQ_CST)) {
+        button_slot_t *slot = button_slot_at(index);
+        uint32_t tag = __atomic_load_n(&slot->tag, __ATOMIC_RELAXED);
+        while (SLOT_TAG_GENERATION(tag) == HANDLE_GENERATION(handle)) {
+            if (__atomic_compare_exchange_n(&slot->tag, &tag, tag + 1, true, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+                claimed = slot;
+                break;
+            }
         }
     }
+    __atomic_sub_fetch(&g_slot_lookups, 1, __ATOMIC_RELEASE);
+    return claimed;
+}
+
+static inline void button_slot_unclaim(button_slot_t *slot)
+{
+    __atomic_sub_fetch(&slot->tag, 1, __ATOMIC_RELEASE);
+}
 
-    /* count button number */
-    uint16_t number = 0;
-    button_dev_t *target = g_head_handle;
-    while (target) {
-        target = target->next;
-        number++;
+static esp_err_t button_slot_alloc(button_dev_t *btn)
+{
+    if (!g_slot_free) {
+        uint32_t chunk = 31 - __builtin_clz(g_slot_num / SLOT_TABLE_MIN + 1);
+        BTN_CHECK(chunk < SLOT_CHUNK_NUM, "Too many buttons", ESP_ERR_NO_MEM);
+        /**< grown by a new chunk, the slots in use never move under a lookup */
+        uint32_t size = SLOT_TABLE_MIN << chunk;
+        button_slot_t *slots = malloc(size * sizeof(button_slot_t));
+        BTN_CHECK(NULL != slots, "Slot table alloc failed", ESP_ERR_NO_MEM);
+        for (uint32_t i = 0; i < size; i++) {
+            slots[i].btn = NULL;
+            slots[i].tag = 0;
+            slots[i].next_free = (i + 1 < size) ? g_slot_num + i + 2 : 0;
+        }
+        SLOT_ENTER_CRITICAL();
+        g_slot_chunks[chunk] = slots;
+        g_slot_free = g_slot_num + 1;
+        __atomic_store_n(&g_slot_num, g_slot_num + size, __ATOMIC_SEQ_CST);
+        SLOT_EXIT_CRITICAL();
     }
-    ESP_LOGD(TAG, "remain btn number=%d", number);
 
-    if (0 == number && g_is_timer_running) { /**<  if all button is deleted, stop the timer */
-        esp_timer_stop(g_button_timer_handle);
-        esp_timer_delete(g_button_timer_handle);
-        g_is_timer_running = false;
+    /**< a global generation, so a stale handle stays invalid even after the table is released */
+    if (0 == ++g_generation) {
+        g_generation = 1;
     }
+    SLOT_ENTER_CRITICAL();
+    uint16_t index = g_slot_free;
+    button_slot_t *slot = button_slot_at(index);
+    g_slot_free = slot->next_free;
+    slot->btn = btn;
+    __atomic_store_n(&slot->tag, (uint32_t)g_generation << 16, __ATOMIC_RELEASE);
+    SLOT_EXIT_CRITICAL();
+    btn->handle = (button_handle_t)(uintptr_t)((uint32_t)g_generation << 16 | index);
     return ESP_OK;
 }
 
-button_handle_t iot_button_create(const button_config_t *config)
+static void button_slot_free(button_dev_t *btn)
 {
-    ESP_LOGI(TAG, "IoT Button Version: %d.%d.%d", BUTTON_VER_MAJOR, BUTTON_VER_MINOR, BUTTON_VER_PATCH);
-    BTN_CHECK(config, "Invalid button config", NULL);
+    uint16_t index = HANDLE_INDEX(btn->handle);
+    button_slot_t *slot = button_slot_at(index);
+    /**< new claims fail once the generation is cleared, the claims in progress are waited for */
+    __atomic_fetch_and(&slot->tag, 0xffff, __ATOMIC_ACQ_REL);
+    while (SLOT_TAG_CLAIMS(__atomic_load_n(&slot->tag, __ATOMIC_ACQUIRE))) {
+        vTaskDelay(1);
+    }
+    SLOT_ENTER_CRITICAL();
+    slot->btn = NULL;
+    slot->next_free = g_slot_free;
+    g_slot_free = index;
+    SLOT_EXIT_CRITICAL();
+}
 
-    esp_err_t ret = ESP_OK;
-    button_dev_t *btn = NULL;
-    uint16_t long_press_time = 0;
-    uint16_t short_press_time = 0;
-    long_press_time = TIME_TO_TICKS(config->long_press_time, LONG_TICKS);
-    short_press_time = TIME_TO_TICKS(config->short_press_time, SHORT_TICKS);
-    switch (config->type) {
-    case BUTTON_TYPE_GPIO: {
-        const button_gpio_config_t *cfg = &(config->gpio_button_config);
-        ret = button_gpio_init(cfg);
-        BTN_CHECK(ESP_OK == ret, "gpio button init failed", NULL);
-        btn = button_create_com(cfg->active_level, button_gpio_get_key_level, (void *)cfg->gpio_num, long_press_time, short_press_time);
-    } break;
-    case BUTTON_TYPE_ADC: {
+/**
+  * @brief  Release the slot table once the last button is deleted. The table is emptied under the lock,
+  *         then freed once the lookups of stale handles that read it have returned.
+  *         The generation is global, so stale handles stay invalid in the next table.
+  */
+static void button_slot_release(void)
+{
+    SLOT_ENTER_CRITICAL();
+    __atomic_store_n(&g_slot_num, 0, __ATOMIC_SEQ_CST);
+    g_slot_free = 0;
+    SLOT_EXIT_CRITICAL();
+    while (__atomic_load_n(&g_slot_lookups, __ATOMIC_SEQ_CST)) {
+        vTaskDelay(1);
+    }
+    for (int i = 0; i < SLOT_CHUNK_NUM; i++) {
+        free(g_slot_chunks[i]);
+        g_slot_chunks[i] = NULL;
+    }
+}
+
+static esp_err_t button_init_com(button_dev_t *btn, uint8_t active_level, uint8_t (*hal_get_key_state)(void *hardware_data), void *hardware_data, uint16_t long_press_ticks, uint16_t short_press_ticks)
+{
+    BTN_CHECK(NULL != hal_get_key_state, "Function pointer is invalid", ESP_ERR_INVALID_ARG);
+
+    btn->hardware_data = hardware_data;
+    btn->event = BUTTON_NONE_PRESS;
+    btn->active_level = active_level;
+    btn->hal_button_Level = hal_get_key_state;
+    button_debounce_init(&btn->debounce, BUTTON_DEBOUNCE_SOFTWARE, -1, !active_level);
+    btn->timing.long_press_ticks = long_press_ticks;
+    btn->long_press_ticks_default = long_press_ticks;
+    btn->timing.short_press_ticks = short_press_ticks;
+    btn->timing.serial_ticks = SERIAL_TICKS;
+    btn->timing.tolerance_ms = TOLERANCE;
+    btn->click_limit = BUTTON_MAX_CLICKS_WINDOW;
+    return ESP_OK;
+}
+
+static esp_err_t button_timer_start(void)
+{
+    esp_err_t err = esp_timer_start_periodic(g_button_timer_handle, TICKS_INTERVAL * 1000U);
+#if CONFIG_BUTTON_SCAN_IRAM
+    if (ESP_OK == err) {
+        err = esp_timer_start_periodic(g_button_task_timer_handle, TICKS_INTERVAL * 1000U);
+    }
+#endif
+    return err;
+}
+
+static esp_err_t button_timer_stop(void)
+{
+    esp_err_t err = esp_timer_stop(g_button_timer_handle);
+#if CONFIG_BUTTON_SCAN_IRAM
+    esp_timer_stop(g_button_task_timer_handle);
+#endif
+    return err;
+}
+
+/**
+  * @brief  Add a chain of buttons linked by next to the list, and start the timer if needed.
+  */
+static void button_list_add(button_dev_t *first, button_dev_t *last, uint16_t num)
+{
+    first->prev = NULL;
+    last->next = g_head_handle;
+    if (g_head_handle) {
+        g_head_handle->prev = last;
+    }
+    g_head_handle = first;
+    g_button_num += num;
+
+    /**< a button created while the scan is stopped or sleeping is scanned once it resumes */
+    if (NULL == g_button_timer_handle) {
+        esp_timer_create_args_t button_timer;
+        button_timer.arg = NULL;
+        button_timer.callback = button_cb;
+        button_timer.dispatch_method = ESP_TIMER_TASK;
+        button_timer.name = "button_timer";
+#if CONFIG_BUTTON_SCAN_IRAM
+        esp_timer_create(&button_timer, &g_button_task_timer_handle);
+        button_timer.arg = (void *)true;
+        button_timer.dispatch_method = ESP_TIMER_ISR;
+        button_timer.name = "button_isr_timer";
+#endif
+        esp_timer_create(&button_timer, &g_button_timer_handle);
+        button_timer_start();
+        g_is_timer_running = true;
+    }
+}
+
+static esp_err_t button_delete_com(button_dev_t *btn)
+{
+    BTN_CHECK(NULL != btn, "Pointer of handle is invalid", ESP_ERR_INVALID_ARG);
+
+    if (btn->prev) {
+        btn->prev->next = btn->next;
+    } else {
+        g_head_handle = btn->next;
+    }
+    if (btn->next) {
+        btn->next->prev = btn->prev;
+    }
+    if (btn->group) {
+        /**< the memory belongs to the group, only mark the button as deleted */
+        btn->hal_button_Level = NULL;
+    } else {
+        free(btn);
+    }
+
+    g_button_num--;
+    ESP_LOGD(TAG, "remain btn number=%d", g_button_num);
+
+    if (0 == g_button_num) {
+        button_slot_release();
+        if (g_button_timer_handle) { /**<  if all button is deleted, delete the timer, even stopped or sleeping */
+            if (g_is_timer_running) {
+                button_timer_stop();
+            }
+            esp_timer_delete(g_button_timer_handle);
+#if CONFIG_BUTTON_SCAN_IRAM
+            esp_timer_delete(g_button_task_timer_handle);
+            g_button_task_timer_handle = NULL;
+#endif
+            g_button_timer_handle = NULL;
+            g_is_timer_running = false;
+        }
+        button_cb_lanes_stop();
+    }
+    return ESP_OK;
+}
+
+static void button_log_version(void)
+{
+    static bool logged = false;
+    if (!logged) {
+        ESP_LOGI(TAG, "IoT Button Version: %d.%d.%d", BUTTON_VER_MAJOR, BUTTON_VER_MINOR, BUTTON_VER_PATCH);
+        logged = true;
+    }
+}
+
+/**
+  * @brief  Initialize the hardware and the fields of a button, without adding it to the list.
+  *         gpio_configured is set when the GPIO of a GPIO button was already configured by the caller.
+  */
+static esp_err_t button_setup(button_dev_t *btn, const button_config_t *config, bool gpio_configured)
+{
+    esp_err_t ret = ESP_OK;
+    uint16_t long_press_time = 0;
+    uint16_t short_press_time = 0;
+    long_press_time = TIME_TO_TICKS(config->long_press_time, LONG_TICKS);
+    short_press_time = TIME_TO_TICKS(config->short_press_time, SHORT_TICKS);
+    switch (config->type) {
+    case BUTTON_TYPE_GPIO: {
+        const button_gpio_config_t *cfg = &(config->gpio_button_config);
+        if (!gpio_configured) {
+            ret = button_gpio_init(cfg);
+            BTN_CHECK(ESP_OK == ret, "gpio button init failed", ret);
+        }
+        ret = button_init_com(btn, cfg->active_level, button_gpio_get_key_level, (void *)cfg->gpio_num, long_press_time, short_press_time);
+        if (ESP_OK == ret && BUTTON_DEBOUNCE_SOFTWARE != cfg->debounce) {
+            if (ESP_OK != button_debounce_init(&btn->debounce, cfg->debounce, cfg->gpio_num, !cfg->active_level)) {
+                ESP_LOGW(TAG, "GPIO%d debounce backend init failed, use software debounce", (int)cfg->gpio_num);
+            }
+        }
+    } break;
+    case BUTTON_TYPE_ADC: {
         const button_adc_config_t *cfg = &(config->adc_button_config);
         ret = button_adc_init(cfg);
-        BTN_CHECK(ESP_OK == ret, "adc button init failed", NULL);
-        btn = button_create_com(1, button_adc_get_key_level, (void *)ADC_BUTTON_COMBINE(cfg->adc_channel, cfg->button_index), long_press_time, short_press_time);
+        BTN_CHECK(ESP_OK == ret, "adc button init failed", ret);
+        ret = button_init_com(btn, 1, button_adc_get_key_level, (void *)ADC_BUTTON_COMBINE(cfg->adc_channel, cfg->button_index), long_press_time, short_press_time);
     } break;
     case BUTTON_TYPE_MATRIX: {
         const button_matrix_config_t *cfg = &(config->matrix_button_config);
         ret = button_matrix_init(cfg);
-        BTN_CHECK(ESP_OK == ret, "matrix button init failed", NULL);
-        btn = button_create_com(1, button_matrix_get_key_level, (void *)MATRIX_BUTTON_COMBINE(cfg->row_gpio_num, cfg->col_gpio_num), long_press_time, short_press_time);
+        BTN_CHECK(ESP_OK == ret, "matrix button init failed", ret);
+        ret = button_init_com(btn, 1, button_matrix_get_key_level, (void *)MATRIX_BUTTON_COMBINE(cfg->row_gpio_num, cfg->col_gpio_num), long_press_time, short_press_time);
     } break;
     case BUTTON_TYPE_CUSTOM: {
         if (config->custom_button_config.button_custom_init) {
             ret = config->custom_button_config.button_custom_init(config->custom_button_config.priv);
-            BTN_CHECK(ESP_OK == ret, "custom button init failed", NULL);
+            BTN_CHECK(ESP_OK == ret, "custom button init failed", ret);
         }
 
-        btn = button_create_com(config->custom_button_config.active_level,
-                                config->custom_button_config.button_custom_get_key_value,
-                                config->custom_button_config.priv,
-                                long_press_time, short_press_time);
-        if (btn) {
-            btn->hal_button_deinit = config->custom_button_config.button_custom_deinit;
+        ret = button_init_com(btn, config->custom_button_config.active_level,
+                              config->custom_button_config.button_custom_get_key_value,
+                              config->custom_button_config.priv,
+                              long_press_time, short_press_time);
+        btn->hal_button_deinit = config->custom_button_config.button_custom_deinit;
+    } break;
+    case BUTTON_TYPE_VIRTUAL: {
+        button_virtual_mailbox_t *mailbox = NULL;
+        ret = button_virtual_init(&config->virtual_button_config, &mailbox);
+        BTN_CHECK(ESP_OK == ret, "virtual button init failed", ret);
+        ret = button_init_com(btn, config->virtual_button_config.active_level, button_virtual_get_key_level, mailbox, long_press_time, short_press_time);
+        if (ESP_OK != ret) {
+            button_virtual_deinit(mailbox);
+        }
+    } break;
+    case BUTTON_TYPE_EXPANDER: {
+        const button_expander_config_t *cfg = &(config->expander_button_config);
+        void *hardware_data = NULL;
+        ret = button_expander_init(cfg, &hardware_data);
+        BTN_CHECK(ESP_OK == ret, "expander button init failed", ret);
+        ret = button_init_com(btn, cfg->active_level, button_expander_get_key_level, hardware_data, long_press_time, short_press_time);
+        if (ESP_OK != ret) {
+            button_expander_deinit(hardware_data);
+        }
+    } break;
+    case BUTTON_TYPE_SHIFT_REG: {
+        const button_shift_config_t *cfg = &(config->shift_button_config);
+        void *hardware_data = NULL;
+        ret = button_shift_init(cfg, &hardware_data);
+        BTN_CHECK(ESP_OK == ret, "shift register button init failed", ret);
+        ret = button_init_com(btn, cfg->active_level, button_shift_get_key_level, hardware_data, long_press_time, short_press_time);
+        if (ESP_OK != ret) {
+            button_shift_deinit(hardware_data);
+        }
+    } break;
+    case BUTTON_TYPE_TOUCH: {
+        const button_touch_config_t *cfg = &(config->touch_button_config);
+        ret = button_touch_init(cfg);
+        BTN_CHECK(ESP_OK == ret, "touch button init failed", ret);
+        ret = button_init_com(btn, 1, button_touch_get_key_level, (void *)cfg->touch_pad, long_press_time, short_press_time);
+        if (ESP_OK != ret) {
+            button_touch_deinit(cfg->touch_pad);
+        }
+    } break;
+    case BUTTON_TYPE_ENCODER: {
+        button_encoder_t *encoder = NULL;
+        ret = button_encoder_init(&config->encoder_config, &encoder);
+        BTN_CHECK(ESP_OK == ret, "encoder init failed", ret);
+        ret = button_init_com(btn, 1, button_encoder_get_key_level, encoder, long_press_time, short_press_time);
+        if (ESP_OK != ret) {
+            button_encoder_deinit(encoder);
         }
     } break;
 
     default:
         ESP_LOGE(TAG, "Unsupported button type");
+        ret = ESP_ERR_NOT_SUPPORTED;
         break;
     }
-    BTN_CHECK(NULL != btn, "button create failed", NULL);
+    BTN_CHECK(ESP_OK == ret, "button create failed", ret);
     btn->type = config->type;
-    return (button_handle_t)btn;
+    if (ESP_OK != button_debounce_set_algo(&btn->debounce, &config->debounce_config)) {
+        ESP_LOGW(TAG, "Invalid debounce config, use the default counter");
+    }
+    btn->timing.debounce_ticks[0] = btn->debounce.ticks[0];
+    btn->timing.debounce_ticks[1] = btn->debounce.ticks[1];
+    button_hold_timing(&btn->timing, &config->hold_config);
+    /**< not scanned yet, the scan fields are set at once */
+    button_timing_apply(btn, &btn->timing);
+    return ESP_OK;
 }
 
-esp_err_t iot_button_delete(button_handle_t btn_handle)
+static esp_err_t button_deinit_hw(button_dev_t *btn)
 {
     esp_err_t ret = ESP_OK;
-    BTN_CHECK(NULL != btn_handle, "Pointer of handle is invalid", ESP_ERR_INVALID_ARG);
-    button_dev_t *btn = (button_dev_t *)btn_handle;
+    button_debounce_deinit(&btn->debounce);
     switch (btn->type) {
     case BUTTON_TYPE_GPIO:
         ret = button_gpio_deinit((int)(btn->hardware_data));
@@ -429,24 +1250,312 @@ esp_err_t iot_button_delete(button_handle_t btn_handle)
             ret = btn->hal_button_deinit(btn->hardware_data);
         }
 
+        break;
+    case BUTTON_TYPE_VIRTUAL:
+        ret = button_virtual_deinit((button_virtual_mailbox_t *)btn->hardware_data);
+        break;
+    case BUTTON_TYPE_EXPANDER:
+        ret = button_expander_deinit(btn->hardware_data);
+        break;
+    case BUTTON_TYPE_SHIFT_REG:
+        ret = button_shift_deinit(btn->hardware_data);
+        break;
+    case BUTTON_TYPE_TOUCH:
+        ret = button_touch_deinit((int32_t)btn->hardware_data);
+        break;
+    case BUTTON_TYPE_ENCODER:
+        ret = button_encoder_deinit((button_encoder_t *)btn->hardware_data);
         break;
     default:
         break;
     }
-    BTN_CHECK(ESP_OK == ret, "button deinit failed", ESP_FAIL);
-    for (int i = 0; i < BUTTON_EVENT_MAX; i++) {
-        if (btn->cb_info[i]) {
-            free(btn->cb_info[i]);
-        }
+    return ret;
+}
+
+static esp_err_t button_delete_dev(button_dev_t *btn);
+
+button_handle_t iot_button_create(const button_config_t *config)
+{
+    button_log_version();
+    BTN_CHECK(config, "Invalid button config", NULL);
+
+    button_dev_t *btn = (button_dev_t *) calloc(1, sizeof(button_dev_t));
+    BTN_CHECK(NULL != btn, "Button memory alloc failed", NULL);
+    if (ESP_OK != button_setup(btn, config, false)) {
+        free(btn);
+        return NULL;
     }
+    if (ESP_OK != button_slot_alloc(btn)) {
+        button_deinit_hw(btn);
+        free(btn);
+        return NULL;
+    }
+    button_list_add(btn, btn, 1);
+    return btn->handle;
+}
+
+esp_err_t iot_button_delete(button_handle_t btn_handle)
+{
+    button_dev_t *btn = button_get_dev(btn_handle);
+    BTN_CHECK(NULL != btn, "Pointer of handle is invalid", ESP_ERR_INVALID_ARG);
+    return button_delete_dev(btn);
+}
+
+static esp_err_t button_delete_dev(button_dev_t *btn)
+{
+    /**< the handle is invalidated first, so iot_button_inject_level() never posts to a released mailbox */
+    button_slot_free(btn);
+    esp_err_t ret = button_deinit_hw(btn);
+    if (ESP_OK != ret) {
+        ESP_LOGE(TAG, "button deinit failed");
+    }
+    if (!btn->cb_shared) {
+        free(btn->cb_table);
+    }
+    btn->cb_table = NULL;
     button_delete_com(btn);
+    return ESP_OK == ret ? ESP_OK : ESP_FAIL;
+}
+
+button_group_handle_t iot_button_create_group(const button_config_t *configs, size_t num, button_handle_t *handles)
+{
+    button_log_version();
+    BTN_CHECK(NULL != configs && num > 0, "Invalid button config", NULL);
+
+    /** configure the GPIO buttons with one gpio_config() per active level */
+    uint64_t pin_bit_mask[2] = {0};
+    for (size_t i = 0; i < num; i++) {
+        if (BUTTON_TYPE_GPIO == configs[i].type) {
+            const button_gpio_config_t *cfg = &configs[i].gpio_button_config;
+            BTN_CHECK(GPIO_IS_VALID_GPIO(cfg->gpio_num), "GPIO number error", NULL);
+            pin_bit_mask[!!cfg->active_level] |= (1ULL << cfg->gpio_num);
+        }
+    }
+    for (int level = 0; level < 2; level++) {
+        if (pin_bit_mask[level]) {
+            BTN_CHECK(ESP_OK == button_gpio_init_mask(pin_bit_mask[level], level), "gpio button init failed", NULL);
+        }
+    }
+
+    button_group_t *group = (button_group_t *) calloc(1, sizeof(button_group_t) + num * sizeof(button_dev_t));
+    BTN_CHECK(NULL != group, "Button group memory alloc failed", NULL);
+    group->num = num;
+    group->proto.short_press_ticks = SHORT_TICKS;
+    group->proto.long_press_ticks = LONG_TICKS;
+    group->proto.long_press_ticks_default = LONG_TICKS;
+
+    for (size_t i = 0; i < num; i++) {
+        button_dev_t *btn = &group->btns[i];
+        if (ESP_OK != button_setup(btn, &configs[i], true)) {
+            while (i--) {
+                button_deinit_hw(&group->btns[i]);
+                button_slot_free(&group->btns[i]);
+            }
+            free(group);
+            return NULL;
+        }
+        if (ESP_OK != button_slot_alloc(btn)) {
+            button_deinit_hw(btn);
+            while (i--) {
+                button_deinit_hw(&group->btns[i]);
+                button_slot_free(&group->btns[i]);
+            }
+            free(group);
+            return NULL;
+        }
+        btn->group = group;
+        btn->prev = (i > 0) ? &group->btns[i - 1] : NULL;
+        btn->next = (i + 1 < num) ? &group->btns[i + 1] : NULL;
+        if (handles) {
+            handles[i] = btn->handle;
+        }
+    }
+    button_list_add(&group->btns[0], &group->btns[num - 1], num);
+    return (button_group_handle_t)group;
+}
+
+esp_err_t iot_button_delete_group(button_group_handle_t group_handle)
+{
+    BTN_CHECK(NULL != group_handle, "Pointer of group handle is invalid", ESP_ERR_INVALID_ARG);
+    button_group_t *group = (button_group_t *)group_handle;
+
+    for (size_t i = 0; i < group->num; i++) {
+        if (group->btns[i].hal_button_Level) {
+            button_delete_dev(&group->btns[i]);
+        }
+    }
+    free(group->proto.cb_table);
+    free(group);
+    if (0 == g_button_num) {
+        /**< callbacks may have been registered on the group after all its buttons were deleted */
+        button_cb_lanes_stop();
+    }
     return ESP_OK;
 }
 
+esp_err_t iot_button_group_register_event_cb(button_group_handle_t group_handle, button_event_config_t event_cfg, button_cb_t cb, void *usr_data)
+{
+    BTN_CHECK(NULL != group_handle, "Pointer of group handle is invalid", ESP_ERR_INVALID_ARG);
+    button_group_t *group = (button_group_t *)group_handle;
+    button_event_t event = event_cfg.event;
+    BTN_CHECK(event < BUTTON_EVENT_MAX, "event is invalid", ESP_ERR_INVALID_ARG);
+    for (size_t i = 0; i < group->num; i++) {
+        button_dev_t *btn = &group->btns[i];
+        if (btn->cb_table && !btn->cb_shared) {
+            button_cb_info_t *cb_info = BUTTON_CB_INFO(btn, event);
+            for (int j = 0; j < BUTTON_CB_NUM(btn, event); j++) {
+                BTN_CHECK(cb_info[j].from_group, "A button of the group has its own callbacks for the event", ESP_ERR_INVALID_STATE);
+            }
+        }
+    }
+
+    if ((event == BUTTON_LONG_PRESS_START || event == BUTTON_LONG_PRESS_UP) && !event_cfg.event_data.long_press.press_time) {
+        event_cfg.event_data.long_press.press_time = group->proto.long_press_ticks_default * TICKS_INTERVAL;
+    }
+    bool group_present = BUTTON_CB_PRESENT(&group->proto, event);
+    esp_err_t ret = button_register_com(&group->proto, event_cfg, cb, false, usr_data);
+    if (ESP_OK != ret) {
+        return ret;
+    }
+
+    /** the table may have moved, point the buttons sharing it to it again, the others get a copy of the callback */
+    button_cb_info_t record = {
+        .cb = cb,
+        .usr_data = usr_data,
+        .event_data = event_cfg.event_data,
+        .from_group = 1,
+        .context = event_cfg.context,
+    };
+    int32_t press_ticks = event_cfg.event_data.long_press.press_time / TICKS_INTERVAL;
+    for (size_t i = 0; i < group->num; i++) {
+        button_dev_t *btn = &group->btns[i];
+        if (!btn->hal_button_Level) {
+            continue;
+        }
+        bool present;
+        if (!btn->cb_table || btn->cb_shared) {
+            /**< the shared table may have been freed by the registration */
+            present = btn->cb_shared && group_present;
+            btn->cb_table = group->proto.cb_table;
+            btn->cb_shared = 1;
+        } else {
+            present = BUTTON_CB_PRESENT(btn, event);
+            esp_err_t err = button_cb_insert(btn, event, button_cb_position(btn, event, &record), &record);
+            if (ESP_OK != err) {
+                ESP_LOGE(TAG, "button %d of the group misses the callback", (int)i);
+                ret = err;
+                continue;
+            }
+        }
+        if (!present) {
+            if (event == BUTTON_LONG_PRESS_START) {
+                btn->count[0] = 0;
+            } else if (event == BUTTON_LONG_PRESS_UP) {
+                btn->count[1] = -1;
+            }
+        }
+        button_update_clicks(btn);
+        if (event == BUTTON_LONG_PRESS_START || event == BUTTON_LONG_PRESS_UP) {
+            button_lower_long_press(btn, press_ticks);
+        }
+    }
+    return ret;
+}
+
+/**
+  * @brief  Give the button its own copy of the table shared with its group before modifying it.
+  */
+static esp_err_t button_unshare_cb(button_dev_t *btn)
+{
+    if (!btn->cb_shared) {
+        return ESP_OK;
+    }
+    size_t num = btn->cb_table->first[BUTTON_EVENT_MAX];
+    size_t bytes = sizeof(button_cb_table_t) + num * sizeof(button_cb_info_t);
+    button_cb_table_t *p = malloc(bytes);
+    BTN_CHECK(NULL != p, "malloc cb_table failed", ESP_ERR_NO_MEM);
+    memcpy(p, btn->cb_table, bytes);
+    for (size_t i = 0; i < num; i++) {
+        p->records[i].from_group = 1;
+    }
+    btn->cb_table = p;
+    btn->cb_shared = 0;
+    return ESP_OK;
+}
+
+/**
+  * @brief  Index among the callbacks of the event where a record is inserted, sorted by press_time or clicks.
+  */
+static size_t button_cb_position(button_dev_t *btn, button_event_t event, const button_cb_info_t *record)
+{
+    button_cb_info_t *cb_info = BUTTON_CB_INFO(btn, event);
+    size_t pos = BUTTON_CB_NUM(btn, event);
+    if (event == BUTTON_LONG_PRESS_START || event == BUTTON_LONG_PRESS_UP) {
+        while (pos > 0 && cb_info[pos - 1].event_data.long_press.press_time > record->event_data.long_press.press_time) {
+            pos--;
+        }
+    } else if (event == BUTTON_MULTIPLE_CLICK) {
+        while (pos > 0 && cb_info[pos - 1].event_data.multiple_clicks.clicks > record->event_data.multiple_clicks.clicks) {
+            pos--;
+        }
+    }
+    return pos;
+}
+
+/**
+  * @brief  Insert a record at index pos among the callbacks of the event, the table must not be shared.
+  */
+static esp_err_t button_cb_insert(button_dev_t *btn, button_event_t event, size_t pos, const button_cb_info_t *record)
+{
+    size_t num = btn->cb_table ? btn->cb_table->first[BUTTON_EVENT_MAX] : 0;
+    BTN_CHECK(num < BUTTON_CB_MAX_NUM, "Too many callbacks on the button", ESP_ERR_INVALID_SIZE);
+    button_cb_table_t *table = realloc(btn->cb_table, sizeof(button_cb_table_t) + (num + 1) * sizeof(button_cb_info_t));
+    BTN_CHECK(NULL != table, "realloc cb_table failed", ESP_ERR_NO_MEM);
+    if (!btn->cb_table) {
+        memset(table, 0, sizeof(button_cb_table_t));
+    }
+    size_t at = table->first[event] + pos;
+    memmove(&table->records[at + 1], &table->records[at], (num - at) * sizeof(button_cb_info_t));
+    table->records[at] = *record;
+    for (int i = event + 1; i <= BUTTON_EVENT_MAX; i++) {
+        table->first[i]++;
+    }
+    table->present |= BIT(event);
+    btn->cb_table = table;
+    return ESP_OK;
+}
+
+/**
+  * @brief  Remove n records from index pos among the callbacks of the event, the table must not be shared.
+  */
+static void button_cb_remove(button_dev_t *btn, button_event_t event, size_t pos, size_t n)
+{
+    button_cb_table_t *table = btn->cb_table;
+    size_t num = table->first[BUTTON_EVENT_MAX] - n;
+    size_t at = table->first[event] + pos;
+    memmove(&table->records[at], &table->records[at + n], (num - at) * sizeof(button_cb_info_t));
+    for (int i = event + 1; i <= BUTTON_EVENT_MAX; i++) {
+        table->first[i] -= n;
+    }
+    if (table->first[event] == table->first[event + 1]) {
+        table->present &= ~BIT(event);
+    }
+    if (0 == num) {
+        free(table);
+        btn->cb_table = NULL;
+        return;
+    }
+    /**< keep the larger table if shrinking fails */
+    table = realloc(table, sizeof(button_cb_table_t) + num * sizeof(button_cb_info_t));
+    if (table) {
+        btn->cb_table = table;
+    }
+}
+
 esp_err_t iot_button_register_cb(button_handle_t btn_handle, button_event_t event, button_cb_t cb, void *usr_data)
 {
-    BTN_CHECK(NULL != btn_handle, "Pointer of handle is invalid", ESP_ERR_INVALID_ARG);
-    button_dev_t *btn = (button_dev_t *) btn_handle;
+    button_dev_t *btn = button_get_dev(btn_handle);
+    BTN_CHECK(NULL != btn, "Pointer of handle is invalid", ESP_ERR_INVALID_ARG);
     BTN_CHECK(event != BUTTON_MULTIPLE_CLICK, "event argument is invalid", ESP_ERR_INVALID_ARG);
     button_event_config_t event_cfg = {
         .event = event,
@@ -461,221 +1570,342 @@ esp_err_t iot_button_register_cb(button_handle_t btn_handle, button_event_t even
 
 esp_err_t iot_button_register_event_cb(button_handle_t btn_handle, button_event_config_t event_cfg, button_cb_t cb, void *usr_data)
 {
-    BTN_CHECK(NULL != btn_handle, "Pointer of handle is invalid", ESP_ERR_INVALID_ARG);
-    button_dev_t *btn = (button_dev_t *) btn_handle;
+    button_dev_t *btn = button_get_dev(btn_handle);
+    BTN_CHECK(NULL != btn, "Pointer of handle is invalid", ESP_ERR_INVALID_ARG);
+    return button_register_com(btn, event_cfg, cb, false, usr_data);
+}
+
+esp_err_t iot_button_register_info_cb(button_handle_t btn_handle, button_event_config_t event_cfg, button_event_cb_t cb, void *usr_data)
+{
+    button_dev_t *btn = button_get_dev(btn_handle);
+    BTN_CHECK(NULL != btn, "Pointer of handle is invalid", ESP_ERR_INVALID_ARG);
+    if ((event_cfg.event == BUTTON_LONG_PRESS_START || event_cfg.event == BUTTON_LONG_PRESS_UP) && !event_cfg.event_data.long_press.press_time) {
+        event_cfg.event_data.long_press.press_time = btn->long_press_ticks_default * TICKS_INTERVAL;
+    }
+    return button_register_com(btn, event_cfg, (button_cb_t)cb, true, usr_data);
+}
+
+static esp_err_t button_register_com(button_dev_t *btn, button_event_config_t event_cfg, button_cb_t cb, bool typed, void *usr_data)
+{
     button_event_t event = event_cfg.event;
     BTN_CHECK(event < BUTTON_EVENT_MAX, "event is invalid", ESP_ERR_INVALID_ARG);
     BTN_CHECK(!(event == BUTTON_LONG_PRESS_START || event == BUTTON_LONG_PRESS_UP) || event_cfg.event_data.long_press.press_time > btn->short_press_ticks * TICKS_INTERVAL, "event_data is invalid", ESP_ERR_INVALID_ARG);
+    BTN_CHECK(!(event == BUTTON_LONG_PRESS_START || event == BUTTON_LONG_PRESS_UP) || event_cfg.event_data.long_press.press_time / TICKS_INTERVAL > btn->short_press_ticks, "press_time event_data is less than short_press_ticks", ESP_ERR_INVALID_ARG);
     BTN_CHECK(event != BUTTON_MULTIPLE_CLICK || event_cfg.event_data.multiple_clicks.clicks, "event_data is invalid", ESP_ERR_INVALID_ARG);
-
-    if (!btn->cb_info[event]) {
-        btn->cb_info[event] = calloc(1, sizeof(button_cb_info_t));
-        BTN_CHECK(NULL != btn->cb_info[event], "calloc cb_info failed", ESP_ERR_NO_MEM);
+    BTN_CHECK(event_cfg.context < BUTTON_CB_CONTEXT_MAX, "context is invalid", ESP_ERR_INVALID_ARG);
+    BTN_CHECK(ESP_OK == button_cb_lane_init(event_cfg.context), "callback context init failed", ESP_ERR_NO_MEM);
+    BTN_CHECK(ESP_OK == button_unshare_cb(btn), "unshare cb_table failed", ESP_ERR_NO_MEM);
+
+    button_cb_info_t record = {
+        .cb = cb,
+        .usr_data = usr_data,
+        .event_data = event_cfg.event_data,
+        .typed = typed,
+        .context = event_cfg.context,
+    };
+    bool present = BUTTON_CB_PRESENT(btn, event);
+    /** Inserting the event_data in sorted manner */
+    esp_err_t ret = button_cb_insert(btn, event, button_cb_position(btn, event, &record), &record);
+    BTN_CHECK(ESP_OK == ret, "insert callback failed", ret);
+    if (!present) {
         if (event == BUTTON_LONG_PRESS_START) {
             btn->count[0] = 0;
         } else if (event == BUTTON_LONG_PRESS_UP) {
             btn->count[1] = -1;
         }
     }
-    else {
-        button_cb_info_t *p = realloc(btn->cb_info[event], sizeof(button_cb_info_t) * (btn->size[event] + 1));
-        BTN_CHECK(NULL != p, "realloc cb_info failed", ESP_ERR_NO_MEM);
-        btn->cb_info[event] = p;
-    }
 
-    btn->cb_info[event][btn->size[event]].cb = cb;
-    btn->cb_info[event][btn->size[event]].usr_data = usr_data;
-    btn->size[event]++;
-
-    /** Inserting the event_data in sorted manner */
     if (event == BUTTON_LONG_PRESS_START || event == BUTTON_LONG_PRESS_UP) {
-        uint16_t press_time = event_cfg.event_data.long_press.press_time;
-        BTN_CHECK(press_time / TICKS_INTERVAL > btn->short_press_ticks, "press_time event_data is less than short_press_ticks", ESP_ERR_INVALID_ARG);
-        if (btn->size[event] >= 2) {
-            for (int i = btn->size[event] - 2; i >= 0; i--) {
-                if (btn->cb_info[event][i].event_data.long_press.press_time > press_time) {
-                    btn->cb_info[event][i + 1] = btn->cb_info[event][i];
-
-                    btn->cb_info[event][i].event_data.long_press.press_time = press_time;
-                    btn->cb_info[event][i].cb = cb;
-                    btn->cb_info[event][i].usr_data = usr_data;
-                } else {
-                    btn->cb_info[event][i + 1].event_data.long_press.press_time = press_time;
-                    btn->cb_info[event][i + 1].cb = cb;
-                    btn->cb_info[event][i + 1].usr_data = usr_data;
-                    break;
-                }
-            }
-        } else {
-            btn->cb_info[event][btn->size[event] - 1].event_data.long_press.press_time = press_time;
-        }
-
-        int32_t press_ticks = press_time / TICKS_INTERVAL;
-        if (btn->short_press_ticks < press_ticks && press_ticks < btn->long_press_ticks) {
-            iot_button_set_param(btn, BUTTON_LONG_PRESS_TIME_MS, (void*)(intptr_t)press_time);
-        }
-    }
-
-    if (event == BUTTON_MULTIPLE_CLICK) {
-        if (btn->size[event] >= 2) {
-            for (int i = btn->size[event] - 2; i >= 0; i--) {
-                if (btn->cb_info[event][i].event_data.multiple_clicks.clicks > event_cfg.event_data.multiple_clicks.clicks) {
-                    btn->cb_info[event][i + 1] = btn->cb_info[event][i];
-
-                    btn->cb_info[event][i].event_data.multiple_clicks.clicks = event_cfg.event_data.multiple_clicks.clicks;
-                    btn->cb_info[event][i].cb = cb;
-                    btn->cb_info[event][i].usr_data = usr_data;
-                } else {
-                    btn->cb_info[event][i + 1].event_data.multiple_clicks.clicks = event_cfg.event_data.multiple_clicks.clicks;
-                    btn->cb_info[event][i + 1].cb = cb;
-                    btn->cb_info[event][i + 1].usr_data = usr_data;
-                    break;
-                }
-            }
-        } else {
-            btn->cb_info[event][btn->size[event] - 1].event_data.multiple_clicks.clicks = event_cfg.event_data.multiple_clicks.clicks;
-        }
+        button_lower_long_press(btn, event_cfg.event_data.long_press.press_time / TICKS_INTERVAL);
     }
 
+    button_update_clicks(btn);
     return ESP_OK;
 }
 
 esp_err_t iot_button_unregister_cb(button_handle_t btn_handle, button_event_t event)
 {
-    BTN_CHECK(NULL != btn_handle, "Pointer of handle is invalid", ESP_ERR_INVALID_ARG);
+    button_dev_t *btn = button_get_dev(btn_handle);
+    BTN_CHECK(NULL != btn, "Pointer of handle is invalid", ESP_ERR_INVALID_ARG);
     BTN_CHECK(event < BUTTON_EVENT_MAX, "event is invalid", ESP_ERR_INVALID_ARG);
-    button_dev_t *btn = (button_dev_t *) btn_handle;
-    BTN_CHECK(NULL != btn->cb_info[event], "No callbacks registered for the event", ESP_ERR_INVALID_STATE);
+    BTN_CHECK(BUTTON_CB_PRESENT(btn, event), "No callbacks registered for the event", ESP_ERR_INVALID_STATE);
+    BTN_CHECK(ESP_OK == button_unshare_cb(btn), "unshare cb_table failed", ESP_ERR_NO_MEM);
 
-    if (btn->cb_info[event]) {
-        free(btn->cb_info[event]);
-
-        /** Reset the counter */
-        if (event == BUTTON_LONG_PRESS_START) {
-            btn->count[0] = 0;
-        } else if (event == BUTTON_LONG_PRESS_UP) {
-            btn->count[1] = -1;
-        }
+    button_cb_remove(btn, event, 0, BUTTON_CB_NUM(btn, event));
 
+    /** Reset the counter */
+    if (event == BUTTON_LONG_PRESS_START) {
+        btn->count[0] = 0;
+    } else if (event == BUTTON_LONG_PRESS_UP) {
+        btn->count[1] = -1;
     }
-
-    btn->cb_info[event] = NULL;
-    btn->size[event] = 0;
+    button_update_clicks(btn);
     return ESP_OK;
 }
 
+esp_err_t iot_button_unregister_info_cb(button_handle_t btn_handle, button_event_config_t event_cfg, button_event_cb_t cb)
+{
+    return iot_button_unregister_event(btn_handle, event_cfg, (button_cb_t)cb);
+}
+
 esp_err_t iot_button_unregister_event(button_handle_t btn_handle, button_event_config_t event_cfg, button_cb_t cb)
 {
-    
-    BTN_CHECK(NULL != btn_handle, "Pointer of handle is invalid", ESP_ERR_INVALID_ARG);
+    button_dev_t *btn = button_get_dev(btn_handle);
+    BTN_CHECK(NULL != btn, "Pointer of handle is invalid", ESP_ERR_INVALID_ARG);
     button_event_t event = event_cfg.event;
     BTN_CHECK(event < BUTTON_EVENT_MAX, "event is invalid", ESP_ERR_INVALID_ARG);
     BTN_CHECK(NULL != cb, "Pointer to function callback is invalid", ESP_ERR_INVALID_ARG);
-    button_dev_t *btn = (button_dev_t *) btn_handle;
+    BTN_CHECK(ESP_OK == button_unshare_cb(btn), "unshare cb_table failed", ESP_ERR_NO_MEM);
 
     int check = -1;
+    button_cb_info_t *cb_info = BUTTON_CB_INFO(btn, event);
 
-    for (int i = 0; i < btn->size[event]; i++) {
-        if (cb == btn->cb_info[event][i].cb) {
+    for (int i = 0; i < BUTTON_CB_NUM(btn, event); i++) {
+        if (cb == cb_info[i].cb) {
             if ((event == BUTTON_LONG_PRESS_START || event == BUTTON_LONG_PRESS_UP) && event_cfg.event_data.long_press.press_time) {
-                if (event_cfg.event_data.long_press.press_time != btn->cb_info[event][i].event_data.long_press.press_time) {
+                if (event_cfg.event_data.long_press.press_time != cb_info[i].event_data.long_press.press_time) {
                     continue;
                 }
             }
 
             if (event == BUTTON_MULTIPLE_CLICK && event_cfg.event_data.multiple_clicks.clicks) {
-                if (event_cfg.event_data.multiple_clicks.clicks != btn->cb_info[event][i].event_data.multiple_clicks.clicks) {
+                if (event_cfg.event_data.multiple_clicks.clicks != cb_info[i].event_data.multiple_clicks.clicks) {
                     continue;
                 }
             }
             check = i;
-            for (int j = i; j <= btn->size[event]-1; j++) {
-                btn->cb_info[event][j] = btn->cb_info[event][j + 1];
-            }
-
-            if (btn->size[event] != 1) {
-                button_cb_info_t *p = realloc(btn->cb_info[event], sizeof(button_cb_info_t) * (btn->size[event] - 1));
-                BTN_CHECK(NULL != p, "realloc cb_info failed", ESP_ERR_NO_MEM);
-                btn->cb_info[event] = p;
-                btn->size[event]--;
-            } else {
-                free(btn->cb_info[event]);
-                btn->cb_info[event] = NULL;
-                btn->size[event] = 0;
-            }
+            button_cb_remove(btn, event, i, 1);
             break;
         }
     }
 
     BTN_CHECK(check != -1, "No such callback registered for the event", ESP_ERR_INVALID_STATE);
 
+    button_update_clicks(btn);
     return ESP_OK;
 }
 
 size_t iot_button_count_cb(button_handle_t btn_handle)
 {
-    BTN_CHECK(NULL != btn_handle, "Pointer of handle is invalid", ESP_ERR_INVALID_ARG);
-    button_dev_t *btn = (button_dev_t *) btn_handle;
-    size_t ret = 0;
-    for (size_t i = 0; i < BUTTON_EVENT_MAX; i++) {
-        if (btn->cb_info[i]) {
-            ret+=btn->size[i];
-        }
-    }
-    return ret;
+    button_dev_t *btn = button_get_dev(btn_handle);
+    BTN_CHECK(NULL != btn, "Pointer of handle is invalid", ESP_ERR_INVALID_ARG);
+    return btn->cb_table ? btn->cb_table->first[BUTTON_EVENT_MAX] : 0;
 }
 
 size_t iot_button_count_event(button_handle_t btn_handle, button_event_t event)
 {
-    BTN_CHECK(NULL != btn_handle, "Pointer of handle is invalid", ESP_ERR_INVALID_ARG);
-    button_dev_t *btn = (button_dev_t *) btn_handle;
-    return btn->size[event];
+    button_dev_t *btn = button_get_dev(btn_handle);
+    BTN_CHECK(NULL != btn, "Pointer of handle is invalid", ESP_ERR_INVALID_ARG);
+    BTN_CHECK(event < BUTTON_EVENT_MAX, "event is invalid", 0);
+    return BUTTON_CB_NUM(btn, event);
 }
 
 button_event_t iot_button_get_event(button_handle_t btn_handle)
 {
-    BTN_CHECK(NULL != btn_handle, "Pointer of handle is invalid", BUTTON_NONE_PRESS);
-    button_dev_t *btn = (button_dev_t *) btn_handle;
+    button_dev_t *btn = button_get_dev(btn_handle);
+    BTN_CHECK(NULL != btn, "Pointer of handle is invalid", BUTTON_NONE_PRESS);
     return btn->event;
 }
 
 uint8_t iot_button_get_repeat(button_handle_t btn_handle)
 {
-    BTN_CHECK(NULL != btn_handle, "Pointer of handle is invalid", 0);
-    button_dev_t *btn = (button_dev_t *) btn_handle;
+    button_dev_t *btn = button_get_dev(btn_handle);
+    BTN_CHECK(NULL != btn, "Pointer of handle is invalid", 0);
     return btn->repeat;
 }
 
 uint16_t iot_button_get_ticks_time(button_handle_t btn_handle)
 {
-    BTN_CHECK(NULL != btn_handle, "Pointer of handle is invalid", 0);
-    button_dev_t *btn = (button_dev_t *) btn_handle;
+    button_dev_t *btn = button_get_dev(btn_handle);
+    BTN_CHECK(NULL != btn, "Pointer of handle is invalid", 0);
     return (btn->ticks * TICKS_INTERVAL);
 }
 
 uint16_t iot_button_get_long_press_hold_cnt(button_handle_t btn_handle)
 {
-    BTN_CHECK(NULL != btn_handle, "Pointer of handle is invalid", 0);
-    button_dev_t *btn = (button_dev_t *) btn_handle;
+    button_dev_t *btn = button_get_dev(btn_handle);
+    BTN_CHECK(NULL != btn, "Pointer of handle is invalid", 0);
     return btn->long_press_hold_cnt;
 }
 
+uint32_t iot_button_get_edge_time(button_handle_t btn_handle)
+{
+    button_dev_t *btn = button_get_dev(btn_handle);
+    BTN_CHECK(NULL != btn, "Pointer of handle is invalid", 0);
+    return btn->debounce.edge_time_us;
+}
+
+uint32_t iot_button_get_click_mask(button_handle_t btn_handle)
+{
+    button_dev_t *btn = button_get_dev(btn_handle);
+    BTN_CHECK(NULL != btn, "Pointer of handle is invalid", 0);
+    return btn->click_mask;
+}
+
+esp_err_t iot_button_set_max_clicks(button_handle_t btn_handle, uint8_t max_clicks)
+{
+    button_dev_t *btn = button_get_dev(btn_handle);
+    BTN_CHECK(NULL != btn, "Pointer of handle is invalid", ESP_ERR_INVALID_ARG);
+    /**< the scan reads the click limit whole, a byte needs no lock */
+    btn->max_clicks = max_clicks;
+    button_update_clicks(btn);
+    return ESP_OK;
+}
+
+esp_err_t iot_button_set_hold_config(button_handle_t btn_handle, const button_hold_config_t *config)
+{
+    button_dev_t *btn = button_get_dev(btn_handle);
+    BTN_CHECK(NULL != btn, "Pointer of handle is invalid", ESP_ERR_INVALID_ARG);
+    button_hold_timing(button_timing_begin(btn), config);
+    button_timing_end(btn);
+    return ESP_OK;
+}
+
+esp_err_t iot_button_inject_level(button_handle_t btn_handle, uint8_t level, int64_t timestamp)
+{
+    if (0 == timestamp) {
+        timestamp = esp_timer_get_time();
+    }
+    /**< the slot is claimed, not locked: a delete waits for the post, and injections into other buttons never contend */
+    button_slot_t *slot = button_slot_claim(btn_handle);
+    BTN_CHECK(NULL != slot, "Pointer of handle is invalid", ESP_ERR_INVALID_ARG);
+    button_dev_t *btn = slot->btn;
+    esp_err_t ret = ESP_ERR_NOT_SUPPORTED;
+    if (BUTTON_TYPE_VIRTUAL == btn->type) {
+        button_virtual_post((button_virtual_mailbox_t *)btn->hardware_data, level, timestamp);
+        ret = ESP_OK;
+    }
+    button_slot_unclaim(slot);
+    if (ESP_OK != ret) {
+        ESP_LOGE(TAG, "%s: not a virtual button", __FUNCTION__);
+    }
+    return ret;
+}
+
 esp_err_t iot_button_set_param(button_handle_t btn_handle, button_param_t param, void *value)
 {
-    BTN_CHECK(NULL != btn_handle, "Pointer of handle is invalid", ESP_ERR_INVALID_ARG);
-    button_dev_t *btn = (button_dev_t *) btn_handle;
-    BUTTON_ENTER_CRITICAL();
+    button_dev_t *btn = button_get_dev(btn_handle);
+    BTN_CHECK(NULL != btn, "Pointer of handle is invalid", ESP_ERR_INVALID_ARG);
+    BTN_CHECK((uintptr_t)value <= UINT16_MAX, "value is invalid", ESP_ERR_INVALID_ARG);
+    button_timing_config_t config = {0};
+    uint16_t time = (uint16_t)(uintptr_t)value;
     switch (param) {
     case BUTTON_LONG_PRESS_TIME_MS:
-        btn->long_press_ticks = (int32_t)value / TICKS_INTERVAL;
+        config.long_press_time = time;
         break;
     case BUTTON_SHORT_PRESS_TIME_MS:
-        btn->short_press_ticks = (int32_t)value / TICKS_INTERVAL;
+        config.short_press_time = time;
         break;
-    default:
+    case BUTTON_SERIAL_TIME_MS:
+        config.serial_time = time;
+        break;
+    case BUTTON_LONG_PRESS_TOLERANCE_MS:
+        config.long_press_tolerance = time;
         break;
+    case BUTTON_DEBOUNCE_TICKS:
+        BTN_CHECK((uintptr_t)value <= UINT8_MAX, "debounce ticks is invalid", ESP_ERR_INVALID_ARG);
+        config.debounce_press_ticks = (uint8_t)(uintptr_t)value;
+        config.debounce_release_ticks = config.debounce_press_ticks;
+        break;
+    default:
+        ESP_LOGE(TAG, "%s: param is invalid", __FUNCTION__);
+        return ESP_ERR_INVALID_ARG;
     }
-    BUTTON_EXIT_CRITICAL();
+    button_timing_merge(button_timing_begin(btn), &config);
+    button_timing_end(btn);
+    return ESP_OK;
+}
+
+esp_err_t iot_button_set_timing(button_handle_t btn_handle, const button_timing_config_t *config)
+{
+    button_dev_t *btn = button_get_dev(btn_handle);
+    BTN_CHECK(NULL != btn, "Pointer of handle is invalid", ESP_ERR_INVALID_ARG);
+    BTN_CHECK(NULL != config, "Pointer of config is invalid", ESP_ERR_INVALID_ARG);
+    button_timing_merge(button_timing_begin(btn), config);
+    button_timing_end(btn);
+    return ESP_OK;
+}
+
+esp_err_t iot_button_get_timing(button_handle_t btn_handle, button_timing_config_t *config)
+{
+    button_dev_t *btn = button_get_dev(btn_handle);
+    BTN_CHECK(NULL != btn, "Pointer of handle is invalid", ESP_ERR_INVALID_ARG);
+    BTN_CHECK(NULL != config, "Pointer of config is invalid", ESP_ERR_INVALID_ARG);
+    button_timing_t timing;
+    button_timing_read(btn, &timing);
+    config->long_press_time = timing.long_press_ticks * TICKS_INTERVAL;
+    config->short_press_time = timing.short_press_ticks * TICKS_INTERVAL;
+    config->serial_time = timing.serial_ticks * TICKS_INTERVAL;
+    config->long_press_tolerance = timing.tolerance_ms;
+    config->debounce_press_ticks = timing.debounce_ticks[1];
+    config->debounce_release_ticks = timing.debounce_ticks[0];
+    return ESP_OK;
+}
+
+/**
+  * @brief  Timings of a profile entry, the values at 0 are kept.
+  */
+static void button_apply_entry(button_dev_t *btn, const button_profile_entry_t *entry)
+{
+    button_timing_config_t config = {
+        .long_press_time = entry->long_press_ms,
+        .short_press_time = entry->short_press_ms,
+        .serial_time = entry->serial_ms,
+        .long_press_tolerance = entry->tolerance_ms,
+        .debounce_press_ticks = entry->debounce_ticks,
+        .debounce_release_ticks = entry->debounce_ticks,
+    };
+    button_timing_t *timing = button_timing_begin(btn);
+    button_timing_merge(timing, &config);
+    if (entry->long_press_ms) {
+        btn->long_press_ticks_default = timing->long_press_ticks;
+    }
+    button_timing_end(btn);
+}
+
+esp_err_t iot_button_apply_profile(const void *profile, size_t len, const button_profile_targets_t *targets)
+{
+    uint16_t entry_num = 0;
+    esp_err_t ret = button_profile_check(profile, len, &entry_num);
+    if (ESP_OK != ret) {
+        return ret;
+    }
+
+    /**< every entry is checked before the first one is applied, a profile is applied whole or not at all */
+    for (uint16_t i = 0; i < entry_num; i++) {
+        button_profile_entry_t entry;
+        button_profile_get_entry(profile, i, &entry);
+        if (BUTTON_PROFILE_GROUP == entry.target) {
+            BTN_CHECK(targets && entry.index < targets->group_num && targets->groups[entry.index], "profile group is invalid", ESP_ERR_NOT_FOUND);
+        } else if (BUTTON_PROFILE_BUTTON == entry.target) {
+            BTN_CHECK(targets && entry.index < targets->button_num && button_get_dev(targets->buttons[entry.index]), "profile button is invalid", ESP_ERR_NOT_FOUND);
+        }
+    }
+
+    /**< each button is claimed on its own, the scan goes on while the profile is applied */
+    for (uint16_t i = 0; i < entry_num; i++) {
+        button_profile_entry_t entry;
+        button_profile_get_entry(profile, i, &entry);
+        if (BUTTON_PROFILE_ALL == entry.target) {
+            for (button_dev_t *target = g_head_handle; target; target = target->next) {
+                button_apply_entry(target, &entry);
+            }
+        } else if (BUTTON_PROFILE_GROUP == entry.target) {
+            button_group_t *group = (button_group_t *)targets->groups[entry.index];
+            if (entry.long_press_ms) {
+                /**< default press_time of the callbacks registered on the group from now on */
+                group->proto.long_press_ticks_default = entry.long_press_ms / TICKS_INTERVAL;
+            }
+            for (size_t j = 0; j < group->num; j++) {
+                if (group->btns[j].hal_button_Level) {
+                    button_apply_entry(&group->btns[j], &entry);
+                }
+            }
+        } else {
+            button_apply_entry(button_get_dev(targets->buttons[entry.index]), &entry);
+        }
+    }
+    ESP_LOGD(TAG, "button profile applied, %u entries", entry_num);
     return ESP_OK;
 }
 
@@ -684,7 +1914,7 @@ esp_err_t iot_button_resume(void)
     BTN_CHECK(g_button_timer_handle, "Button timer handle is invalid", ESP_ERR_INVALID_STATE);
     BTN_CHECK(!g_is_timer_running, "Button timer is already running", ESP_ERR_INVALID_STATE);
 
-    esp_err_t err = esp_timer_start_periodic(g_button_timer_handle, TICKS_INTERVAL * 1000U);
+    esp_err_t err = button_timer_start();
     BTN_CHECK(ESP_OK == err, "Button timer start failed", ESP_FAIL);
     g_is_timer_running = true;
     return ESP_OK;
@@ -695,8 +1925,228 @@ esp_err_t iot_button_stop(void)
     BTN_CHECK(g_button_timer_handle, "Button timer handle is invalid", ESP_ERR_INVALID_STATE);
     BTN_CHECK(g_is_timer_running, "Button timer is not running", ESP_ERR_INVALID_STATE);
 
-    esp_err_t err = esp_timer_stop(g_button_timer_handle);
+    esp_err_t err = button_timer_stop();
     BTN_CHECK(ESP_OK == err, "Button timer stop failed", ESP_FAIL);
     g_is_timer_running = false;
     return ESP_OK;
 }
+
+#ifdef BUTTON_DEEP_SLEEP_WAKEUP_SUPPORTED
+#if !CONFIG_IDF_TARGET_ESP32 && ESP_IDF_VERSION < ESP_IDF_VERSION_VAL(5, 0, 0)
+/**< mode 0 wakes up on any low pin after the ESP32, it was only named all low before 5.0 */
+#define ESP_EXT1_WAKEUP_ANY_LOW ESP_EXT1_WAKEUP_ALL_LOW
+#endif
+#if SOC_PM_SUPPORT_EXT1_WAKEUP_MODE_PER_PIN && ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 3, 0)
+#define BUTTON_EXT1_WAKEUP_PER_PIN 1
+#endif
+
+/**
+  * @brief  Wake up from deep sleep on a press of any of the RTC GPIO buttons, masks of the active low [0] and high [1] ones.
+  */
+static esp_err_t button_sleep_enable_ext1(const uint64_t ext1_mask[2])
+{
+    for (int level = 0; level < 2; level++) {
+        /**< the digital pulls of button_gpio_init() are not held in deep sleep */
+        for (int gpio_num = 0; gpio_num < SOC_GPIO_PIN_COUNT; gpio_num++) {
+            if (!(ext1_mask[level] & (1ULL << gpio_num))) {
+                continue;
+            }
+            if (level) {
+                rtc_gpio_pullup_dis(gpio_num);
+                rtc_gpio_pulldown_en(gpio_num);
+            } else {
+                rtc_gpio_pulldown_dis(gpio_num);
+                rtc_gpio_pullup_en(gpio_num);
+            }
+        }
+    }
+#if SOC_PM_SUPPORT_RTC_PERIPH_PD
+    esp_sleep_pd_config(ESP_PD_DOMAIN_RTC_PERIPH, ESP_PD_OPTION_ON);
+#endif
+
+#if BUTTON_EXT1_WAKEUP_PER_PIN
+    esp_err_t ret = ESP_OK;
+    if (ext1_mask[0]) {
+        ret = esp_sleep_enable_ext1_wakeup_io(ext1_mask[0], ESP_EXT1_WAKEUP_ANY_LOW);
+    }
+    if (ESP_OK == ret && ext1_mask[1]) {
+        ret = esp_sleep_enable_ext1_wakeup_io(ext1_mask[1], ESP_EXT1_WAKEUP_ANY_HIGH);
+    }
+    return ret;
+#else
+    /**< one mode for all the pins */
+    BTN_CHECK(!(ext1_mask[0] && ext1_mask[1]), "buttons of both active levels can't wake up from deep sleep on this target", ESP_ERR_NOT_SUPPORTED);
+#if CONFIG_IDF_TARGET_ESP32
+    /**< the ESP32 wakes up when any pin is high or when all pins are low, not on a press of one of several active low buttons */
+    BTN_CHECK(0 == (ext1_mask[0] & (ext1_mask[0] - 1)), "several active low buttons can't wake up the ESP32 from deep sleep, wire them active high", ESP_ERR_NOT_SUPPORTED);
+    return esp_sleep_enable_ext1_wakeup(ext1_mask[0] | ext1_mask[1], ext1_mask[0] ? ESP_EXT1_WAKEUP_ALL_LOW : ESP_EXT1_WAKEUP_ANY_HIGH);
+#else
+    return esp_sleep_enable_ext1_wakeup(ext1_mask[0] | ext1_mask[1], ext1_mask[0] ? ESP_EXT1_WAKEUP_ANY_LOW : ESP_EXT1_WAKEUP_ANY_HIGH);
+#endif
+#endif
+}
+#endif
+
+static esp_err_t button_sleep_enable_wakeup(button_sleep_mode_t mode)
+{
+#ifdef BUTTON_DEEP_SLEEP_WAKEUP_SUPPORTED
+    uint64_t ext1_mask[2] = {0};
+#endif
+    esp_err_t ret = ESP_OK;
+
+    for (button_dev_t *target = g_head_handle; target; target = target->next) {
+        if (BUTTON_TYPE_GPIO != target->type) {
+            continue;
+        }
+        gpio_num_t gpio_num = (gpio_num_t)(int)target->hardware_data;
+        if (BUTTON_SLEEP_LIGHT == mode) {
+            /**< a held button would flood the CPU with the level interrupt of the wakeup */
+            button_debounce_suspend(&target->debounce);
+            ret = gpio_wakeup_enable(gpio_num, target->active_level ? GPIO_INTR_HIGH_LEVEL : GPIO_INTR_LOW_LEVEL);
+            BTN_CHECK(ESP_OK == ret, "gpio wakeup enable failed", ret);
+        } else {
+#ifdef BUTTON_DEEP_SLEEP_WAKEUP_SUPPORTED
+            if (!rtc_gpio_is_valid_gpio(gpio_num)) {
+                ESP_LOGW(TAG, "GPIO%d is not a RTC GPIO, can't wake up from deep sleep", gpio_num);
+                continue;
+            }
+            ext1_mask[target->active_level] |= (1ULL << gpio_num);
+#else
+            ESP_LOGE(TAG, "Deep sleep wakeup by GPIO is not supported");
+            return ESP_ERR_NOT_SUPPORTED;
+#endif
+        }
+    }
+
+    if (BUTTON_SLEEP_LIGHT == mode) {
+        return esp_sleep_enable_gpio_wakeup();
+    }
+#ifdef BUTTON_DEEP_SLEEP_WAKEUP_SUPPORTED
+    if (ext1_mask[0] || ext1_mask[1]) {
+        ret = button_sleep_enable_ext1(ext1_mask);
+    }
+#endif
+    return ret;
+}
+
+static bool button_sleep_is_wakeup_source(button_dev_t *btn)
+{
+#ifdef BUTTON_DEEP_SLEEP_WAKEUP_SUPPORTED
+    if (BUTTON_TYPE_GPIO == btn->type && ESP_SLEEP_WAKEUP_EXT1 == esp_sleep_get_wakeup_cause()) {
+        return esp_sleep_get_ext1_wakeup_status() & (1ULL << (int)btn->hardware_data);
+    }
+#endif
+    return false;
+}
+
+/**
+  * @brief  Buttons whose hardware_data is an id of the hardware, not a pointer, so they are found again after a
+  *         deep sleep reset. Virtual and encoder buttons hold heap pointers, custom ones the priv of the user.
+  */
+static bool button_sleep_keeps_state(const button_dev_t *btn)
+{
+    switch (btn->type) {
+    case BUTTON_TYPE_GPIO:
+    case BUTTON_TYPE_ADC:
+    case BUTTON_TYPE_MATRIX:
+    case BUTTON_TYPE_EXPANDER:
+    case BUTTON_TYPE_SHIFT_REG:
+    case BUTTON_TYPE_TOUCH:
+        return true;
+    default:
+        return false;
+    }
+}
+
+esp_err_t iot_button_enter_sleep(button_sleep_mode_t mode)
+{
+    BTN_CHECK(mode == BUTTON_SLEEP_LIGHT || mode == BUTTON_SLEEP_DEEP, "sleep mode is invalid", ESP_ERR_INVALID_ARG);
+    BTN_CHECK(g_button_timer_handle, "Button timer handle is invalid", ESP_ERR_INVALID_STATE);
+
+    if (g_is_timer_running) {
+        button_timer_stop();
+        g_is_timer_running = false;
+    }
+
+    uint8_t num = 0;
+    for (button_dev_t *target = g_head_handle; target; target = target->next) {
+        if (!button_sleep_keeps_state(target)) {
+            continue;
+        }
+        if (num >= CONFIG_BUTTON_SLEEP_MAX_RECORD) {
+            ESP_LOGW(TAG, "Too many buttons, the state of the rest will not be kept");
+            break;
+        }
+        button_sleep_record_t *record = &s_sleep_record[num++];
+        record->hardware_data = (uint32_t)(uintptr_t)target->hardware_data;
+        record->type = target->type;
+        record->state = target->state;
+        record->repeat = target->repeat;
+        record->button_level = target->debounce.level;
+        record->ticks = target->ticks;
+        record->long_press_hold_cnt = target->long_press_hold_cnt;
+    }
+    s_sleep_record_num = num;
+    s_sleep_mode = mode;
+
+    esp_err_t ret = button_sleep_enable_wakeup(mode);
+    if (ESP_OK != ret) {
+        /**< the buttons keep scanning, the caller must not sleep */
+        iot_button_exit_sleep();
+    }
+    return ret;
+}
+
+esp_err_t iot_button_exit_sleep(void)
+{
+    BTN_CHECK(BUTTON_SLEEP_NONE != s_sleep_mode, "Button is not in sleep", ESP_ERR_INVALID_STATE);
+
+    for (button_dev_t *target = g_head_handle; target; target = target->next) {
+        if (BUTTON_SLEEP_LIGHT == s_sleep_mode && BUTTON_TYPE_GPIO == target->type) {
+            gpio_wakeup_disable((gpio_num_t)(int)target->hardware_data);
+            button_debounce_resume(&target->debounce);
+        }
+
+        /**< a virtual button gets its edges from its mailbox, not from the debounce, and an encoder has no press to replay */
+        if (BUTTON_TYPE_VIRTUAL == target->type || BUTTON_TYPE_ENCODER == target->type) {
+            continue;
+        }
+
+        for (int i = 0; button_sleep_keeps_state(target) && i < s_sleep_record_num; i++) {
+            button_sleep_record_t *record = &s_sleep_record[i];
+            if (record->type == target->type && record->hardware_data == (uint32_t)(uintptr_t)target->hardware_data) {
+                target->state = record->state;
+                target->repeat = record->repeat;
+                target->debounce.level = record->button_level;
+                target->ticks = record->ticks;
+                target->long_press_hold_cnt = record->long_press_hold_cnt;
+                if (4 == target->state) {
+                    /**< repeats resume on the next scan, the long press time may have been raised during sleep */
+                    target->hold_step = target->ticks > target->long_press_ticks ? (target->ticks - target->long_press_ticks) / target->serial_ticks : 0;
+                    target->hold_next = target->ticks;
+                    target->hold_dispatch = 0;
+                    target->hold_pending = 0;
+                }
+                break;
+            }
+        }
+
+        /**
+         * Replay the pressing edge without waiting for debounce. If the button has already been
+         * released during wakeup, the debounce will see the release and complete the click.
+         */
+        if (target->hal_button_Level(target->hardware_data) == target->active_level || button_sleep_is_wakeup_source(target)) {
+            target->debounce.level = target->active_level;
+            target->debounce.cnt = 0;
+        }
+    }
+    s_sleep_record_num = 0;
+    s_sleep_mode = BUTTON_SLEEP_NONE;
+
+    if (g_button_timer_handle && !g_is_timer_running) {
+        esp_err_t err = button_timer_start();
+        BTN_CHECK(ESP_OK == err, "Button timer start failed", ESP_FAIL);
+        g_is_timer_running = true;
+    }
+    return ESP_OK;
+}
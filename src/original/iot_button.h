@@ -8,14 +8,30 @@
 #include "button_adc.h"
 #include "button_gpio.h"
 #include "button_matrix.h"
+#include "button_debounce.h"
+#include "button_virtual.h"
+#include "button_expander.h"
+#include "button_shift.h"
+#include "button_touch.h"
+#include "button_encoder.h"
+#include "button_profile.h"
 #include "esp_err.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+#define BUTTON_CLICK_MASK_ANY       (1UL << 0)  /**< in iot_button_get_click_mask(), a callback needs every click count */
+#define BUTTON_MAX_CLICKS_WINDOW    0xff        /**< for iot_button_set_max_clicks(), always wait the short press window */
+#define BUTTON_CB_MAX_NUM           255         /**< callbacks of a button over all its events, its callback table has 8 bit indexes */
+
 typedef void (* button_cb_t)(void *button_handle, void *usr_data);
+/**
+ * @brief Handle of a button, an index tagged with a generation rather than a pointer.
+ *        Using a handle after iot_button_delete fails with ESP_ERR_INVALID_ARG.
+ */
 typedef void *button_handle_t;
+typedef void *button_group_handle_t;
 
 /**
  * @brief Button events
@@ -32,6 +48,8 @@ typedef enum {
     BUTTON_LONG_PRESS_START,
     BUTTON_LONG_PRESS_HOLD,
     BUTTON_LONG_PRESS_UP,
+    BUTTON_ENCODER_STEP,                /**< BUTTON_TYPE_ENCODER turned by encoder_steps detents in a scan */
+    BUTTON_ENCODER_VELOCITY,            /**< BUTTON_TYPE_ENCODER velocity window ended, see encoder_velocity */
     BUTTON_EVENT_MAX,
     BUTTON_NONE_PRESS,
 } button_event_t;
@@ -58,6 +76,40 @@ typedef union {
     } multiple_clicks;          /**< multiple clicks struct, for event BUTTON_MULTIPLE_CLICK */
 }button_event_data_t;
 
+/**
+ * @brief Snapshot of a button event, filled once per event and shared by all its callbacks
+ *
+ */
+typedef struct {
+    button_handle_t handle;             /**< button which emitted the event */
+    button_event_t event;               /**< event being emitted */
+    uint8_t repeat;                     /**< pressed times, see iot_button_get_repeat() */
+    uint16_t ticks_time;                /**< time since press down or up (ms), see iot_button_get_ticks_time() */
+    uint16_t long_press_hold_cnt;       /**< see iot_button_get_long_press_hold_cnt() */
+    uint32_t edge_time;                 /**< time of the last debounced edge (us), see iot_button_get_edge_time() */
+    uint16_t hold_repeats;              /**< BUTTON_LONG_PRESS_HOLD repeats delivered by this callback, more than 1 when coalesced */
+    int16_t encoder_steps;              /**< BUTTON_ENCODER_STEP detents of the scan, A leading B is positive */
+    int16_t encoder_velocity;           /**< detents per second over the last CONFIG_ENCODER_VELOCITY_WINDOW_MS */
+    int32_t encoder_position;           /**< detents since the encoder was created */
+} button_event_info_t;
+
+/**
+ * @brief Callback receiving the event snapshot, the pointer is only valid during the call
+ *
+ */
+typedef void (* button_event_cb_t)(const button_event_info_t *info, void *usr_data);
+
+/**
+ * @brief Where a callback runs
+ *
+ */
+typedef enum {
+    BUTTON_CB_CONTEXT_INLINE = 0,       /**< in the scan, on the esp_timer task, before the scan goes on. For short urgent handlers */
+    BUTTON_CB_CONTEXT_HIGH,             /**< queued to a worker task of CONFIG_BUTTON_CB_HIGH_PRIORITY */
+    BUTTON_CB_CONTEXT_BACKGROUND,       /**< queued to a worker task of CONFIG_BUTTON_CB_BACKGROUND_PRIORITY, e.g. UI redraw or logging */
+    BUTTON_CB_CONTEXT_MAX,
+} button_cb_context_t;
+
 /**
  * @brief Button events configuration
  *
@@ -65,6 +117,8 @@ typedef union {
 typedef struct {
     button_event_t event;               /**< button event type */
     button_event_data_t event_data;     /**< event data corresponding to the event */
+    button_cb_context_t context;        /**< where the callback runs, default BUTTON_CB_CONTEXT_INLINE. Queued callbacks get a
+                                             snapshot of the event, the button may have been deleted when they run */
 } button_event_config_t;
 
 /**
@@ -75,7 +129,12 @@ typedef enum {
     BUTTON_TYPE_GPIO,
     BUTTON_TYPE_ADC,
     BUTTON_TYPE_MATRIX,
-    BUTTON_TYPE_CUSTOM
+    BUTTON_TYPE_CUSTOM,
+    BUTTON_TYPE_VIRTUAL,
+    BUTTON_TYPE_EXPANDER,
+    BUTTON_TYPE_SHIFT_REG,
+    BUTTON_TYPE_TOUCH,
+    BUTTON_TYPE_ENCODER,
 } button_type_t;
 
 /**
@@ -85,9 +144,49 @@ typedef enum {
 typedef enum {
     BUTTON_LONG_PRESS_TIME_MS = 0,
     BUTTON_SHORT_PRESS_TIME_MS,
+    BUTTON_SERIAL_TIME_MS,              /**< also sets a fixed BUTTON_LONG_PRESS_HOLD rate, see button_timing_config_t */
+    BUTTON_LONG_PRESS_TOLERANCE_MS,
+    BUTTON_DEBOUNCE_TICKS,              /**< scans to accept a press and a release */
     BUTTON_PARAM_MAX,
 } button_param_t;
 
+/**
+ * @brief Button sleep mode
+ *
+ */
+typedef enum {
+    BUTTON_SLEEP_NONE = 0,
+    BUTTON_SLEEP_LIGHT,
+    BUTTON_SLEEP_DEEP,
+} button_sleep_mode_t;
+
+/**
+ * @brief Auto-repeat of BUTTON_LONG_PRESS_HOLD, all zero for a fixed rate of CONFIG_BUTTON_SERIAL_TIME_MS
+ *
+ *        The interval between repeats goes linearly from start_interval_ms to min_interval_ms
+ *        during the first ramp_ms of the hold (counted from the long press start).
+ */
+typedef struct {
+    uint16_t start_interval_ms;     /**< interval of the first repeats, if 0 default to CONFIG_BUTTON_SERIAL_TIME_MS */
+    uint16_t min_interval_ms;       /**< interval at the end of the ramp, if 0 or ramp_ms is 0 the rate is fixed to start_interval_ms */
+    uint16_t ramp_ms;               /**< hold time to reach min_interval_ms */
+    uint16_t coalesce_ms;           /**< if not 0, one callback at most every coalesce_ms carries the repeats due since the last one */
+} button_hold_config_t;
+
+/**
+ * @brief Timing of a button, set as a whole by iot_button_set_timing()
+ *
+ */
+typedef struct {
+    uint16_t long_press_time;       /**< Trigger time(ms) for long press, 0 keeps the current value */
+    uint16_t short_press_time;      /**< Trigger time(ms) for short press, 0 keeps the current value */
+    uint16_t serial_time;           /**< time(ms) between the press_time checks of a long press, see CONFIG_BUTTON_SERIAL_TIME_MS.
+                                         Also sets a fixed BUTTON_LONG_PRESS_HOLD rate, 0 keeps the current value */
+    uint16_t long_press_tolerance;  /**< tolerance(ms) on the press_time of the long press callbacks, 0 keeps the current value */
+    uint8_t debounce_press_ticks;   /**< scans to accept a press, 0 keeps the current value */
+    uint8_t debounce_release_ticks; /**< scans to accept a release, 0 keeps the current value */
+} button_timing_config_t;
+
 /**
  * @brief custom button configuration
  * 
@@ -113,9 +212,27 @@ typedef struct {
         button_adc_config_t adc_button_config;        /**< adc button configuration */
         button_matrix_config_t matrix_button_config; /**< matrix key button configuration */
         button_custom_config_t custom_button_config;  /**< custom button configuration */
+        button_virtual_config_t virtual_button_config; /**< virtual button configuration */
+        button_expander_config_t expander_button_config; /**< GPIO expander button configuration */
+        button_shift_config_t shift_button_config;    /**< shift register chain button configuration */
+        button_touch_config_t touch_button_config;    /**< touch pad button configuration */
+        button_encoder_config_t encoder_config;       /**< rotary encoder configuration */
     }; /**< button configuration */
+    button_debounce_config_t debounce_config;         /**< debounce algorithm, zero for the default counter of CONFIG_BUTTON_DEBOUNCE_TICKS */
+    button_hold_config_t hold_config;                 /**< BUTTON_LONG_PRESS_HOLD auto-repeat, zero for a fixed rate of CONFIG_BUTTON_SERIAL_TIME_MS */
 } button_config_t;
 
+/**
+ * @brief Buttons and groups the entries of a profile refer to by index
+ *
+ */
+typedef struct {
+    const button_handle_t *buttons;                   /**< buttons of the BUTTON_PROFILE_BUTTON entries */
+    size_t button_num;
+    const button_group_handle_t *groups;              /**< groups of the BUTTON_PROFILE_GROUP entries */
+    size_t group_num;
+} button_profile_targets_t;
+
 /**
  * @brief Create a button
  *
@@ -132,10 +249,51 @@ button_handle_t iot_button_create(const button_config_t *config);
  *
  * @return
  *      - ESP_OK  Success
- *      - ESP_FAIL Failure
+ *      - ESP_FAIL The button is deleted, but its hardware could not be released
  */
 esp_err_t iot_button_delete(button_handle_t btn_handle);
 
+/**
+ * @brief Create buttons in one block of memory. GPIO buttons are configured with one gpio_config() per active level.
+ *
+ * @param configs array of button configurations
+ * @param num number of buttons
+ * @param handles array of num handles filled with the created buttons, can be NULL
+ *
+ * @return A handle to the group, or NULL in case of error.
+ */
+button_group_handle_t iot_button_create_group(const button_config_t *configs, size_t num, button_handle_t *handles);
+
+/**
+ * @brief Delete a group and all the buttons of the group which are not deleted yet.
+ *        A button of the group can also be deleted alone with iot_button_delete(), the memory is released with the group.
+ *
+ * @param group_handle A group handle to delete
+ *
+ * @return
+ *      - ESP_OK  Success
+ *      - ESP_ERR_INVALID_ARG group_handle is invalid
+ */
+esp_err_t iot_button_delete_group(button_group_handle_t group_handle);
+
+/**
+ * @brief Register a callback on every button of the group. The callback table is shared by the buttons,
+ *        a button gets its own copy if callbacks are then registered or unregistered on the button alone.
+ *
+ * @param group_handle A group handle to register
+ * @param event_cfg Button event configuration, for BUTTON_LONG_PRESS_START and BUTTON_LONG_PRESS_UP press_time 0 is CONFIG_BUTTON_LONG_PRESS_TIME_MS
+ * @param cb Callback function.
+ * @param usr_data user data
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG   Arguments is invalid.
+ *      - ESP_ERR_INVALID_STATE A button of the group already has its own callbacks for the event.
+ *      - ESP_ERR_NO_MEM        No more memory allocation for the event
+ *      - ESP_ERR_INVALID_SIZE  The group or one of its buttons already has BUTTON_CB_MAX_NUM callbacks.
+ */
+esp_err_t iot_button_group_register_event_cb(button_group_handle_t group_handle, button_event_config_t event_cfg, button_cb_t cb, void *usr_data);
+
 /**
  * @brief Register the button event callback function.
  *
@@ -149,6 +307,7 @@ esp_err_t iot_button_delete(button_handle_t btn_handle);
  *      - ESP_ERR_INVALID_ARG   Arguments is invalid.
  *      - ESP_ERR_INVALID_STATE The Callback is already registered. No free Space for another Callback.
  *      - ESP_ERR_NO_MEM        No more memory allocation for the event
+ *      - ESP_ERR_INVALID_SIZE  The button already has BUTTON_CB_MAX_NUM callbacks.
  */
 esp_err_t iot_button_register_cb(button_handle_t btn_handle, button_event_t event, button_cb_t cb, void *usr_data);
 
@@ -165,9 +324,26 @@ esp_err_t iot_button_register_cb(button_handle_t btn_handle, button_event_t even
  *      - ESP_ERR_INVALID_ARG   Arguments is invalid.
  *      - ESP_ERR_INVALID_STATE The Callback is already registered. No free Space for another Callback.
  *      - ESP_ERR_NO_MEM        No more memory allocation for the event
+ *      - ESP_ERR_INVALID_SIZE  The button already has BUTTON_CB_MAX_NUM callbacks.
  */
 esp_err_t iot_button_register_event_cb(button_handle_t btn_handle, button_event_config_t event_cfg, button_cb_t cb, void *usr_data);
 
+/**
+ * @brief Register a callback receiving a snapshot of the event, so it doesn't need the iot_button_get_xxx() getters.
+ *
+ * @param btn_handle A button handle to register
+ * @param event_cfg Button event configuration, for BUTTON_LONG_PRESS_START and BUTTON_LONG_PRESS_UP press_time 0 is the long press time of the button
+ * @param cb Callback function.
+ * @param usr_data user data
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG   Arguments is invalid.
+ *      - ESP_ERR_NO_MEM        No more memory allocation for the event
+ *      - ESP_ERR_INVALID_SIZE  The button already has BUTTON_CB_MAX_NUM callbacks.
+ */
+esp_err_t iot_button_register_info_cb(button_handle_t btn_handle, button_event_config_t event_cfg, button_event_cb_t cb, void *usr_data);
+
 /**
  * @brief Unregister the button event callback function.
  *        In case event_data is also passed it will unregister function for that particular event_data only.
@@ -183,6 +359,20 @@ esp_err_t iot_button_register_event_cb(button_handle_t btn_handle, button_event_
  */
 esp_err_t iot_button_unregister_event(button_handle_t btn_handle, button_event_config_t event_cfg, button_cb_t cb);
 
+/**
+ * @brief Unregister a callback registered by iot_button_register_info_cb().
+ *
+ * @param btn_handle A button handle to unregister
+ * @param event_cfg Button event
+ * @param cb callback to unregister
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG   Arguments is invalid.
+ *      - ESP_ERR_INVALID_STATE The Callback was never registered with the event
+ */
+esp_err_t iot_button_unregister_info_cb(button_handle_t btn_handle, button_event_config_t event_cfg, button_event_cb_t cb);
+
 /**
  * @brief Unregister all the callbacks associated with the event.
  *
@@ -256,18 +446,154 @@ uint16_t iot_button_get_ticks_time(button_handle_t btn_handle);
  */
 uint16_t iot_button_get_long_press_hold_cnt(button_handle_t btn_handle);
 
+/**
+ * @brief Get the time of the last debounced edge
+ *
+ * @param btn_handle Button handle
+ *
+ * @return Time of the edge (us), low 32 bits of esp_timer_get_time(). With BUTTON_DEBOUNCE_GPIO_EDGE it is the time
+ *         of the last raw edge seen by the interrupt, otherwise the time the scan accepted the new level.
+ */
+uint32_t iot_button_get_edge_time(button_handle_t btn_handle);
+
+/**
+ * @brief Get the click counts needed by the registered callbacks
+ *
+ *        Clicks are classified as soon as the highest count is reached, instead of after the
+ *        short press window, so a button with only BUTTON_SINGLE_CLICK callbacks reports clicks at once.
+ *
+ * @param btn_handle Button handle
+ *
+ * @return Bit n is set if a BUTTON_SINGLE_CLICK, BUTTON_DOUBLE_CLICK or BUTTON_MULTIPLE_CLICK callback needs n clicks.
+ *         BUTTON_CLICK_MASK_ANY if BUTTON_PRESS_REPEAT, BUTTON_PRESS_REPEAT_DONE or more than 31 clicks are registered,
+ *         then the window is always waited out.
+ */
+uint32_t iot_button_get_click_mask(button_handle_t btn_handle);
+
+/**
+ * @brief Set the click count at which clicks are classified without waiting the short press window
+ *
+ * @param btn_handle Button handle
+ * @param max_clicks 0 to follow the registered callbacks (default), BUTTON_MAX_CLICKS_WINDOW to always wait the window
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG   Arguments is invalid.
+ */
+esp_err_t iot_button_set_max_clicks(button_handle_t btn_handle, uint8_t max_clicks);
+
+/**
+ * @brief Change the BUTTON_LONG_PRESS_HOLD auto-repeat of a button, applied from the next long press
+ *
+ * @param btn_handle Button handle
+ * @param config pointer of auto-repeat configuration, NULL for a fixed rate of CONFIG_BUTTON_SERIAL_TIME_MS
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG   Arguments is invalid.
+ */
+esp_err_t iot_button_set_hold_config(button_handle_t btn_handle, const button_hold_config_t *config);
+
+/**
+ * @brief Push a level to a BUTTON_TYPE_VIRTUAL button, safe from any task.
+ *        The button is scanned only while it has pending levels or a press in progress.
+ *
+ * @param btn_handle Button handle
+ * @param level level of the button, compared with virtual_button_config.active_level
+ * @param timestamp time of the level change (us), see esp_timer_get_time(). If 0, the time of the call
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG   Arguments is invalid.
+ *      - ESP_ERR_NOT_SUPPORTED The button is not a virtual button.
+ */
+esp_err_t iot_button_inject_level(button_handle_t btn_handle, uint8_t level, int64_t timestamp);
+
 /**
  * @brief Dynamically change the parameters of the iot button
  * 
  * @param btn_handle Button handle
  * @param param Button parameter
- * @param value new value
+ * @param value new value, 0 keeps the current value
  * @return
  *      - ESP_OK on success
  *      - ESP_ERR_INVALID_ARG   Arguments is invalid.
  */
 esp_err_t iot_button_set_param(button_handle_t btn_handle, button_param_t param, void *value);
 
+/**
+ * @brief Change several timings of a button at once. The scan takes the new timing as a whole at the start
+ *        of its next tick, it never waits for this call nor sees some of the values only.
+ *
+ * @param btn_handle Button handle
+ * @param config pointer of timing, the fields at 0 are kept
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG   Arguments is invalid.
+ */
+esp_err_t iot_button_set_timing(button_handle_t btn_handle, const button_timing_config_t *config);
+
+/**
+ * @brief Get the timing of a button, the last one set even if the scan has not taken it yet
+ *
+ * @param btn_handle Button handle
+ * @param config timing of the button, in ms rounded to the scan period
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG   Arguments is invalid.
+ */
+esp_err_t iot_button_get_timing(button_handle_t btn_handle, button_timing_config_t *config);
+
+/**
+ * @brief Apply a timing profile, see button_profile.h for the format.
+ *        The profile is checked whole first, then its entries are applied in order, one button at a time.
+ *        Each button takes its new timing whole on its next scan, but the profile is not atomic across buttons:
+ *        a scan running meanwhile can see some buttons with the new timing and the others still with the old one.
+ *        The long press time of a profile is also the default press_time of the callbacks registered afterwards,
+ *        so a profile is best applied after the buttons are created and before the callbacks are registered.
+ *
+ * @param profile profile data
+ * @param len bytes of profile
+ * @param targets buttons and groups of the entries, can be NULL if every entry is BUTTON_PROFILE_ALL
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_NOT_FOUND     An entry refers to a button or group not in targets
+ *      - Others                The profile is invalid, see button_profile_check()
+ */
+esp_err_t iot_button_apply_profile(const void *profile, size_t len, const button_profile_targets_t *targets);
+
+/**
+ * @brief Read a profile from an NVS blob and apply it
+ *
+ * @param namespace_name NVS namespace, nvs_flash_init() must have been called
+ * @param key key of the blob
+ * @param targets buttons and groups of the entries, see iot_button_apply_profile()
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_NVS_NOT_FOUND The namespace or the key does not exist
+ *      - ESP_ERR_NO_MEM        No memory
+ *      - Others                See iot_button_apply_profile()
+ */
+esp_err_t iot_button_load_profile_nvs(const char *namespace_name, const char *key, const button_profile_targets_t *targets);
+
+/**
+ * @brief Map a profile stored at the start of a data partition and apply it
+ *
+ * @param label label of the partition
+ * @param targets buttons and groups of the entries, see iot_button_apply_profile()
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_NOT_FOUND     The partition does not exist
+ *      - ESP_ERR_INVALID_VERSION The partition does not hold a profile
+ *      - Others                See iot_button_apply_profile()
+ */
+esp_err_t iot_button_load_profile_partition(const char *label, const button_profile_targets_t *targets);
+
 /**
  * @brief resume button timer, if button timer is stopped. Make sure iot_button_create() is called before calling this API.
  *
@@ -286,6 +612,41 @@ esp_err_t iot_button_resume(void);
  */
 esp_err_t iot_button_stop(void);
 
+/**
+ * @brief Prepare buttons for sleep. Stop the button timer, save the scan state of every button in RTC memory
+ *        and enable the GPIO buttons as wakeup sources. Call this right before esp_light_sleep_start() or esp_deep_sleep_start().
+ *
+ * @note For deep sleep only RTC GPIOs can wake up the chip, other GPIO buttons are skipped with a warning.
+ *       A press of any of them wakes up the chip, and their RTC pulls are enabled as the digital ones are not
+ *       held in deep sleep. The ESP32 can't wake up on a press of one of several active low buttons, and only
+ *       the targets setting the ext1 mode per pin wake up on buttons of both active levels: this returns
+ *       ESP_ERR_NOT_SUPPORTED otherwise, with the buttons still scanned.
+ *
+ * @param mode BUTTON_SLEEP_LIGHT or BUTTON_SLEEP_DEEP
+ *
+ * @return
+ *     - ESP_OK on success
+ *     - ESP_ERR_INVALID_ARG     mode is invalid.
+ *     - ESP_ERR_INVALID_STATE   timer state is invalid.
+ *     - ESP_ERR_NOT_SUPPORTED   deep sleep wakeup by these GPIO buttons is not supported on the target.
+ */
+esp_err_t iot_button_enter_sleep(button_sleep_mode_t mode);
+
+/**
+ * @brief Restore buttons after wakeup and resume the button timer. Buttons are matched with the saved state
+ *        by type and hardware data, so after deep sleep they must be created with the same configuration first.
+ *        If a button is pressed, or is the wakeup source, its pressing edge is replayed on the next scan,
+ *        so the click which woke up the chip is not lost.
+ *
+ * @note Only GPIO, ADC, matrix, expander, shift register and touch buttons keep their state across deep sleep,
+ *       the others have no hardware id to be found again. Virtual and encoder buttons get no replayed edge.
+ *
+ * @return
+ *     - ESP_OK on success
+ *     - ESP_ERR_INVALID_STATE   iot_button_enter_sleep() was not called.
+ */
+esp_err_t iot_button_exit_sleep(void);
+
 #ifdef __cplusplus
 }
 #endif
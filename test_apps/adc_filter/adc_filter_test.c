@@ -0,0 +1,237 @@
+/* SPDX-FileCopyrightText: 2022-2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * Host test of the filters of the ADC buttons.
+ *
+ * Three buttons on one channel are scanned every 5 ms against synthetic readings: presses
+ * of each button in turn with Gaussian noise, short spikes or both on top. For every filter
+ * it reports the share of wrong decisions and the CPU time per scan, and checks that the
+ * scan never runs the calibration. Exits non-zero if a check fails.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <math.h>
+#include <time.h>
+#include "esp_timer.h"
+#include "esp_adc/adc_cali_scheme.h"
+#include "button_adc.h"
+
+#define TEST_CHANNEL        1
+#define TEST_BUTTON_NUM     3
+#define TEST_SCAN_US        5000
+#define TEST_SCANS          60000
+#define TEST_SEGMENT        24      /**< scans of a press or of a release, 120 ms */
+#define TEST_SETTLE         10      /**< scans after an edge left out of the settled count */
+#define TEST_FULL_MV        3100    /**< reading of the full scale raw code */
+#define TEST_RAW_MAX        4095
+
+static const int s_button_mv[TEST_BUTTON_NUM] = {600, 1200, 1800};
+static const int s_idle_mv = 2800;
+static const int s_window_mv = 200;
+
+/**
+ * Host shim of the ADC driver, the readings come from the waveform
+ */
+static int64_t s_now_us = 0;
+static int s_raw = 0;
+static unsigned s_cali_calls = 0;
+
+int64_t esp_timer_get_time(void)
+{
+    return s_now_us;
+}
+
+esp_err_t adc_oneshot_new_unit(const adc_oneshot_unit_init_cfg_t *init_config, adc_oneshot_unit_handle_t *ret_unit)
+{
+    *ret_unit = (adc_oneshot_unit_handle_t)1;
+    return ESP_OK;
+}
+
+esp_err_t adc_oneshot_config_channel(adc_oneshot_unit_handle_t handle, adc_channel_t channel, const adc_oneshot_chan_cfg_t *config)
+{
+    return ESP_OK;
+}
+
+esp_err_t adc_oneshot_read(adc_oneshot_unit_handle_t handle, adc_channel_t chan, int *out_raw)
+{
+    *out_raw = s_raw;
+    return ESP_OK;
+}
+
+esp_err_t adc_oneshot_del_unit(adc_oneshot_unit_handle_t handle)
+{
+    return ESP_OK;
+}
+
+esp_err_t adc_cali_create_scheme_line_fitting(const adc_cali_line_fitting_config_t *config, adc_cali_handle_t *ret_handle)
+{
+    *ret_handle = (adc_cali_handle_t)1;
+    return ESP_OK;
+}
+
+esp_err_t adc_cali_raw_to_voltage(adc_cali_handle_t handle, int raw, int *voltage)
+{
+    s_cali_calls++;
+    *voltage = raw * TEST_FULL_MV / TEST_RAW_MAX;
+    return ESP_OK;
+}
+
+/**
+ * Synthetic readings
+ */
+typedef struct {
+    const char *name;
+    double sigma_mv;        /**< Gaussian noise */
+    double spike_rate;      /**< share of the readings with a spike */
+    int spike_mv;           /**< largest spike, either sign */
+} test_noise_t;
+
+static const test_noise_t s_noise[] = {
+    {"clean", 0, 0, 0},
+    {"gauss", 110, 0, 0},
+    {"spikes", 20, 0.03, 1200},
+    {"gauss+spikes", 80, 0.03, 1200},
+};
+
+static const struct {
+    const char *name;
+    button_adc_filter_t filter;
+} s_filter[] = {
+    {"none", BUTTON_ADC_FILTER_NONE},
+    {"median", BUTTON_ADC_FILTER_MEDIAN},
+    {"iir", BUTTON_ADC_FILTER_IIR},
+};
+
+#define NOISE_NUM   (sizeof(s_noise) / sizeof(s_noise[0]))
+#define FILTER_NUM  (sizeof(s_filter) / sizeof(s_filter[0]))
+
+static uint16_t s_wave[TEST_SCANS];
+static int8_t s_truth[TEST_SCANS];    /**< button pressed, -1 for none */
+
+static double gauss(void)
+{
+    double u = (rand() + 1.0) / (RAND_MAX + 2.0);
+    double v = (rand() + 1.0) / (RAND_MAX + 2.0);
+    return sqrt(-2 * log(u)) * cos(2 * M_PI * v);
+}
+
+static void make_wave(const test_noise_t *noise, unsigned seed)
+{
+    srand(seed);
+    for (int t = 0; t < TEST_SCANS; t++) {
+        /**< idle, button 0, idle, button 1, idle, button 2 */
+        int segment = (t / TEST_SEGMENT) % (2 * TEST_BUTTON_NUM);
+        s_truth[t] = (segment & 1) ? segment / 2 : -1;
+        double mv = s_truth[t] < 0 ? s_idle_mv : s_button_mv[s_truth[t]];
+        mv += noise->sigma_mv * gauss();
+        if (noise->spike_rate > 0 && rand() < noise->spike_rate * RAND_MAX) {
+            mv += (rand() % (2 * noise->spike_mv + 1)) - noise->spike_mv;
+        }
+        int raw = (int)lround(mv * TEST_RAW_MAX / TEST_FULL_MV);
+        s_wave[t] = raw < 0 ? 0 : raw > TEST_RAW_MAX ? TEST_RAW_MAX : raw;
+    }
+}
+
+typedef struct {
+    double wrong;           /**< wrong decisions, share of all */
+    double settled_wrong;   /**< wrong decisions from TEST_SETTLE scans after an edge on */
+    double ns_per_scan;
+    unsigned cali_calls;    /**< calibration runs during the scans */
+} test_result_t;
+
+static int run(button_adc_filter_t filter, test_result_t *result)
+{
+    for (int i = 0; i < TEST_BUTTON_NUM; i++) {
+        button_adc_config_t config = {
+            .adc_channel = TEST_CHANNEL,
+            .button_index = i,
+            .min = s_button_mv[i] - s_window_mv,
+            .max = s_button_mv[i] + s_window_mv,
+            .filter = filter,
+        };
+        if (ESP_OK != button_adc_init(&config)) {
+            return -1;
+        }
+    }
+
+    unsigned wrong = 0, settled_wrong = 0, settled = 0;
+    uint8_t level[TEST_SCANS][TEST_BUTTON_NUM];
+    s_cali_calls = 0;
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int t = 0; t < TEST_SCANS; t++) {
+        s_now_us += TEST_SCAN_US;
+        s_raw = s_wave[t];
+        for (int i = 0; i < TEST_BUTTON_NUM; i++) {
+            level[t][i] = button_adc_get_key_level((void *)(uintptr_t)ADC_BUTTON_COMBINE(TEST_CHANNEL, i));
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    result->cali_calls = s_cali_calls;
+
+    for (int t = 0; t < TEST_SCANS; t++) {
+        int is_settled = t % TEST_SEGMENT >= TEST_SETTLE;
+        settled += is_settled;
+        for (int i = 0; i < TEST_BUTTON_NUM; i++) {
+            if (level[t][i] != (s_truth[t] == i)) {
+                wrong++;
+                settled_wrong += is_settled;
+            }
+        }
+    }
+    result->wrong = (double)wrong / (TEST_SCANS * TEST_BUTTON_NUM);
+    result->settled_wrong = (double)settled_wrong / (settled * TEST_BUTTON_NUM);
+    result->ns_per_scan = ((end.tv_sec - start.tv_sec) * 1e9 + (end.tv_nsec - start.tv_nsec)) / TEST_SCANS;
+
+    for (int i = 0; i < TEST_BUTTON_NUM; i++) {
+        button_adc_deinit(TEST_CHANNEL, i);
+    }
+    return 0;
+}
+
+#define TEST_CHECK(a)                                                               \
+    if (!(a)) {                                                                     \
+        fprintf(stderr, "%s(%d): check failed: %s\n", __FILE__, __LINE__, #a);     \
+        failed++;                                                                   \
+    }
+
+int main(int argc, char **argv)
+{
+    static test_result_t result[NOISE_NUM][FILTER_NUM];
+    int failed = 0;
+
+    printf("%-14s %-8s %10s %10s %12s\n", "noise", "filter", "wrong %", "settled %", "ns/scan");
+    for (size_t n = 0; n < NOISE_NUM; n++) {
+        make_wave(&s_noise[n], 1 + n);
+        for (size_t f = 0; f < FILTER_NUM; f++) {
+            test_result_t *r = &result[n][f];
+            if (run(s_filter[f].filter, r)) {
+                fprintf(stderr, "init of the %s filter failed\n", s_filter[f].name);
+                return 1;
+            }
+            printf("%-14s %-8s %10.3f %10.3f %12.1f\n", s_noise[n].name, s_filter[f].name,
+                   100 * r->wrong, 100 * r->settled_wrong, r->ns_per_scan);
+            /**< the scan compares raw codes, thresholds are converted at init */
+            TEST_CHECK(0 == r->cali_calls);
+        }
+    }
+
+    enum { NONE, MEDIAN, IIR };
+    enum { CLEAN, GAUSS, SPIKES, MIXED };
+    for (size_t f = 0; f < FILTER_NUM; f++) {
+        TEST_CHECK(0 == result[CLEAN][f].settled_wrong);
+    }
+    TEST_CHECK(result[GAUSS][MEDIAN].settled_wrong < result[GAUSS][NONE].settled_wrong / 2);
+    TEST_CHECK(result[GAUSS][IIR].settled_wrong < result[GAUSS][NONE].settled_wrong / 10);
+    TEST_CHECK(result[SPIKES][MEDIAN].settled_wrong < result[SPIKES][NONE].settled_wrong / 10);
+    TEST_CHECK(result[MIXED][MEDIAN].settled_wrong < result[MIXED][NONE].settled_wrong / 2);
+    TEST_CHECK(result[MIXED][IIR].settled_wrong < result[MIXED][NONE].settled_wrong / 2);
+
+    printf("%s\n", failed ? "FAILED" : "PASSED");
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,13 @@
+/* Host shim, line fitting only */
+#pragma once
+#include "esp_adc/adc_cali.h"
+#include "esp_adc/adc_oneshot.h"
+
+#define ADC_CALI_SCHEME_LINE_FITTING_SUPPORTED 1
+typedef struct {
+    adc_unit_t unit_id;
+    adc_atten_t atten;
+    adc_bitwidth_t bitwidth;
+} adc_cali_line_fitting_config_t;
+
+esp_err_t adc_cali_create_scheme_line_fitting(const adc_cali_line_fitting_config_t *config, adc_cali_handle_t *ret_handle);
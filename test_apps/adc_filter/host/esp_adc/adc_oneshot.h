@@ -0,0 +1,24 @@
+/* Host shim, the test supplies the readings */
+#pragma once
+#include "esp_err.h"
+
+typedef int adc_channel_t;
+typedef int adc_unit_t;
+typedef int adc_atten_t;
+typedef int adc_bitwidth_t;
+#define ADC_UNIT_1      0
+#define ADC_ATTEN_DB_11 3
+
+typedef struct adc_oneshot_unit_ctx_t *adc_oneshot_unit_handle_t;
+typedef struct {
+    adc_unit_t unit_id;
+} adc_oneshot_unit_init_cfg_t;
+typedef struct {
+    adc_atten_t atten;
+    adc_bitwidth_t bitwidth;
+} adc_oneshot_chan_cfg_t;
+
+esp_err_t adc_oneshot_new_unit(const adc_oneshot_unit_init_cfg_t *init_config, adc_oneshot_unit_handle_t *ret_unit);
+esp_err_t adc_oneshot_config_channel(adc_oneshot_unit_handle_t handle, adc_channel_t channel, const adc_oneshot_chan_cfg_t *config);
+esp_err_t adc_oneshot_read(adc_oneshot_unit_handle_t handle, adc_channel_t chan, int *out_raw);
+esp_err_t adc_oneshot_del_unit(adc_oneshot_unit_handle_t handle);
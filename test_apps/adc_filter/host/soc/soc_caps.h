@@ -0,0 +1,4 @@
+/* 12 bit ADC with 10 channels on host */
+#pragma once
+#define SOC_ADC_RTC_MAX_BITWIDTH 12
+#define SOC_ADC_MAX_CHANNEL_NUM  10
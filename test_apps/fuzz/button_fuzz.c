@@ -0,0 +1,875 @@
+/* SPDX-FileCopyrightText: 2022-2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * Host fuzz target of the button state machine and registration API.
+ *
+ * Every input is decoded as a sequence of operations on a small set of custom and
+ * virtual buttons: create, delete, register, unregister, level changes, timing profiles
+ * and scans.
+ * The scan timer is driven by the target, so an input replays deterministically.
+ *
+ * - libFuzzer: build with -fsanitize=fuzzer,address,undefined
+ * - AFL++ or reproducing a crash: build with -DBUTTON_FUZZ_STANDALONE and pass the input files
+ * - throughput mode: build with -DBUTTON_FUZZ_STANDALONE -O2 and run with -n <iterations>
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <setjmp.h>
+#include "esp_timer.h"
+#include "esp_sleep.h"
+#include "driver/gpio.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
+#include "iot_button.h"
+#include "arduino_config.h"
+
+#define FUZZ_MAX_BUTTON     4
+#define FUZZ_MAX_GROUP      2
+#define FUZZ_MAX_SCAN       64
+#define FUZZ_MAX_TASK       4
+#define FUZZ_GPIO_NUM       8
+
+#define FUZZ_CHECK(a)                                                            \
+    if (!(a)) {                                                                  \
+        fprintf(stderr, "%s(%d): check failed: %s\n", __FILE__, __LINE__, #a);  \
+        abort();                                                                 \
+    }
+
+/**
+ * Host shim of the scan timer and of the drivers the fuzzed buttons never reach
+ */
+struct esp_timer {
+    void (*callback)(void *arg);
+    void *arg;
+    bool running;
+};
+
+static struct esp_timer *s_timer = NULL;
+static int64_t s_now_us = 0;
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t *args, esp_timer_handle_t *handle)
+{
+    FUZZ_CHECK(NULL == s_timer);
+    s_timer = calloc(1, sizeof(struct esp_timer));
+    FUZZ_CHECK(NULL != s_timer);
+    s_timer->callback = args->callback;
+    s_timer->arg = args->arg;
+    *handle = s_timer;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_start_periodic(esp_timer_handle_t timer, uint64_t period)
+{
+    (void)period;
+    FUZZ_CHECK(timer == s_timer && !timer->running);
+    timer->running = true;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_stop(esp_timer_handle_t timer)
+{
+    FUZZ_CHECK(timer == s_timer);
+    if (!timer->running) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    timer->running = false;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_delete(esp_timer_handle_t timer)
+{
+    FUZZ_CHECK(timer == s_timer && !timer->running);
+    free(s_timer);
+    s_timer = NULL;
+    return ESP_OK;
+}
+
+int64_t esp_timer_get_time(void)
+{
+    return s_now_us;
+}
+
+/**< GPIO buttons are only created by the host checks, their pins read s_gpio_level */
+static uint8_t s_gpio_level[FUZZ_GPIO_NUM];
+
+esp_err_t button_gpio_init(const button_gpio_config_t *config)
+{
+    return config->gpio_num >= 0 && config->gpio_num < FUZZ_GPIO_NUM ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t button_gpio_init_mask(uint64_t pin_bit_mask, uint8_t active_level) { (void)pin_bit_mask; (void)active_level; return ESP_ERR_NOT_SUPPORTED; }
+esp_err_t button_gpio_deinit(int gpio_num) { (void)gpio_num; return ESP_OK; }
+
+uint8_t button_gpio_get_key_level(void *gpio_num)
+{
+    return s_gpio_level[(intptr_t)gpio_num];
+}
+
+esp_err_t button_adc_init(const button_adc_config_t *config) { (void)config; return ESP_ERR_NOT_SUPPORTED; }
+esp_err_t button_adc_deinit(uint8_t channel, int button_index) { (void)channel; (void)button_index; return ESP_OK; }
+uint8_t button_adc_get_key_level(void *button_index) { (void)button_index; return 0; }
+esp_err_t button_matrix_init(const button_matrix_config_t *config) { (void)config; return ESP_ERR_NOT_SUPPORTED; }
+esp_err_t button_matrix_deinit(int row_gpio_num, int col_gpio_num) { (void)row_gpio_num; (void)col_gpio_num; return ESP_OK; }
+uint8_t button_matrix_get_key_level(void *hardware_data) { (void)hardware_data; return 0; }
+esp_err_t button_expander_init(const button_expander_config_t *config, void **hardware_data) { (void)config; (void)hardware_data; return ESP_ERR_NOT_SUPPORTED; }
+esp_err_t button_expander_deinit(void *hardware_data) { (void)hardware_data; return ESP_OK; }
+uint8_t button_expander_get_key_level(void *hardware_data) { (void)hardware_data; return 0; }
+esp_err_t button_shift_init(const button_shift_config_t *config, void **hardware_data) { (void)config; (void)hardware_data; return ESP_ERR_NOT_SUPPORTED; }
+esp_err_t button_shift_deinit(void *hardware_data) { (void)hardware_data; return ESP_OK; }
+uint8_t button_shift_get_key_level(void *hardware_data) { (void)hardware_data; return 0; }
+esp_err_t button_touch_init(const button_touch_config_t *config) { (void)config; return ESP_ERR_NOT_SUPPORTED; }
+esp_err_t button_touch_deinit(int32_t touch_pad) { (void)touch_pad; return ESP_OK; }
+uint8_t button_touch_get_key_level(void *touch_pad) { (void)touch_pad; return 0; }
+esp_err_t button_encoder_init(const button_encoder_config_t *config, button_encoder_t **encoder) { (void)config; (void)encoder; return ESP_ERR_NOT_SUPPORTED; }
+esp_err_t button_encoder_deinit(button_encoder_t *encoder) { (void)encoder; return ESP_OK; }
+uint8_t button_encoder_scan(button_encoder_t *encoder, uint64_t levels) { (void)encoder; (void)levels; return 0; }
+uint8_t button_encoder_get_key_level(void *encoder) { (void)encoder; return 0; }
+uint64_t button_gpio_snapshot(void) { return 0; }
+esp_err_t gpio_install_isr_service(int intr_alloc_flags) { (void)intr_alloc_flags; return ESP_OK; }
+
+/**< edge interrupts of the GPIO buttons, raised by the host checks when they change the level of a pin */
+typedef struct {
+    void (*handler)(void *arg);
+    void *arg;
+    gpio_int_type_t type;
+    bool enabled;
+} fuzz_gpio_isr_t;
+
+static fuzz_gpio_isr_t s_gpio_isr[FUZZ_GPIO_NUM];
+
+esp_err_t gpio_set_intr_type(gpio_num_t gpio_num, gpio_int_type_t intr_type)
+{
+    FUZZ_CHECK(gpio_num >= 0 && gpio_num < FUZZ_GPIO_NUM);
+    s_gpio_isr[gpio_num].type = intr_type;
+    return ESP_OK;
+}
+
+esp_err_t gpio_intr_enable(gpio_num_t gpio_num)
+{
+    FUZZ_CHECK(gpio_num >= 0 && gpio_num < FUZZ_GPIO_NUM);
+    s_gpio_isr[gpio_num].enabled = true;
+    return ESP_OK;
+}
+
+esp_err_t gpio_intr_disable(gpio_num_t gpio_num)
+{
+    FUZZ_CHECK(gpio_num >= 0 && gpio_num < FUZZ_GPIO_NUM);
+    s_gpio_isr[gpio_num].enabled = false;
+    return ESP_OK;
+}
+
+esp_err_t gpio_isr_handler_add(gpio_num_t gpio_num, void (*isr_handler)(void *), void *args)
+{
+    FUZZ_CHECK(gpio_num >= 0 && gpio_num < FUZZ_GPIO_NUM && NULL == s_gpio_isr[gpio_num].handler);
+    s_gpio_isr[gpio_num].handler = isr_handler;
+    s_gpio_isr[gpio_num].arg = args;
+    return ESP_OK;
+}
+
+esp_err_t gpio_isr_handler_remove(gpio_num_t gpio_num)
+{
+    FUZZ_CHECK(gpio_num >= 0 && gpio_num < FUZZ_GPIO_NUM);
+    memset(&s_gpio_isr[gpio_num], 0, sizeof(fuzz_gpio_isr_t));
+    return ESP_OK;
+}
+
+esp_err_t gpio_wakeup_enable(gpio_num_t gpio_num, gpio_int_type_t intr_type) { (void)gpio_num; (void)intr_type; return ESP_OK; }
+esp_err_t gpio_wakeup_disable(gpio_num_t gpio_num) { (void)gpio_num; return ESP_OK; }
+esp_err_t esp_sleep_enable_gpio_wakeup(void) { return ESP_OK; }
+esp_sleep_wakeup_cause_t esp_sleep_get_wakeup_cause(void) { return ESP_SLEEP_WAKEUP_UNDEFINED; }
+
+/**
+ * Host shim of the callback workers. A worker keeps no state between two jobs, so it is run
+ * from its entry on each drain and leaves through a longjmp where it would block or exit.
+ */
+struct fuzz_queue {
+    uint8_t *items;
+    size_t item_size;
+    size_t length;
+    size_t head;
+    size_t count;
+};
+
+typedef struct {
+    TaskFunction_t entry;
+    void *arg;
+} fuzz_task_t;
+
+static fuzz_task_t s_task[FUZZ_MAX_TASK];
+static int s_task_running = -1;
+static jmp_buf s_task_yield;
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size)
+{
+    QueueHandle_t queue = calloc(1, sizeof(struct fuzz_queue));
+    FUZZ_CHECK(NULL != queue);
+    queue->items = calloc(length, item_size);
+    FUZZ_CHECK(NULL != queue->items);
+    queue->item_size = item_size;
+    queue->length = length;
+    return queue;
+}
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t wait)
+{
+    /**< nothing drains while the target runs, a blocking send would never return */
+    FUZZ_CHECK(0 == wait || queue->count < queue->length);
+    if (queue->count == queue->length) {
+        return pdFALSE;
+    }
+    memcpy(queue->items + (queue->head + queue->count) % queue->length * queue->item_size, item, queue->item_size);
+    queue->count++;
+    return pdTRUE;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t wait)
+{
+    (void)wait;
+    FUZZ_CHECK(s_task_running >= 0);
+    if (0 == queue->count) {
+        longjmp(s_task_yield, 1);
+    }
+    memcpy(item, queue->items + queue->head * queue->item_size, queue->item_size);
+    queue->head = (queue->head + 1) % queue->length;
+    queue->count--;
+    return pdTRUE;
+}
+
+void vQueueDelete(QueueHandle_t queue)
+{
+    free(queue->items);
+    free(queue);
+}
+
+BaseType_t xTaskCreate(TaskFunction_t entry, const char *name, uint32_t stack, void *arg, UBaseType_t priority, TaskHandle_t *handle)
+{
+    (void)name;
+    (void)stack;
+    (void)priority;
+    (void)handle;
+    for (int i = 0; i < FUZZ_MAX_TASK; i++) {
+        if (NULL == s_task[i].entry) {
+            s_task[i].entry = entry;
+            s_task[i].arg = arg;
+            return pdPASS;
+        }
+    }
+    return pdFALSE;
+}
+
+void vTaskDelete(TaskHandle_t handle)
+{
+    FUZZ_CHECK(NULL == handle && s_task_running >= 0);
+    s_task[s_task_running].entry = NULL;
+    longjmp(s_task_yield, 1);
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    /**< only a writer finding the timing of a button claimed waits, single threaded that is a claim never ended */
+    (void)ticks;
+    FUZZ_CHECK(0);
+}
+
+static void fuzz_run_tasks(void)
+{
+    for (int i = 0; i < FUZZ_MAX_TASK; i++) {
+        if (s_task[i].entry) {
+            s_task_running = i;
+            if (0 == setjmp(s_task_yield)) {
+                s_task[i].entry(s_task[i].arg);
+            }
+            s_task_running = -1;
+        }
+    }
+}
+
+/**
+ * Fuzzed buttons
+ */
+typedef struct {
+    const uint8_t *data;
+    size_t size;
+} fuzz_input_t;
+
+static button_handle_t s_btn[FUZZ_MAX_BUTTON];
+static bool s_virtual[FUZZ_MAX_BUTTON];
+static uint8_t s_level[FUZZ_MAX_BUTTON];
+static uint8_t s_member[FUZZ_MAX_BUTTON];         /*! Index + 1 of the group of the button, 0 if created alone*/
+static button_group_handle_t s_group[FUZZ_MAX_GROUP];
+static button_handle_t s_stale = NULL;
+static uint32_t s_cb_cnt = 0;
+
+static uint8_t fuzz_next(fuzz_input_t *in)
+{
+    if (0 == in->size) {
+        return 0;
+    }
+    in->size--;
+    return *in->data++;
+}
+
+static uint8_t fuzz_get_level(void *param)
+{
+    return *(uint8_t *)param;
+}
+
+static bool fuzz_is_live(button_handle_t handle)
+{
+    for (int i = 0; i < FUZZ_MAX_BUTTON; i++) {
+        if (s_btn[i] && s_btn[i] == handle) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void fuzz_cb(void *button_handle, void *usr_data)
+{
+    (void)usr_data;
+    FUZZ_CHECK(fuzz_is_live(button_handle));
+    s_cb_cnt++;
+}
+
+static void fuzz_cb_other(void *button_handle, void *usr_data)
+{
+    (void)usr_data;
+    FUZZ_CHECK(fuzz_is_live(button_handle));
+    s_cb_cnt += 2;
+}
+
+static void fuzz_info_cb(const button_event_info_t *info, void *usr_data)
+{
+    (void)usr_data;
+    FUZZ_CHECK(fuzz_is_live(info->handle));
+    FUZZ_CHECK(info->event < BUTTON_EVENT_MAX);
+    s_cb_cnt++;
+}
+
+static button_event_config_t fuzz_event_config(fuzz_input_t *in)
+{
+    button_event_config_t cfg;
+    memset(&cfg, 0, sizeof(cfg));
+    uint8_t value = fuzz_next(in);
+    cfg.event = (button_event_t)(value % (BUTTON_EVENT_MAX + 1));
+    cfg.context = (button_cb_context_t)((value >> 6) % BUTTON_CB_CONTEXT_MAX);
+    if (BUTTON_MULTIPLE_CLICK == cfg.event) {
+        cfg.event_data.multiple_clicks.clicks = fuzz_next(in) % 8;
+    } else if (BUTTON_LONG_PRESS_START == cfg.event || BUTTON_LONG_PRESS_UP == cfg.event) {
+        cfg.event_data.long_press.press_time = fuzz_next(in) * 16;
+    }
+    return cfg;
+}
+
+static void fuzz_button_config(fuzz_input_t *in, button_config_t *cfg, int slot, bool virtual_button)
+{
+    memset(cfg, 0, sizeof(button_config_t));
+    cfg->long_press_time = fuzz_next(in) * 4;
+    cfg->short_press_time = fuzz_next(in) * 2;
+    if (virtual_button) {
+        cfg->type = BUTTON_TYPE_VIRTUAL;
+        cfg->virtual_button_config.active_level = 1;
+    } else {
+        cfg->type = BUTTON_TYPE_CUSTOM;
+        cfg->custom_button_config.active_level = 1;
+        cfg->custom_button_config.button_custom_get_key_value = fuzz_get_level;
+        cfg->custom_button_config.priv = &s_level[slot];
+    }
+    uint8_t hold = fuzz_next(in);
+    if (hold & 1) {
+        cfg->hold_config.start_interval_ms = fuzz_next(in) * 4;
+        cfg->hold_config.min_interval_ms = fuzz_next(in);
+        cfg->hold_config.ramp_ms = fuzz_next(in) * 16;
+        cfg->hold_config.coalesce_ms = (hold & 2) ? fuzz_next(in) * 2 : 0;
+    }
+    cfg->debounce_config.algo = (button_debounce_algo_t)(fuzz_next(in) % 4);
+}
+
+static void fuzz_scan(uint32_t num)
+{
+    for (uint32_t i = 0; i < num; i++) {
+        s_now_us += CONFIG_BUTTON_PERIOD_TIME_MS * 1000;
+        if (s_timer && s_timer->running) {
+            s_timer->callback(s_timer->arg);
+        }
+    }
+}
+
+static void fuzz_create_group(fuzz_input_t *in)
+{
+    int g = fuzz_next(in) % FUZZ_MAX_GROUP;
+    if (s_group[g]) {
+        /**< members may have their own tables by now */
+        button_event_config_t cfg = fuzz_event_config(in);
+        iot_button_group_register_event_cb(s_group[g], cfg, fuzz_cb_other, NULL);
+        return;
+    }
+    /**< members take the free slots */
+    button_config_t cfgs[FUZZ_MAX_BUTTON];
+    int slots[FUZZ_MAX_BUTTON];
+    size_t num = fuzz_next(in) % 4 + 1;
+    size_t n = 0;
+    for (int i = 0; i < FUZZ_MAX_BUTTON && n < num; i++) {
+        if (!s_btn[i] && !s_member[i]) {
+            fuzz_button_config(in, &cfgs[n], i, false);
+            s_virtual[i] = false;
+            slots[n++] = i;
+        }
+    }
+    if (0 == n) {
+        return;
+    }
+    button_handle_t handles[FUZZ_MAX_BUTTON];
+    s_group[g] = iot_button_create_group(cfgs, n, handles);
+    if (s_group[g]) {
+        for (size_t i = 0; i < n; i++) {
+            s_btn[slots[i]] = handles[i];
+            s_member[slots[i]] = g + 1;
+        }
+        button_event_config_t cfg = fuzz_event_config(in);
+        iot_button_group_register_event_cb(s_group[g], cfg, fuzz_cb, NULL);
+    }
+}
+
+static void fuzz_delete_group(fuzz_input_t *in)
+{
+    int g = fuzz_next(in) % FUZZ_MAX_GROUP;
+    if (!s_group[g]) {
+        return;
+    }
+    FUZZ_CHECK(ESP_OK == iot_button_delete_group(s_group[g]));
+    s_group[g] = NULL;
+    /**< forget the members, deleted with the group */
+    for (int i = 0; i < FUZZ_MAX_BUTTON; i++) {
+        if (s_member[i] == g + 1) {
+            if (s_btn[i]) {
+                s_stale = s_btn[i];
+            }
+            s_btn[i] = NULL;
+            s_member[i] = 0;
+        }
+    }
+}
+
+static void fuzz_apply_profile(fuzz_input_t *in, uint8_t op)
+{
+    button_profile_entry_t entries[3] = {0};
+    uint16_t num = fuzz_next(in) % 4;
+    for (int i = 0; i < num; i++) {
+        entries[i].target = fuzz_next(in) % (BUTTON_PROFILE_TARGET_MAX + 1);
+        entries[i].index = fuzz_next(in) % (FUZZ_MAX_BUTTON + 1);
+        entries[i].debounce_ticks = fuzz_next(in) % 8;
+        entries[i].short_press_ms = fuzz_next(in) * 2;
+        entries[i].long_press_ms = fuzz_next(in) * 8;
+        entries[i].serial_ms = fuzz_next(in);
+        entries[i].tolerance_ms = fuzz_next(in);
+    }
+    uint8_t profile[BUTTON_PROFILE_HEADER_SIZE + 3 * BUTTON_PROFILE_ENTRY_SIZE];
+    size_t len = button_profile_pack(entries, num, profile, sizeof(profile));
+    FUZZ_CHECK(len == (size_t)(BUTTON_PROFILE_HEADER_SIZE + num * BUTTON_PROFILE_ENTRY_SIZE));
+    button_profile_targets_t targets = {s_btn, FUZZ_MAX_BUTTON, s_group, FUZZ_MAX_GROUP};
+    if (num && (op & 0x80)) {
+        /**< a damaged entry never gets past the crc */
+        profile[BUTTON_PROFILE_HEADER_SIZE + fuzz_next(in) % (num * BUTTON_PROFILE_ENTRY_SIZE)] ^= fuzz_next(in) | 1;
+        FUZZ_CHECK(ESP_ERR_INVALID_CRC == iot_button_apply_profile(profile, len, &targets));
+        return;
+    }
+    iot_button_apply_profile(profile, len - (op & 0x40 ? 1 : 0), &targets);
+}
+
+static void fuzz_run(fuzz_input_t *in)
+{
+    while (in->size) {
+        uint8_t op = fuzz_next(in);
+        int slot = (op >> 4) % FUZZ_MAX_BUTTON;
+        button_handle_t btn = s_btn[slot];
+
+        switch (op & 0x0f) {
+        case 0: {
+            if (btn || s_member[slot]) {
+                break;
+            }
+            button_config_t cfg;
+            s_virtual[slot] = op & 0x80;
+            s_level[slot] = 0;
+            fuzz_button_config(in, &cfg, slot, s_virtual[slot]);
+            s_btn[slot] = iot_button_create(&cfg);
+        } break;
+        case 1:
+            if (btn) {
+                FUZZ_CHECK(ESP_OK == iot_button_delete(btn));
+                s_btn[slot] = NULL;
+                s_stale = btn;
+            }
+            break;
+        case 2:
+        case 3: {
+            button_event_config_t cfg = fuzz_event_config(in);
+            uint8_t kind = fuzz_next(in) % 3;
+            if (2 == (op & 0x0f)) {
+                if (2 == kind) {
+                    iot_button_register_info_cb(btn, cfg, fuzz_info_cb, NULL);
+                } else {
+                    iot_button_register_event_cb(btn, cfg, kind ? fuzz_cb_other : fuzz_cb, NULL);
+                }
+            } else {
+                if (2 == kind) {
+                    iot_button_unregister_info_cb(btn, cfg, fuzz_info_cb);
+                } else {
+                    iot_button_unregister_event(btn, cfg, kind ? fuzz_cb_other : fuzz_cb);
+                }
+            }
+        } break;
+        case 4:
+            iot_button_unregister_cb(btn, (button_event_t)(fuzz_next(in) % (BUTTON_EVENT_MAX + 1)));
+            break;
+        case 5:
+            s_level[slot] = op >> 7;
+            if (btn && s_virtual[slot]) {
+                FUZZ_CHECK(ESP_OK == iot_button_inject_level(btn, s_level[slot], 0));
+            }
+            break;
+        case 6:
+            fuzz_scan(fuzz_next(in) % FUZZ_MAX_SCAN + 1);
+            break;
+        case 7:
+            /**< long enough for long presses and their hold repeats */
+            fuzz_scan(fuzz_next(in) * FUZZ_MAX_SCAN / 8 + 1);
+            break;
+        case 8:
+            if (op & 0x80) {
+                button_timing_config_t timing = {(uint16_t)(fuzz_next(in) * 16), (uint16_t)(fuzz_next(in) * 4), fuzz_next(in), fuzz_next(in), fuzz_next(in) % 8, fuzz_next(in) % 8};
+                iot_button_set_timing(btn, &timing);
+            } else {
+                uint16_t value = fuzz_next(in) * 16;
+                iot_button_set_param(btn, (button_param_t)(fuzz_next(in) % (BUTTON_PARAM_MAX + 1)), (void *)(uintptr_t)value);
+            }
+            break;
+        case 9: {
+            button_hold_config_t hold = {fuzz_next(in), fuzz_next(in), (uint16_t)(fuzz_next(in) * 8), fuzz_next(in)};
+            iot_button_set_hold_config(btn, &hold);
+        } break;
+        case 10:
+            if (btn) {
+                size_t total = 0;
+                for (int ev = 0; ev < BUTTON_EVENT_MAX; ev++) {
+                    total += iot_button_count_event(btn, (button_event_t)ev);
+                }
+                FUZZ_CHECK(total == iot_button_count_cb(btn));
+                iot_button_get_event(btn);
+                iot_button_get_repeat(btn);
+                iot_button_get_long_press_hold_cnt(btn);
+            }
+            break;
+        case 11:
+            /**< a deleted handle is rejected whatever the call */
+            if (s_stale && !fuzz_is_live(s_stale)) {
+                FUZZ_CHECK(ESP_ERR_INVALID_ARG == iot_button_delete(s_stale));
+                FUZZ_CHECK(ESP_ERR_INVALID_ARG == iot_button_register_cb(s_stale, BUTTON_PRESS_DOWN, fuzz_cb, NULL));
+            }
+            break;
+        case 12:
+            fuzz_create_group(in);
+            break;
+        case 13:
+            fuzz_delete_group(in);
+            break;
+        case 14:
+            fuzz_apply_profile(in, op);
+            break;
+        default:
+            fuzz_scan(1);
+            break;
+        }
+        /**< queued callbacks run before the next operation can delete their button */
+        fuzz_run_tasks();
+    }
+}
+
+static void fuzz_reset(void)
+{
+    for (int i = 0; i < FUZZ_MAX_BUTTON; i++) {
+        if (s_btn[i]) {
+            FUZZ_CHECK(ESP_OK == iot_button_delete(s_btn[i]));
+            s_btn[i] = NULL;
+        }
+        s_member[i] = 0;
+    }
+    for (int g = 0; g < FUZZ_MAX_GROUP; g++) {
+        if (s_group[g]) {
+            FUZZ_CHECK(ESP_OK == iot_button_delete_group(s_group[g]));
+            s_group[g] = NULL;
+        }
+    }
+    /**< the timer and the callback workers are released with the last button */
+    FUZZ_CHECK(NULL == s_timer);
+    fuzz_run_tasks();
+    for (int i = 0; i < FUZZ_MAX_TASK; i++) {
+        FUZZ_CHECK(NULL == s_task[i].entry);
+    }
+    s_stale = NULL;
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    fuzz_input_t in = {data, size};
+    fuzz_run(&in);
+    fuzz_reset();
+    return 0;
+}
+
+#ifdef BUTTON_FUZZ_STANDALONE
+/**
+ * Host checks, deterministic cases run through the same shim
+ */
+static uint8_t s_check_level = 0;
+static int s_long_press_start[2];
+
+static void fuzz_long_press_start_cb(void *button_handle, void *usr_data)
+{
+    (void)button_handle;
+    s_long_press_start[(intptr_t)usr_data]++;
+}
+
+static void fuzz_check_long_press_timing(button_handle_t btn, uint16_t long_press_time, intptr_t index)
+{
+    button_event_config_t event_cfg = {0};
+    event_cfg.event = BUTTON_LONG_PRESS_START;
+    event_cfg.event_data.long_press.press_time = 800;
+    FUZZ_CHECK(ESP_OK == iot_button_register_event_cb(btn, event_cfg, fuzz_long_press_start_cb, (void *)index));
+    button_timing_config_t timing = {0};
+    timing.long_press_time = long_press_time;
+    FUZZ_CHECK(ESP_OK == iot_button_set_timing(btn, &timing));
+}
+
+/**
+ * Sleep save and restore of a custom and a GPIO button held in a long press. Their long press is raised
+ * past the time already held, then the chip sleeps. The custom button keeps its state in memory, the
+ * GPIO one is created again during sleep, as after a deep sleep reset, and gets it from its sleep record.
+ * Both then reach the 800 ms step of their long press.
+ */
+static void fuzz_check_sleep(void)
+{
+    button_config_t custom_cfg = {0};
+    custom_cfg.type = BUTTON_TYPE_CUSTOM;
+    custom_cfg.custom_button_config.active_level = 1;
+    custom_cfg.custom_button_config.button_custom_get_key_value = fuzz_get_level;
+    custom_cfg.custom_button_config.priv = &s_check_level;
+    button_config_t gpio_cfg = {0};
+    gpio_cfg.type = BUTTON_TYPE_GPIO;
+    gpio_cfg.gpio_button_config.gpio_num = 1;
+    gpio_cfg.gpio_button_config.active_level = 1;
+
+    memset(s_long_press_start, 0, sizeof(s_long_press_start));
+    button_handle_t custom = iot_button_create(&custom_cfg);
+    button_handle_t gpio = iot_button_create(&gpio_cfg);
+    FUZZ_CHECK(custom && gpio);
+    fuzz_check_long_press_timing(custom, 300, 0);
+    fuzz_check_long_press_timing(gpio, 300, 1);
+
+    s_check_level = 1;
+    s_gpio_level[1] = 1;
+    fuzz_scan(400 / CONFIG_BUTTON_PERIOD_TIME_MS);
+    FUZZ_CHECK(BUTTON_LONG_PRESS_HOLD == iot_button_get_event(custom));
+    FUZZ_CHECK(BUTTON_LONG_PRESS_HOLD == iot_button_get_event(gpio));
+    uint16_t hold_cnt = iot_button_get_long_press_hold_cnt(gpio);
+    FUZZ_CHECK(hold_cnt > 0);
+    button_timing_config_t timing = {0};
+    timing.long_press_time = 600;
+    FUZZ_CHECK(ESP_OK == iot_button_set_timing(custom, &timing));
+    FUZZ_CHECK(ESP_OK == iot_button_set_timing(gpio, &timing));
+    fuzz_scan(1);
+
+    FUZZ_CHECK(ESP_OK == iot_button_enter_sleep(BUTTON_SLEEP_LIGHT));
+    FUZZ_CHECK(ESP_OK == iot_button_delete(gpio));
+    gpio = iot_button_create(&gpio_cfg);
+    FUZZ_CHECK(gpio && 0 == iot_button_get_long_press_hold_cnt(gpio));
+    fuzz_check_long_press_timing(gpio, 600, 1);
+    FUZZ_CHECK(ESP_OK == iot_button_exit_sleep());
+    FUZZ_CHECK(hold_cnt == iot_button_get_long_press_hold_cnt(gpio));
+
+    fuzz_scan(500 / CONFIG_BUTTON_PERIOD_TIME_MS);
+    fuzz_run_tasks();
+    FUZZ_CHECK(1 == s_long_press_start[0]);
+    FUZZ_CHECK(1 == s_long_press_start[1]);
+    FUZZ_CHECK(BUTTON_LONG_PRESS_HOLD == iot_button_get_event(gpio));
+
+    s_check_level = 0;
+    s_gpio_level[1] = 0;
+    fuzz_scan(FUZZ_MAX_SCAN);
+    FUZZ_CHECK(BUTTON_NONE_PRESS == iot_button_get_event(gpio));
+    FUZZ_CHECK(ESP_OK == iot_button_delete(custom));
+    FUZZ_CHECK(ESP_OK == iot_button_delete(gpio));
+    FUZZ_CHECK(NULL == s_timer);
+    fuzz_run_tasks();
+}
+
+/**< level changes of a pin, with the time in us from the start of the trace */
+typedef struct {
+    uint32_t time_us;
+    uint8_t level;
+} fuzz_trace_edge_t;
+
+/**< scans every 5 ms, the bounces of each press and release are shorter than both debounce windows */
+static const fuzz_trace_edge_t s_bounce_trace[] = {
+    {10500, 1}, {10800, 0}, {11600, 1}, {12400, 0}, {13000, 1},                 /*!< press, stable from 13 ms*/
+    {64000, 0}, {66000, 1},                                                     /*!< glitch seen by the 65 ms scan only*/
+    {150500, 0}, {151000, 1}, {151700, 0}, {152800, 1}, {153400, 0},            /*!< release*/
+    {250500, 1}, {252000, 0}, {254500, 1}, {255500, 0}, {257500, 1},            /*!< press bouncing over two scans*/
+    {400500, 0}, {401300, 1}, {402000, 0},                                      /*!< release*/
+};
+
+#define FUZZ_TRACE_END_US   500000
+#define FUZZ_TRACE_STEP_US  100
+#define FUZZ_TRACE_EDGE_MAX 8
+
+typedef struct {
+    uint32_t time_us;
+    button_event_t event;
+} fuzz_accepted_edge_t;
+
+static fuzz_accepted_edge_t s_accepted[2][FUZZ_TRACE_EDGE_MAX];
+static int s_accepted_num[2];
+static int64_t s_trace_start_us;
+
+static void fuzz_accept_cb(void *button_handle, void *usr_data)
+{
+    intptr_t index = (intptr_t)usr_data;
+    FUZZ_CHECK(s_accepted_num[index] < FUZZ_TRACE_EDGE_MAX);
+    fuzz_accepted_edge_t *edge = &s_accepted[index][s_accepted_num[index]++];
+    edge->time_us = (uint32_t)(s_now_us - s_trace_start_us);
+    edge->event = iot_button_get_event(button_handle);
+}
+
+/**
+ * The same bounce trace on the pins of two GPIO buttons, one debounced by the software kernel, the
+ * other by the GPIO edge interrupt. Both must accept the same presses and releases, the edge backend
+ * at most one scan apart, and neither the glitch.
+ */
+static void fuzz_check_debounce(void)
+{
+    const int pins[2] = {2, 3};
+    const button_debounce_type_t types[2] = {BUTTON_DEBOUNCE_SOFTWARE, BUTTON_DEBOUNCE_GPIO_EDGE};
+    button_handle_t btn[2];
+    for (intptr_t i = 0; i < 2; i++) {
+        button_config_t cfg = {0};
+        cfg.type = BUTTON_TYPE_GPIO;
+        cfg.gpio_button_config.gpio_num = pins[i];
+        cfg.gpio_button_config.active_level = 1;
+        cfg.gpio_button_config.debounce = types[i];
+        btn[i] = iot_button_create(&cfg);
+        FUZZ_CHECK(btn[i]);
+        FUZZ_CHECK(ESP_OK == iot_button_register_cb(btn[i], BUTTON_PRESS_DOWN, fuzz_accept_cb, (void *)i));
+        FUZZ_CHECK(ESP_OK == iot_button_register_cb(btn[i], BUTTON_PRESS_UP, fuzz_accept_cb, (void *)i));
+        s_accepted_num[i] = 0;
+    }
+    /**< only the edge backend hooks the interrupt of its pin */
+    FUZZ_CHECK(NULL == s_gpio_isr[pins[0]].handler);
+    FUZZ_CHECK(NULL != s_gpio_isr[pins[1]].handler && s_gpio_isr[pins[1]].enabled);
+
+    s_trace_start_us = s_now_us;
+    size_t next = 0;
+    for (uint32_t t = FUZZ_TRACE_STEP_US; t <= FUZZ_TRACE_END_US; t += FUZZ_TRACE_STEP_US) {
+        s_now_us = s_trace_start_us + t;
+        for (; next < sizeof(s_bounce_trace) / sizeof(s_bounce_trace[0]) && s_bounce_trace[next].time_us <= t; next++) {
+            for (int i = 0; i < 2; i++) {
+                /**< the pin changes, then its interrupt reports the edge */
+                uint8_t last = s_gpio_level[pins[i]];
+                fuzz_gpio_isr_t *isr = &s_gpio_isr[pins[i]];
+                s_gpio_level[pins[i]] = s_bounce_trace[next].level;
+                if (last != s_bounce_trace[next].level && isr->handler && isr->enabled && GPIO_INTR_ANYEDGE == isr->type) {
+                    isr->handler(isr->arg);
+                }
+            }
+        }
+        if (0 == t % (CONFIG_BUTTON_PERIOD_TIME_MS * 1000) && s_timer && s_timer->running) {
+            s_timer->callback(s_timer->arg);
+        }
+    }
+
+    FUZZ_CHECK(4 == s_accepted_num[0] && 4 == s_accepted_num[1]);
+    for (int i = 0; i < 4; i++) {
+        FUZZ_CHECK(s_accepted[0][i].event == (i % 2 ? BUTTON_PRESS_UP : BUTTON_PRESS_DOWN));
+        FUZZ_CHECK(s_accepted[1][i].event == s_accepted[0][i].event);
+        uint32_t apart = s_accepted[1][i].time_us > s_accepted[0][i].time_us ? s_accepted[1][i].time_us - s_accepted[0][i].time_us : s_accepted[0][i].time_us - s_accepted[1][i].time_us;
+        FUZZ_CHECK(apart <= CONFIG_BUTTON_PERIOD_TIME_MS * 1000);
+    }
+
+    FUZZ_CHECK(ESP_OK == iot_button_delete(btn[0]));
+    FUZZ_CHECK(ESP_OK == iot_button_delete(btn[1]));
+    FUZZ_CHECK(NULL == s_gpio_isr[pins[1]].handler);
+    FUZZ_CHECK(NULL == s_timer);
+    fuzz_run_tasks();
+}
+
+static uint32_t fuzz_rand(uint32_t *state)
+{
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return *state = x;
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t iterations = 0;
+    uint32_t seed = 1;
+    int files = 0;
+    static uint8_t buf[4096];
+
+    for (int i = 1; i < argc; i++) {
+        if (0 == strcmp(argv[i], "-n") && i + 1 < argc) {
+            iterations = strtoul(argv[++i], NULL, 0);
+        } else if (0 == strcmp(argv[i], "-c")) {
+            fuzz_check_sleep();
+            fuzz_check_debounce();
+            printf("host checks passed\n");
+            files++;
+        } else if (0 == strcmp(argv[i], "-s") && i + 1 < argc) {
+            seed = strtoul(argv[++i], NULL, 0);
+            seed = seed ? seed : 1;
+        } else {
+            /**< replay an input file, as given by AFL++ with @@ or by a crash report */
+            FILE *f = fopen(argv[i], "rb");
+            if (!f) {
+                perror(argv[i]);
+                return 1;
+            }
+            size_t size = fread(buf, 1, sizeof(buf), f);
+            fclose(f);
+            LLVMFuzzerTestOneInput(buf, size);
+            files++;
+        }
+    }
+    if (0 == files && 0 == iterations) {
+        /**< AFL++ without @@ feeds the input on stdin */
+        size_t size = fread(buf, 1, sizeof(buf), stdin);
+        LLVMFuzzerTestOneInput(buf, size);
+        return 0;
+    }
+
+    uint64_t ops = 0;
+    clock_t start = clock();
+    for (uint32_t n = 0; n < iterations; n++) {
+        size_t size = fuzz_rand(&seed) % 512 + 1;
+        for (size_t i = 0; i < size; i++) {
+            buf[i] = fuzz_rand(&seed);
+        }
+        LLVMFuzzerTestOneInput(buf, size);
+        ops += size;
+    }
+    if (iterations) {
+        double elapsed = (double)(clock() - start) / CLOCKS_PER_SEC;
+        printf("%u iterations in %.1f s (%.0f/s), %llu input bytes, %u callbacks, simulated %lld s\n", iterations, elapsed,
+               elapsed > 0 ? iterations / elapsed : 0, (unsigned long long)ops, s_cb_cnt, (long long)(s_now_us / 1000000));
+    }
+    return 0;
+}
+#endif
@@ -0,0 +1,4 @@
+/* Host shim, only the types used by the button headers */
+#pragma once
+
+typedef struct spi_device_t *spi_device_handle_t;
@@ -0,0 +1,2 @@
+#pragma once
+typedef struct adc_oneshot_unit_ctx_t *adc_oneshot_unit_handle_t;
@@ -0,0 +1,3 @@
+#pragma once
+#define IRAM_ATTR
+#define RTC_DATA_ATTR
@@ -0,0 +1,7 @@
+#pragma once
+#include "esp_err.h"
+
+typedef enum { ESP_SLEEP_WAKEUP_UNDEFINED, ESP_SLEEP_WAKEUP_EXT1, ESP_SLEEP_WAKEUP_GPIO } esp_sleep_wakeup_cause_t;
+
+esp_err_t esp_sleep_enable_gpio_wakeup(void);
+esp_sleep_wakeup_cause_t esp_sleep_get_wakeup_cause(void);
@@ -0,0 +1,11 @@
+/* Host shim, queues are drained by the fuzz target between operations */
+#pragma once
+#include "freertos/FreeRTOS.h"
+
+typedef struct fuzz_queue *QueueHandle_t;
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size);
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t wait);
+BaseType_t xQueueSendFromISR(QueueHandle_t queue, const void *item, BaseType_t *woken);
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t wait);
+void vQueueDelete(QueueHandle_t queue);
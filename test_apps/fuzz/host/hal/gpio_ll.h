@@ -0,0 +1,14 @@
+/* Host shim, the input register of the GPIO peripheral */
+#pragma once
+#include <stdint.h>
+
+typedef struct {
+    volatile uint32_t in;
+    volatile uint32_t in1;
+} gpio_dev_t;
+extern gpio_dev_t GPIO;
+
+static inline int gpio_ll_get_level(gpio_dev_t *hw, uint32_t gpio_num)
+{
+    return gpio_num < 32 ? (hw->in >> gpio_num) & 1 : (hw->in1 >> (gpio_num - 32)) & 1;
+}
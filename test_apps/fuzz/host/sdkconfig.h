@@ -0,0 +1,2 @@
+#pragma once
+#define CONFIG_ESP_TIMER_SUPPORTS_ISR_DISPATCH_METHOD 1
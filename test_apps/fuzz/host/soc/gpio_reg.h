@@ -0,0 +1,6 @@
+/* Host shim, the input registers are the fields of the GPIO shim */
+#pragma once
+#include "hal/gpio_ll.h"
+
+#define GPIO_IN_REG     ((uintptr_t)&GPIO.in)
+#define GPIO_IN1_REG    ((uintptr_t)&GPIO.in1)
@@ -0,0 +1,5 @@
+/* Host shim, register access */
+#pragma once
+#include <stdint.h>
+
+#define REG_READ(reg) (*(volatile uint32_t *)(reg))
@@ -0,0 +1,2 @@
+/* No glitch filter and no ext1 wakeup on host */
+#pragma once
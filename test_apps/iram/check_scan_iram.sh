@@ -0,0 +1,69 @@
+#!/bin/sh
+# SPDX-FileCopyrightText: 2022-2023 Espressif Systems (Shanghai) CO LTD
+#
+# SPDX-License-Identifier: Apache-2.0
+#
+# Section map check of CONFIG_BUTTON_SCAN_IRAM, on a host.
+#
+# Builds the scan sources with CONFIG_BUTTON_SCAN_IRAM set, one section per function, and
+# checks every relocation of the .iram1 sections: code in IRAM, data in DRAM, or one of the
+# ESP-IDF functions below, which are in IRAM or ROM. A call to a function in flash, a string
+# or a jump table in .rodata fails the check. Calls through hal_button_Level are not seen.
+#
+# Usage, from anywhere: sh test_apps/iram/check_scan_iram.sh [compiler]
+
+set -e
+CC=${1:-${CC:-gcc}}
+HERE=$(cd "$(dirname "$0")" && pwd)
+ROOT=$(cd "$HERE/../.." && pwd)
+TMP=$(mktemp -d)
+trap 'rm -rf "$TMP"' EXIT
+
+ALLOWED="esp_timer_get_time esp_timer_isr_dispatch_need_yield xQueueSendFromISR xPortInIsrContext xQueueSend esp_rom_printf memcpy memset GPIO"
+SRCS="iot_button.c button_debounce.c button_virtual.c button_gpio.c button_encoder.c"
+
+# quoted includes resolve next to the sources first, so the config is changed on a copy
+cp "$ROOT"/src/original/*.c "$ROOT"/src/original/*.h "$TMP"
+sed -i 's/^#define CONFIG_BUTTON_SCAN_IRAM 0/#define CONFIG_BUTTON_SCAN_IRAM 1/' "$TMP/arduino_config.h"
+grep -q '^#define CONFIG_BUTTON_SCAN_IRAM 1' "$TMP/arduino_config.h"
+
+for src in $SRCS; do
+    "$CC" -c -O2 -w -fno-pic -fno-stack-protector -ffunction-sections -fdata-sections \
+        -I"$HERE/host" -I"$ROOT/test_apps/fuzz/host" -I"$TMP" "$TMP/$src" -o "$TMP/${src%.c}.o"
+done
+
+# defined symbols: name section
+for obj in "$TMP"/*.o; do
+    objdump -t "$obj" | awk '$2 ~ /^[gl]$/ && NF >= 6 { print $NF, $(NF - 2) }'
+done | sort -u > "$TMP/symbols"
+
+for obj in "$TMP"/*.o; do
+    for sec in $(objdump -h "$obj" | awk '$2 ~ /^\.iram1\./ { print $2 }'); do
+        for target in $(objdump -r -j "$sec" "$obj" | awk 'NR > 5 && NF == 3 { print $3 }' | sed 's/[+-]0x[0-9a-f]*$//'); do
+            case "$target" in
+            .*) where=$target ;;
+            *) where=$(awk -v s="$target" '$1 == s { print $2; exit }' "$TMP/symbols") ;;
+            esac
+            case "$where" in
+            .iram1.* | .dram1.* | .bss* | .data* | .rtc.data.*) continue ;;
+            "")
+                case " $ALLOWED " in
+                *" $target "*) continue ;;
+                esac
+                where="undefined" ;;
+            esac
+            echo "$(basename "$obj") $sec: $target in $where is not in IRAM or DRAM"
+        done
+    done
+done > "$TMP/errors"
+
+checked=$(for obj in "$TMP"/*.o; do objdump -h "$obj"; done | grep -c ' \.iram1\.' || true)
+if [ "$checked" -eq 0 ]; then
+    echo "no .iram1 section found"
+    exit 1
+fi
+if [ -s "$TMP/errors" ]; then
+    sort -u "$TMP/errors"
+    exit 1
+fi
+echo "$checked IRAM functions checked"
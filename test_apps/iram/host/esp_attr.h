@@ -0,0 +1,10 @@
+/* Host shim, the placement attributes give the sections of ESP-IDF, one per function or variable */
+#pragma once
+
+#define _SECTION_ATTR_IMPL(SECTION, COUNTER)    __attribute__((section(SECTION "." _COUNTER_STRINGIFY(COUNTER))))
+#define _COUNTER_STRINGIFY(COUNTER)             #COUNTER
+
+#define IRAM_ATTR       _SECTION_ATTR_IMPL(".iram1", __COUNTER__)
+#define DRAM_ATTR       _SECTION_ATTR_IMPL(".dram1", __COUNTER__)
+#define RTC_DATA_ATTR   _SECTION_ATTR_IMPL(".rtc.data", __COUNTER__)
+#define DRAM_STR(str)   (__extension__({static const DRAM_ATTR char __c[] = (str); (const char *)&__c;}))
@@ -0,0 +1,13 @@
+/* Host shim, the logs keep their references so that a log in flash is seen by the check */
+#pragma once
+#include "esp_attr.h"
+
+void esp_log_write(int level, const char *tag, const char *format, ...);
+int esp_rom_printf(const char *format, ...);
+
+#define ESP_LOGE(tag, format, ...) esp_log_write(1, tag, format, ##__VA_ARGS__)
+#define ESP_LOGW(tag, format, ...) esp_log_write(2, tag, format, ##__VA_ARGS__)
+#define ESP_LOGI(tag, format, ...) esp_log_write(3, tag, format, ##__VA_ARGS__)
+#define ESP_LOGD(tag, format, ...) esp_log_write(4, tag, format, ##__VA_ARGS__)
+#define ESP_LOGV(tag, format, ...) esp_log_write(5, tag, format, ##__VA_ARGS__)
+#define ESP_DRAM_LOGW(tag, format, ...) esp_rom_printf(DRAM_STR(format), tag, ##__VA_ARGS__)
@@ -0,0 +1,21 @@
+/* Host shim of one core: a critical section masks the scan, as portENTER_CRITICAL() on the core of the scan */
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+typedef int BaseType_t;
+typedef unsigned UBaseType_t;
+typedef uint32_t TickType_t;
+typedef struct { int owner; } portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED {0}
+void bench_enter_critical(portMUX_TYPE *mux);
+void bench_exit_critical(portMUX_TYPE *mux);
+#define portENTER_CRITICAL(mux) bench_enter_critical(mux)
+#define portEXIT_CRITICAL(mux) bench_exit_critical(mux)
+#define pdMS_TO_TICKS(ms) (ms)
+#define pdFALSE 0
+#define pdTRUE 1
+#define pdPASS pdTRUE
+#define portMAX_DELAY ((TickType_t)0xffffffffUL)
+BaseType_t xPortInIsrContext(void);
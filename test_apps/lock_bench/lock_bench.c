@@ -0,0 +1,365 @@
+/* SPDX-FileCopyrightText: 2022-2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * Host benchmark of the scan tick against the writers of the button timings.
+ *
+ * One scanner thread runs the callback of the scan timer every period, N writer threads call
+ * the setters of the public API on random buttons without pause. A critical section of the
+ * component masks the scan as it does on the core of the scan timer: the shim takes a priority
+ * inheritance mutex the scanner also takes around each tick, so a writer preempted in its
+ * critical section finishes it first, as the deferred timer interrupt would wait for it.
+ * For each number of writers it reports the lateness of the ticks, the ticks that found a
+ * critical section and the time they waited for it, and the setter calls per second.
+ *
+ * Only the public API is used, so the benchmark also builds against an earlier revision of the
+ * component to compare, see README.md. Exits non-zero if a setter fails.
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include <unistd.h>
+#include "esp_timer.h"
+#include "esp_sleep.h"
+#include "driver/gpio.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
+#include "iot_button.h"
+
+#define BENCH_BUTTON_NUM    8
+#define BENCH_MAX_WRITER    16
+#define BENCH_PRESS_TICKS   60      /**< scans a button is held, of every 100 */
+
+/**
+ * Host shim of the critical sections, of the scan timer and of the drivers the buttons never reach
+ */
+static pthread_mutex_t s_core;
+
+static int64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+void bench_enter_critical(portMUX_TYPE *mux)
+{
+    pthread_mutex_lock(&s_core);
+}
+
+void bench_exit_critical(portMUX_TYPE *mux)
+{
+    pthread_mutex_unlock(&s_core);
+}
+
+struct esp_timer {
+    void (*callback)(void *arg);
+    void *arg;
+    uint64_t period_us;
+    atomic_bool running;
+};
+
+static struct esp_timer s_timer;
+static bool s_timer_created = false;
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t *args, esp_timer_handle_t *handle)
+{
+    if (s_timer_created) {
+        return ESP_ERR_NO_MEM;
+    }
+    s_timer_created = true;
+    s_timer.callback = args->callback;
+    s_timer.arg = args->arg;
+    *handle = &s_timer;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_start_periodic(esp_timer_handle_t timer, uint64_t period)
+{
+    timer->period_us = period;
+    atomic_store(&timer->running, true);
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_stop(esp_timer_handle_t timer)
+{
+    return atomic_exchange(&timer->running, false) ? ESP_OK : ESP_ERR_INVALID_STATE;
+}
+
+esp_err_t esp_timer_delete(esp_timer_handle_t timer)
+{
+    s_timer_created = false;
+    return ESP_OK;
+}
+
+int64_t esp_timer_get_time(void)
+{
+    return now_ns() / 1000;
+}
+
+void esp_timer_isr_dispatch_need_yield(void) {}
+BaseType_t xPortInIsrContext(void) { return pdFALSE; }
+void vTaskDelay(TickType_t ticks) { usleep(ticks * 1000); }
+
+/**< no callback is registered, the callback workers are never started */
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size) { return NULL; }
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t wait) { return pdFALSE; }
+BaseType_t xQueueSendFromISR(QueueHandle_t queue, const void *item, BaseType_t *woken) { return pdFALSE; }
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t wait) { return pdFALSE; }
+void vQueueDelete(QueueHandle_t queue) {}
+BaseType_t xTaskCreate(TaskFunction_t entry, const char *name, uint32_t stack, void *arg, UBaseType_t priority, TaskHandle_t *handle) { return pdFALSE; }
+void vTaskDelete(TaskHandle_t handle) {}
+
+esp_err_t button_gpio_init(const button_gpio_config_t *config) { return ESP_ERR_NOT_SUPPORTED; }
+esp_err_t button_gpio_init_mask(uint64_t pin_bit_mask, uint8_t active_level) { return ESP_ERR_NOT_SUPPORTED; }
+esp_err_t button_gpio_deinit(int gpio_num) { return ESP_OK; }
+uint8_t button_gpio_get_key_level(void *gpio_num) { return 0; }
+esp_err_t button_adc_init(const button_adc_config_t *config) { return ESP_ERR_NOT_SUPPORTED; }
+esp_err_t button_adc_deinit(uint8_t channel, int button_index) { return ESP_OK; }
+uint8_t button_adc_get_key_level(void *button_index) { return 0; }
+esp_err_t button_matrix_init(const button_matrix_config_t *config) { return ESP_ERR_NOT_SUPPORTED; }
+esp_err_t button_matrix_deinit(int row_gpio_num, int col_gpio_num) { return ESP_OK; }
+uint8_t button_matrix_get_key_level(void *hardware_data) { return 0; }
+esp_err_t button_expander_init(const button_expander_config_t *config, void **hardware_data) { return ESP_ERR_NOT_SUPPORTED; }
+esp_err_t button_expander_deinit(void *hardware_data) { return ESP_OK; }
+uint8_t button_expander_get_key_level(void *hardware_data) { return 0; }
+esp_err_t button_shift_init(const button_shift_config_t *config, void **hardware_data) { return ESP_ERR_NOT_SUPPORTED; }
+esp_err_t button_shift_deinit(void *hardware_data) { return ESP_OK; }
+uint8_t button_shift_get_key_level(void *hardware_data) { return 0; }
+esp_err_t button_touch_init(const button_touch_config_t *config) { return ESP_ERR_NOT_SUPPORTED; }
+esp_err_t button_touch_deinit(int32_t touch_pad) { return ESP_OK; }
+uint8_t button_touch_get_key_level(void *touch_pad) { return 0; }
+esp_err_t button_encoder_init(const button_encoder_config_t *config, button_encoder_t **encoder) { return ESP_ERR_NOT_SUPPORTED; }
+esp_err_t button_encoder_deinit(button_encoder_t *encoder) { return ESP_OK; }
+uint8_t button_encoder_scan(button_encoder_t *encoder, uint64_t levels) { return 0; }
+uint8_t button_encoder_get_key_level(void *encoder) { return 0; }
+uint64_t button_gpio_snapshot(void) { return 0; }
+esp_err_t gpio_set_intr_type(gpio_num_t gpio_num, gpio_int_type_t intr_type) { return ESP_OK; }
+esp_err_t gpio_intr_enable(gpio_num_t gpio_num) { return ESP_OK; }
+esp_err_t gpio_intr_disable(gpio_num_t gpio_num) { return ESP_OK; }
+esp_err_t gpio_install_isr_service(int intr_alloc_flags) { return ESP_OK; }
+esp_err_t gpio_isr_handler_add(gpio_num_t gpio_num, void (*isr_handler)(void *), void *args) { return ESP_OK; }
+esp_err_t gpio_isr_handler_remove(gpio_num_t gpio_num) { return ESP_OK; }
+esp_err_t gpio_wakeup_enable(gpio_num_t gpio_num, gpio_int_type_t intr_type) { return ESP_OK; }
+esp_err_t gpio_wakeup_disable(gpio_num_t gpio_num) { return ESP_OK; }
+esp_err_t esp_sleep_enable_gpio_wakeup(void) { return ESP_OK; }
+esp_sleep_wakeup_cause_t esp_sleep_get_wakeup_cause(void) { return ESP_SLEEP_WAKEUP_UNDEFINED; }
+
+/**
+ * Scanner and writers
+ */
+static button_handle_t s_btn[BENCH_BUTTON_NUM];
+static uint8_t s_level[BENCH_BUTTON_NUM];
+static atomic_bool s_stop;
+static atomic_uint_fast64_t s_calls;
+static atomic_uint s_errors;
+
+typedef struct {
+    int64_t *late_ns;       /**< lateness of each tick from its deadline */
+    size_t ticks;
+    size_t masked;          /**< ticks that found a critical section */
+    int64_t masked_ns;
+    int64_t masked_max_ns;
+} bench_scan_t;
+
+static uint8_t bench_get_level(void *param)
+{
+    return *(uint8_t *)param;
+}
+
+static void *bench_scanner(void *arg)
+{
+    bench_scan_t *scan = (bench_scan_t *)arg;
+    int64_t period_ns = s_timer.period_us * 1000;
+    int64_t deadline = now_ns() + period_ns;
+    for (size_t tick = 0; tick < scan->ticks; tick++, deadline += period_ns) {
+        struct timespec ts = {.tv_sec = deadline / 1000000000, .tv_nsec = deadline % 1000000000};
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL);
+        /**< each button is pressed in turn, so the ticks run the long press paths */
+        for (int i = 0; i < BENCH_BUTTON_NUM; i++) {
+            s_level[i] = (tick + i * 13) % 100 < BENCH_PRESS_TICKS;
+        }
+        int64_t start = now_ns();
+        if (0 != pthread_mutex_trylock(&s_core)) {
+            pthread_mutex_lock(&s_core);
+            int64_t masked = now_ns() - start;
+            scan->masked++;
+            scan->masked_ns += masked;
+            if (masked > scan->masked_max_ns) {
+                scan->masked_max_ns = masked;
+            }
+        }
+        scan->late_ns[tick] = now_ns() - deadline;
+        if (atomic_load(&s_timer.running)) {
+            s_timer.callback(s_timer.arg);
+        }
+        pthread_mutex_unlock(&s_core);
+    }
+    atomic_store(&s_stop, true);
+    return NULL;
+}
+
+static void *bench_writer(void *arg)
+{
+    unsigned seed = (unsigned)(uintptr_t)arg;
+    uint64_t calls = 0;
+    while (!atomic_load(&s_stop)) {
+        button_handle_t btn = s_btn[rand_r(&seed) % BENCH_BUTTON_NUM];
+        esp_err_t ret;
+        switch (rand_r(&seed) % 3) {
+        case 0:
+            ret = iot_button_set_param(btn, BUTTON_LONG_PRESS_TIME_MS, (void *)(uintptr_t)(1000 + rand_r(&seed) % 1000));
+            break;
+        case 1: {
+            button_timing_config_t timing = {
+                .short_press_time = 180 + rand_r(&seed) % 200,
+                .serial_time = 20 + rand_r(&seed) % 80,
+                .debounce_press_ticks = 1 + rand_r(&seed) % 4,
+            };
+            ret = iot_button_set_timing(btn, &timing);
+            break;
+        }
+        default: {
+            button_hold_config_t hold = {
+                .start_interval_ms = 100 + rand_r(&seed) % 100,
+                .min_interval_ms = 20,
+                .ramp_ms = 1000,
+            };
+            ret = iot_button_set_hold_config(btn, &hold);
+            break;
+        }
+        }
+        if (ESP_OK != ret) {
+            atomic_fetch_add(&s_errors, 1);
+        }
+        calls++;
+    }
+    atomic_fetch_add(&s_calls, calls);
+    return NULL;
+}
+
+static int compare_ns(const void *a, const void *b)
+{
+    int64_t x = *(const int64_t *)a, y = *(const int64_t *)b;
+    return (x > y) - (x < y);
+}
+
+static bool s_realtime = true;
+
+static void run(int writers, double seconds)
+{
+    bench_scan_t scan = {0};
+    scan.ticks = seconds * 1000000 / s_timer.period_us;
+    scan.late_ns = calloc(scan.ticks, sizeof(int64_t));
+    atomic_store(&s_stop, false);
+    atomic_store(&s_calls, 0);
+
+    pthread_t writer[BENCH_MAX_WRITER];
+    for (int i = 0; i < writers; i++) {
+        pthread_create(&writer[i], NULL, bench_writer, (void *)(uintptr_t)(i + 1));
+    }
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    if (s_realtime) {
+        struct sched_param param = {.sched_priority = sched_get_priority_max(SCHED_FIFO)};
+        pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED);
+        pthread_attr_setschedpolicy(&attr, SCHED_FIFO);
+        pthread_attr_setschedparam(&attr, &param);
+    }
+    pthread_t scanner;
+    if (0 != pthread_create(&scanner, &attr, bench_scanner, &scan)) {
+        /**< no real-time priority: the lateness also holds the scheduling of the host */
+        s_realtime = false;
+        pthread_create(&scanner, NULL, bench_scanner, &scan);
+    }
+    pthread_attr_destroy(&attr);
+    pthread_join(scanner, NULL);
+    for (int i = 0; i < writers; i++) {
+        pthread_join(writer[i], NULL);
+    }
+
+    qsort(scan.late_ns, scan.ticks, sizeof(int64_t), compare_ns);
+    printf("%7d %7zu %9.1f %9.1f %9.1f %9.1f %8.2f %9.1f %9.1f %12.0f\n", writers, scan.ticks,
+           scan.late_ns[scan.ticks / 2] / 1e3, scan.late_ns[scan.ticks * 99 / 100] / 1e3,
+           scan.late_ns[scan.ticks * 999 / 1000] / 1e3, scan.late_ns[scan.ticks - 1] / 1e3,
+           100.0 * scan.masked / scan.ticks, scan.masked ? scan.masked_ns / 1e3 / scan.masked : 0.0,
+           scan.masked_max_ns / 1e3, atomic_load(&s_calls) / seconds);
+    free(scan.late_ns);
+}
+
+int main(int argc, char **argv)
+{
+    double seconds = 5;
+    int max_writers = 4;
+    int opt;
+    while ((opt = getopt(argc, argv, "t:w:")) != -1) {
+        switch (opt) {
+        case 't':
+            seconds = atof(optarg);
+            break;
+        case 'w':
+            max_writers = atoi(optarg);
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-t seconds per run] [-w max writers]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (seconds <= 0 || max_writers < 0 || max_writers > BENCH_MAX_WRITER) {
+        fprintf(stderr, "invalid arguments\n");
+        return 2;
+    }
+
+    /**< the critical sections mask the scan tick, a preempted writer inherits the priority of the scanner */
+    pthread_mutexattr_t mattr;
+    pthread_mutexattr_init(&mattr);
+    pthread_mutexattr_setprotocol(&mattr, PTHREAD_PRIO_INHERIT);
+    pthread_mutexattr_settype(&mattr, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(&s_core, &mattr);
+    pthread_mutexattr_destroy(&mattr);
+
+    for (int i = 0; i < BENCH_BUTTON_NUM; i++) {
+        button_config_t cfg = {
+            .type = BUTTON_TYPE_CUSTOM,
+            .custom_button_config = {
+                .active_level = 1,
+                .button_custom_get_key_value = bench_get_level,
+                .priv = &s_level[i],
+            },
+        };
+        s_btn[i] = iot_button_create(&cfg);
+        if (NULL == s_btn[i]) {
+            fprintf(stderr, "button create failed\n");
+            return 1;
+        }
+    }
+
+    printf("%d buttons, scan every %u us, %d cpus\n", BENCH_BUTTON_NUM, (unsigned)s_timer.period_us, (int)sysconf(_SC_NPROCESSORS_ONLN));
+    printf("%7s %7s %9s %9s %9s %9s %8s %9s %9s %12s\n", "writers", "ticks", "late p50", "p99", "p99.9", "max",
+           "masked%", "mask avg", "mask max", "setters/s");
+    for (int writers = 0; writers <= max_writers; writers = writers ? writers * 2 : 1) {
+        run(writers, seconds);
+    }
+    if (!s_realtime) {
+        printf("no real-time priority for the scanner, the lateness includes the scheduling of the host\n");
+    }
+    printf("times in us\n");
+
+    for (int i = 0; i < BENCH_BUTTON_NUM; i++) {
+        iot_button_delete(s_btn[i]);
+    }
+    unsigned errors = atomic_load(&s_errors);
+    if (errors) {
+        fprintf(stderr, "%u setter calls failed\n", errors);
+        return 1;
+    }
+    return 0;
+}
@@ -4,6 +4,9 @@
  */
 
 #include "stdio.h"
+#include "string.h"
+#include <array>
+#include <utility>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/queue.h"
@@ -16,6 +19,9 @@
 #include "esp_adc/adc_cali.h"
 #endif
 #include "unity.h"
+#include "esp_timer.h"
+#include "esp_sleep.h"
+#include "driver/gpio.h"
 #include "Button.h"
 #include "sdkconfig.h"
 
@@ -74,6 +80,1545 @@ TEST_CASE("gpio button test", "[button][iot]")
     btn.del();
 }
 
+static uint8_t s_custom_level = 0;
+static int s_press_down_cnt = 0;
+
+static uint8_t custom_button_get_level(void *param)
+{
+    return *(uint8_t *)param;
+}
+
+static void onCustomButtonPressDownCb(void *button_handle, void *usr_data)
+{
+    s_press_down_cnt++;
+}
+
+TEST_CASE("custom button sleep state test", "[button][sleep]")
+{
+    button_config_t cfg = {};
+    cfg.type = BUTTON_TYPE_CUSTOM;
+    cfg.custom_button_config.active_level = 1;
+    cfg.custom_button_config.button_custom_get_key_value = custom_button_get_level;
+    cfg.custom_button_config.priv = &s_custom_level;
+
+    s_custom_level = 0;
+    s_press_down_cnt = 0;
+    button_handle_t btn = iot_button_create(&cfg);
+    TEST_ASSERT_NOT_NULL(btn);
+    TEST_ASSERT_EQUAL(ESP_OK, iot_button_register_cb(btn, BUTTON_PRESS_DOWN, onCustomButtonPressDownCb, NULL));
+
+    TEST_ASSERT_EQUAL(ESP_OK, iot_button_enter_sleep(BUTTON_SLEEP_LIGHT));
+    /* the button is pressed while the chip is sleeping */
+    s_custom_level = 1;
+    TEST_ASSERT_EQUAL(ESP_OK, iot_button_exit_sleep());
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_STATE, iot_button_exit_sleep());
+
+    /* the pressing edge is replayed on the first scan, without debounce */
+    vTaskDelay(pdMS_TO_TICKS(CONFIG_BUTTON_PERIOD_TIME_MS * 2));
+    TEST_ASSERT_EQUAL(1, s_press_down_cnt);
+    TEST_ASSERT_EQUAL(BUTTON_PRESS_DOWN, iot_button_get_event(btn));
+
+    s_custom_level = 0;
+    vTaskDelay(pdMS_TO_TICKS(CONFIG_BUTTON_SHORT_PRESS_TIME_MS * 2));
+    TEST_ASSERT_EQUAL(ESP_OK, iot_button_delete(btn));
+}
+
+static int s_long_press_start_cnt = 0;
+
+static void onCustomButtonLongPressStartCb(void *button_handle, void *usr_data)
+{
+    s_long_press_start_cnt++;
+}
+
+TEST_CASE("gpio button sleep long press test", "[button][sleep][hold]")
+{
+    button_config_t cfg = {};
+    cfg.type = BUTTON_TYPE_GPIO;
+    cfg.gpio_button_config.gpio_num = BUTTON_IO_NUM;
+    cfg.gpio_button_config.active_level = BUTTON_ACTIVE_LEVEL;
+    s_long_press_start_cnt = 0;
+    button_handle_t btn = iot_button_create(&cfg);
+    TEST_ASSERT_NOT_NULL(btn);
+    TEST_ASSERT_EQUAL(ESP_OK, gpio_set_direction((gpio_num_t)BUTTON_IO_NUM, GPIO_MODE_INPUT_OUTPUT));
+    gpio_set_level((gpio_num_t)BUTTON_IO_NUM, !BUTTON_ACTIVE_LEVEL);
+    button_timing_config_t set = {};
+    set.long_press_time = 300;
+    TEST_ASSERT_EQUAL(ESP_OK, iot_button_set_timing(btn, &set));
+    button_event_config_t event_cfg = {};
+    event_cfg.event = BUTTON_LONG_PRESS_START;
+    event_cfg.event_data.long_press.press_time = 800;
+    TEST_ASSERT_EQUAL(ESP_OK, iot_button_register_event_cb(btn, event_cfg, onCustomButtonLongPressStartCb, NULL));
+
+    gpio_set_level((gpio_num_t)BUTTON_IO_NUM, BUTTON_ACTIVE_LEVEL);
+    vTaskDelay(pdMS_TO_TICKS(400));
+    TEST_ASSERT_EQUAL(BUTTON_LONG_PRESS_HOLD, iot_button_get_event(btn));
+
+    /* the long press is raised past the time already held, then the state is saved and restored */
+    set.long_press_time = 600;
+    TEST_ASSERT_EQUAL(ESP_OK, iot_button_set_timing(btn, &set));
+    vTaskDelay(pdMS_TO_TICKS(CONFIG_BUTTON_PERIOD_TIME_MS * 2));
+    TEST_ASSERT_EQUAL(ESP_OK, iot_button_enter_sleep(BUTTON_SLEEP_LIGHT));
+    TEST_ASSERT_EQUAL(ESP_OK, iot_button_exit_sleep());
+
+    /* the steps of the long press resume from the raised time and reach the 800 ms callback */
+    vTaskDelay(pdMS_TO_TICKS(600));
+    TEST_ASSERT_EQUAL(1, s_long_press_start_cnt);
+    gpio_set_level((gpio_num_t)BUTTON_IO_NUM, !BUTTON_ACTIVE_LEVEL);
+    vTaskDelay(pdMS_TO_TICKS(50));
+    TEST_ASSERT_EQUAL(ESP_OK, iot_button_delete(btn));
+}
+
+TEST_CASE("gpio button edge debounce light sleep test", "[button][sleep][debounce]")
+{
+    button_config_t cfg = {};
+    cfg.type = BUTTON_TYPE_GPIO;
+    cfg.gpio_button_config.gpio_num = BUTTON_IO_NUM;
+    cfg.gpio_button_config.active_level = BUTTON_ACTIVE_LEVEL;
+    cfg.gpio_button_config.debounce = BUTTON_DEBOUNCE_GPIO_EDGE;
+    button_handle_t btn = iot_button_create(&cfg);
+    TEST_ASSERT_NOT_NULL(btn);
+    /* the pin is driven by its own output, the input and its edge interrupt stay enabled */
+    TEST_ASSERT_EQUAL(ESP_OK, gpio_set_direction((gpio_num_t)BUTTON_IO_NUM, GPIO_MODE_INPUT_OUTPUT));
+    gpio_set_level((gpio_num_t)BUTTON_IO_NUM, !BUTTON_ACTIVE_LEVEL);
+    vTaskDelay(pdMS_TO_TICKS(50));
+
+    TEST_ASSERT_EQUAL(ESP_OK, iot_button_enter_sleep(BUTTON_SLEEP_LIGHT));
+    TEST_ASSERT_EQUAL(ESP_OK, esp_sleep_enable_timer_wakeup(50 * 1000));
+    TEST_ASSERT_EQUAL(ESP_OK, esp_light_sleep_start());
+    TEST_ASSERT_EQUAL(ESP_OK, iot_button_exit_sleep());
+    esp_sleep_disable_wakeup_source(ESP_SLEEP_WAKEUP_TIMER);
+    vTaskDelay(pdMS_TO_TICKS(CONFIG_BUTTON_DEBOUNCE_STABLE_TIME_US / 1000 + 20));
+
+    /* the edge interrupt is back after wakeup: a press is timestamped and reported */
+    uint32_t edge_time = iot_button_get_edge_time(btn);
+    gpio_set_level((gpio_num_t)BUTTON_IO_NUM, BUTTON_ACTIVE_LEVEL);
+    vTaskDelay(pdMS_TO_TICKS(1));
+    TEST_ASSERT_NOT_EQUAL(edge_time, iot_button_get_edge_time(btn));
+    vTaskDelay(pdMS_TO_TICKS(CONFIG_BUTTON_DEBOUNCE_STABLE_TIME_US / 1000 + CONFIG_BUTTON_PERIOD_TIME_MS * 2));
+    TEST_ASSERT_EQUAL(BUTTON_PRESS_DOWN, iot_button_get_event(btn));
+
+    gpio_set_level((gpio_num_t)BUTTON_IO_NUM, !BUTTON_ACTIVE_LEVEL);
+    vTaskDelay(pdMS_TO_TICKS(CONFIG_BUTTON_SHORT_PRESS_TIME_MS * 2));
+    TEST_ASSERT_EQUAL(ESP_OK, iot_button_delete(btn));
+}
+
+static button_event_info_t s_last_info;
+static int s_info_cb_cnt = 0;
+
+static void onCustomButtonEventInfoCb(const button_event_info_t *info, void *usr_data)
+{
+    s_last_info = *info;
+    s_info_cb_cnt++;
+}
+
+TEST_CASE("custom button event info test", "[button][event]")
+{
+    button_config_t cfg = {};
+    cfg.type = BUTTON_TYPE_CUSTOM;
+    cfg.custom_button_config.active_level = 1;
+    cfg.custom_button_config.button_custom_get_key_value = custom_button_get_level;
+    cfg.custom_button_config.priv = &s_custom_level;
+
+    s_custom_level = 0;
+    s_info_cb_cnt = 0;
+    button_handle_t btn = iot_button_create(&cfg);
+    TEST_ASSERT_NOT_NULL(btn);
+    button_event_config_t event_cfg = {};
+    event_cfg.event = BUTTON_DOUBLE_CLICK;
+    TEST_ASSERT_EQUAL(ESP_OK, iot_button_register_info_cb(btn, event_cfg, onCustomButtonEventInfoCb, NULL));
+
+    for (int i = 0; i < 2; i++) {
+        s_custom_level = 1;
+        vTaskDelay(pdMS_TO_TICKS(50));
+        s_custom_level = 0;
+        vTaskDelay(pdMS_TO_TICKS(50));
+    }
+    vTaskDelay(pdMS_TO_TICKS(CONFIG_BUTTON_SHORT_PRESS_TIME_MS * 2));
+
+    TEST_ASSERT_EQUAL(1, s_info_cb_cnt);
+    TEST_ASSERT_EQUAL(btn, s_last_info.handle);
+    TEST_ASSERT_EQUAL(BUTTON_DOUBLE_CLICK, s_last_info.event);
+    TEST_ASSERT_EQUAL(2, s_last_info.repeat);
+    /* no callback needs a third click, the double click is reported on release */
+    TEST_ASSERT_LESS_THAN(CONFIG_BUTTON_SHORT_PRESS_TIME_MS, s_last_info.ticks_time);
+
+    TEST_ASSERT_EQUAL(ESP_OK, iot_button_unregister_info_cb(btn, event_cfg, onCustomButtonEventInfoCb));
+    TEST_ASSERT_EQUAL(0, iot_button_count_cb(btn));
+    TEST_ASSERT_EQUAL(ESP_OK, iot_button_delete(btn));
+}
+
+TEST_CASE("custom button stale handle test", "[button][handle]")
+{
+    button_config_t cfg = {};
+    cfg.type = BUTTON_TYPE_CUSTOM;
+    cfg.custom_button_config.active_level = 1;
+    cfg.custom_button_config.button_custom_get_key_value = custom_button_get_level;
+    cfg.custom_button_config.priv = &s_custom_level;
+
+    button_handle_t btn[3] = {};
+    for (int i = 0; i < 3; i++) {
+        btn[i] = iot_button_create(&cfg);
+        TEST_ASSERT_NOT_NULL(btn[i]);
+    }
+    /**< delete from the middle of the list, the others keep working */
+    TEST_ASSERT_EQUAL(ESP_OK, iot_button_delete(btn[1]));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, iot_button_delete(btn[1]));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, iot_button_register_cb(btn[1], BUTTON_PRESS_DOWN, onCustomButtonPressDownCb, NULL));
+    TEST_ASSERT_EQUAL(BUTTON_NONE_PRESS, iot_button_get_event(btn[1]));
+
+    /**< the slot is reused with a new generation, the old handle stays invalid */
+    button_handle_t reused = iot_button_create(&cfg);
+    TEST_ASSERT_NOT_NULL(reused);
+    TEST_ASSERT_NOT_EQUAL(btn[1], reused);
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, iot_button_delete(btn[1]));
+
+    s_press_down_cnt = 0;
+    s_custom_level = 0;
+    TEST_ASSERT_EQUAL(ESP_OK, iot_button_register_cb(btn[0], BUTTON_PRESS_DOWN, onCustomButtonPressDownCb, NULL));
+    TEST_ASSERT_EQUAL(ESP_OK, iot_button_register_cb(btn[2], BUTTON_PRESS_DOWN, onCustomButtonPressDownCb, NULL));
+    TEST_ASSERT_EQUAL(ESP_OK, iot_button_register_cb(reused, BUTTON_PRESS_DOWN, onCustomButtonPressDownCb, NULL));
+    s_custom_level = 1;
+    vTaskDelay(pdMS_TO_TICKS(50));
+    s_custom_level = 0;
+    vTaskDelay(pdMS_TO_TICKS(50));
+    TEST_ASSERT_EQUAL(3, s_press_down_cnt);
+
+    TEST_ASSERT_EQUAL(ESP_OK, iot_button_delete(btn[0]));
+    TEST_ASSERT_EQUAL(ESP_OK, iot_button_delete(btn[2]));
+    TEST_ASSERT_EQUAL(ESP_OK, iot_button_delete(reused));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, iot_button_delete(reused));
+}
+
+static int s_single_click_cnt = 0;
+
+static void onCustomButtonSingleClickCb(void *button_handle, void *usr_data)
+{
+    s_single_click_cnt++;
+}
+
+static void onCustomButtonRepeatDoneCb(void *button_handle, void *usr_data)
+{
+}
+
+static void custom_button_click(int clicks)
+{
+    for (int i = 0; i < clicks; i++) {
+        s_custom_level = 1;
+        vTaskDelay(pdMS_TO_TICKS(50));
+        s_custom_level = 0;
+        vTaskDelay(pdMS_TO_TICKS(50));
+    }
+}
+
+TEST_CASE("custom button early click test", "[button][click]")
+{
+    button_config_t cfg = {};
+    cfg.type = BUTTON_TYPE_CUSTOM;
+    cfg.custom_button_config.active_level = 1;
+    cfg.custom_button_config.button_custom_get_key_value = custom_button_get_level;
+    cfg.custom_button_config.priv = &s_custom_level;
+
+    s_custom_level = 0;
+    s_single_click_cnt = 0;
+    button_handle_t btn = iot_button_create(&cfg);
+    TEST_ASSERT_NOT_NULL(btn);
+    TEST_ASSERT_EQUAL(0, iot_button_get_click_mask(btn));
+
+    /* only single click handlers: each click is reported on release, two quick clicks are two single clicks */
+    TEST_ASSERT_EQUAL(ESP_OK, iot_button_register_cb(btn, BUTTON_SINGLE_CLICK, onCustomButtonSingleClickCb, NULL));
+    TEST_ASSERT_EQUAL(1 << 1, iot_button_get_click_mask(btn));
+    custom_button_click(1);
+    TEST_ASSERT_EQUAL(1, s_single_click_cnt);
+    custom_button_click(1);
+    TEST_ASSERT_EQUAL(2, s_single_click_cnt);
+
+    /* a triple click handler makes single clicks wait for the window */
+    button_event_config_t event_cfg = {};
+    event_cfg.event = BUTTON_MULTIPLE_CLICK;
+    event_cfg.event_data.multiple_clicks.clicks = 3;
+    TEST_ASSERT_EQUAL(ESP_OK, iot_button_register_event_cb(btn, event_cfg, onCustomButtonPressDownCb, NULL));
+    TEST_ASSERT_EQUAL((1 << 1) | (1 << 3), iot_button_get_click_mask(btn));
+    s_single_click_cnt = 0;
+    s_press_down_cnt = 0;
+    custom_button_click(1);
+    TEST_ASSERT_EQUAL(0, s_single_click_cnt);
+    vTaskDelay(pdMS_TO_TICKS(CONFIG_BUTTON_SHORT_PRESS_TIME_MS));
+    TEST_ASSERT_EQUAL(1, s_single_click_cnt);
+    /* the third click is the highest count, reported on release */
+    custom_button_click(3);
+    TEST_ASSERT_EQUAL(1, s_press_down_cnt);
+    vTaskDelay(pdMS_TO_TICKS(CONFIG_BUTTON_SHORT_PRESS_TIME_MS));
+
+    /* the window is always waited out when a callback sees every click */
+    TEST_ASSERT_EQUAL(ESP_OK, iot_button_register_cb(btn, BUTTON_PRESS_REPEAT_DONE, onCustomButtonRepeatDoneCb, NULL));
+    TEST_ASSERT_TRUE(iot_button_get_click_mask(btn) & BUTTON_CLICK_MASK_ANY);
+    TEST_ASSERT_EQUAL(ESP_OK, iot_button_unregister_cb(btn, BUTTON_PRESS_REPEAT_DONE));
+    TEST_ASSERT_EQUAL(ESP_OK, iot_button_unregister_cb(btn, BUTTON_MULTIPLE_CLICK));
+
+    /* or when asked for */
+    TEST_ASSERT_EQUAL(ESP_OK, iot_button_set_max_clicks(btn, BUTTON_MAX_CLICKS_WINDOW));
+    s_single_click_cnt = 0;
+    custom_button_click(1);
+    TEST_ASSERT_EQUAL(0, s_single_click_cnt);
+    vTaskDelay(pdMS_TO_TICKS(CONFIG_BUTTON_SHORT_PRESS_TIME_MS));
+    TEST_ASSERT_EQUAL(1, s_single_click_cnt);
+
+    TEST_ASSERT_EQUAL(ESP_OK, iot_button_delete(btn));
+}
+
+TEST_CASE("custom button callback table test", "[button][event]")
+{
+    button_config_t cfg = {};
+    cfg.type = BUTTON_TYPE_CUSTOM;
+    cfg.custom_button_config.active_level = 1;
+    cfg.custom_button_config.button_custom_get_key_value = custom_button_get_level;
+    cfg.custom_button_config.priv = &s_custom_level;
+    s_custom_level = 0;
+
+    button_handle_t btn = iot_button_create(&cfg);
+    TEST_ASSERT_NOT_NULL(btn);
+    TEST_ASSERT_EQUAL(0, iot_button_count_cb(btn));
+
+    /**< events registered out of order share one table */
+    button_event_config_t event_cfg = {};
+    event_cfg.event = BUTTON_MULTIPLE_CLICK;
+    event_cfg.event_data.multiple_clicks.clicks = 3;
+    TEST_ASSERT_EQUAL(ESP_OK, iot_button_register_event_cb(btn, event_cfg, onCustomButtonPressDownCb, NULL));
+    TEST_ASSERT_EQUAL(ESP_OK, iot_button_register_cb(btn, BUTTON_PRESS_UP, onCustomButtonPressDownCb, NULL));
+    event_cfg.event_data.multiple_clicks.clicks = 2;
+    TEST_ASSERT_EQUAL(ESP_OK, iot_button_register_event_cb(btn, event_cfg, onCustomButtonPressDownCb, NULL));
+    TEST_ASSERT_EQUAL(ESP_OK, iot_button_register_cb(btn, BUTTON_PRESS_DOWN, onCustomButtonPressDownCb, NULL));
+    TEST_ASSERT_EQUAL(ESP_OK, iot_button_register_cb(btn, BUTTON_PRESS_DOWN, onCustomButtonSingleClickCb, NULL));
+    TEST_ASSERT_EQUAL(5, iot_button_count_cb(btn));
+    TEST_ASSERT_EQUAL(2, iot_button_count_event(btn, BUTTON_PRESS_DOWN));
+    TEST_ASSERT_EQUAL(1, iot_button_count_event(btn, BUTTON_PRESS_UP));
+    TEST_ASSERT_EQUAL(2, iot_button_count_event(btn, BUTTON_MULTIPLE_CLICK));
+    TEST_ASSERT_EQUAL((1 << 2) | (1 << 3), iot_button_get_click_mask(btn));
+
+    s_press_down_cnt = 0;
+    s_single_click_cnt = 0;
+    s_custom_level = 1;
+    vTaskDelay(pdMS_TO_TICKS(50));
+    s_custom_level = 0;
+    vTaskDelay(pdMS_TO_TICKS(50));
+    TEST_ASSERT_EQUAL(2, s_press_down_cnt);
+    TEST_ASSERT_EQUAL(1, s_single_click_cnt);
+
+    /**< removing callbacks keeps the other events in place */
+    TEST_ASSERT_EQUAL(ESP_OK, iot_button_unregister_event(btn, event_cfg, onCustomButtonPressDownCb));
+    TEST_ASSERT_EQUAL(1 << 3, iot_button_get_click_mask(btn));
+    TEST_ASSERT_EQUAL(ESP_OK, iot_button_unregister_cb(btn, BUTTON_PRESS_DOWN));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_STATE, iot_button_unregister_cb(btn, BUTTON_PRESS_DOWN));
+    TEST_ASSERT_EQUAL(2, iot_button_count_cb(btn));
+    TEST_ASSERT_EQUAL(1, iot_button_count_event(btn, BUTTON_PRESS_UP));
+    TEST_ASSERT_EQUAL(1, iot_button_count_event(btn, BUTTON_MULTIPLE_CLICK));
+    TEST_ASSERT_EQUAL(ESP_OK, iot_button_unregister_cb(btn, BUTTON_MULTIPLE_CLICK));
+    TEST_ASSERT_EQUAL(ESP_OK, iot_button_unregister_cb(btn, BUTTON_PRESS_UP));
+    TEST_ASSERT_EQUAL(0, iot_button_count_cb(btn));
+
+    /**< the table holds up to BUTTON_CB_MAX_NUM callbacks, then refuses with its own error */
+    for (int i = 0; i < BUTTON_CB_MAX_NUM; i++) {
+        TEST_ASSERT_EQUAL(ESP_OK, iot_button_register_cb(btn, (button_event_t)(i % 2 ? BUTTON_PRESS_UP : BUTTON_PRESS_DOWN), onCustomButtonPressDownCb, NULL));
+    }
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_SIZE, iot_button_register_cb(btn, BUTTON_SINGLE_CLICK, onCustomButtonPressDownCb, NULL));
+    TEST_ASSERT_EQUAL(BUTTON_CB_MAX_NUM, iot_button_count_cb(btn));
+    TEST_ASSERT_EQUAL(ESP_OK, iot_button_unregister_cb(btn, BUTTON_PRESS_UP));
+    TEST_ASSERT_EQUAL(ESP_OK, iot_button_register_cb(btn, BUTTON_SINGLE_CLICK, onCustomButtonPressDownCb, NULL));
+    TEST_ASSERT_EQUAL(BUTTON_CB_MAX_NUM / 2 + 2, iot_button_count_cb(btn));
+    TEST_ASSERT_EQUAL(ESP_OK, iot_button_delete(btn));
+}
+
+static int s_double_click_cnt = 0;
+
+static void onVirtualButtonDoubleClickCb(void *button_handle, void *usr_data)
+{
+    s_double_click_cnt++;
+}
+
+static uint32_t s_virtual_edge_time[4];
+static int s_virtual_edge_cnt = 0;
+
+static void onVirtualButtonEdgeInfoCb(const button_event_info_t *info, void *usr_data)
+{
+    if (s_virtual_edge_cnt < 4) {
+        s_virtual_edge_time[s_virtual_edge_cnt] = info->edge_time;
+    }
+    s_virtual_edge_cnt++;
+}
+
+TEST_CASE("virtual button inject test", "[button][virtual]")
+{
+    button_config_t cfg = {};
+    cfg.type = BUTTON_TYPE_VIRTUAL;
+    cfg.virtual_button_config.active_level = 1;
+
+    button_handle_t btn = iot_button_create(&cfg);
+    TEST_ASSERT_NOT_NULL(btn);
+    TEST_ASSERT_EQUAL(ESP_OK, iot_button_register_cb(btn, BUTTON_PRESS_DOWN, onCustomButtonPressDownCb, NULL));
+    TEST_ASSERT_EQUAL(ESP_OK, iot_button_register_cb(btn, BUTTON_DOUBLE_CLICK, onVirtualButtonDoubleClickCb, NULL));
+    button_event_config_t event_cfg = {};
+    event_cfg.event = BUTTON_PRESS_DOWN;
+    TEST_ASSERT_EQUAL(ESP_OK, iot_button_register_info_cb(btn, event_cfg, onVirtualButtonEdgeInfoCb, NULL));
+    event_cfg.event = BUTTON_PRESS_UP;
+    TEST_ASSERT_EQUAL(ESP_OK, iot_button_register_info_cb(btn, event_cfg, onVirtualButtonEdgeInfoCb, NULL));
+    s_press_down_cnt = 0;
+    s_double_click_cnt = 0;
+    s_virtual_edge_cnt = 0;
+
+    /**< two clicks injected between two scans are replayed one edge per scan */
+    int64_t now = esp_timer_get_time();
+    TEST_ASSERT_EQUAL(ESP_OK, iot_button_inject_level(btn, 1, now));
+    TEST_ASSERT_EQUAL(ESP_OK, iot_button_inject_level(btn, 0, now + 10));
+    TEST_ASSERT_EQUAL(ESP_OK, iot_button_inject_level(btn, 1, now + 20));
+    TEST_ASSERT_EQUAL(ESP_OK, iot_button_inject_level(btn, 1, now + 25));
+    TEST_ASSERT_EQUAL(ESP_OK, iot_button_inject_level(btn, 0, now + 30));
+    vTaskDelay(pdMS_TO_TICKS(CONFIG_BUTTON_SHORT_PRESS_TIME_MS * 2));
+    TEST_ASSERT_EQUAL(2, s_press_down_cnt);
+    TEST_ASSERT_EQUAL(1, s_double_click_cnt);
+    TEST_ASSERT_EQUAL((uint32_t)(now + 30), iot_button_get_edge_time(btn));
+    /**< each queued edge keeps its own time, not the time of the latest one */
+    TEST_ASSERT_EQUAL(4, s_virtual_edge_cnt);
+    TEST_ASSERT_EQUAL((uint32_t)now, s_virtual_edge_time[0]);
+    TEST_ASSERT_EQUAL((uint32_t)(now + 10), s_virtual_edge_time[1]);
+    TEST_ASSERT_EQUAL((uint32_t)(now + 20), s_virtual_edge_time[2]);
+    TEST_ASSERT_EQUAL((uint32_t)(now + 30), s_virtual_edge_time[3]);
+
+    /**< long press keeps the button scanned while no level is injected */
+    TEST_ASSERT_EQUAL(ESP_OK, iot_button_inject_level(btn, 1, 0));
+    vTaskDelay(pdMS_TO_TICKS(CONFIG_BUTTON_LONG_PRESS_TIME_MS + 100));
+    TEST_ASSERT_EQUAL(BUTTON_LONG_PRESS_HOLD, iot_button_get_event(btn));
+    TEST_ASSERT_EQUAL(ESP_OK, iot_button_inject_level(btn, 0, 0));
+    vTaskDelay(pdMS_TO_TICKS(50));
+    TEST_ASSERT_EQUAL(BUTTON_PRESS_UP, iot_button_get_event(btn));
+
+    /**< only virtual buttons accept injected levels */
+    button_config_t custom_cfg = {};
+    custom_cfg.type = BUTTON_TYPE_CUSTOM;
+    custom_cfg.custom_button_config.active_level = 1;
+    custom_cfg.custom_button_config.button_custom_get_key_value = custom_button_get_level;
+    custom_cfg.custom_button_config.priv = &s_custom_level;
+    button_handle_t custom = iot_button_create(&custom_cfg);
+    TEST_ASSERT_NOT_NULL(custom);
+    TEST_ASSERT_EQUAL(ESP_ERR_NOT_SUPPORTED, iot_button_inject_level(custom, 1, 0));
+    TEST_ASSERT_EQUAL(ESP_OK, iot_button_delete(custom));
+
+    TEST_ASSERT_EQUAL(ESP_OK, iot_button_delete(btn));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, iot_button_inject_level(btn, 1, 0));
+}
+
+typedef struct {
+    button_handle_t btn;
+    volatile int injected;
+    volatile bool done;
+    esp_err_t last;
+} virtual_injector_t;
+
+static void virtual_injector_task(void *arg)
+{
+    virtual_injector_t *injector = (virtual_injector_t *)arg;
+    uint8_t level = 1;
+    esp_err_t ret;
+    while (ESP_OK == (ret = iot_button_inject_level(injector->btn, level, 0))) {
+        level = !level;
+        injector->injected++;
+    }
+    injector->last = ret;
+    injector->done = true;
+    vTaskDelete(NULL);
+}
+
+TEST_CASE("virtual button delete while injecting test", "[button][virtual]")
+{
+    button_config_t cfg = {};
+    cfg.type = BUTTON_TYPE_VIRTUAL;
+    cfg.virtual_button_config.active_level = 1;
+
+    /**< the injector keeps posting until the handle is invalid, it must never reach a released mailbox */
+    for (int i = 0; i < 20; i++) {
+        virtual_injector_t injector = {};
+        injector.btn = iot_button_create(&cfg);
+        TEST_ASSERT_NOT_NULL(injector.btn);
+        TEST_ASSERT_EQUAL(pdPASS, xTaskCreate(virtual_injector_task, "injector", 2048, &injector, uxTaskPriorityGet(NULL), NULL));
+        while (injector.injected < 100) {
+            vTaskDelay(1);
+        }
+        TEST_ASSERT_EQUAL(ESP_OK, iot_button_delete(injector.btn));
+        while (!injector.done) {
+            vTaskDelay(1);
+        }
+        TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, injector.last);
+    }
+    /**< let the idle task free the injector stacks before the leak check */
+    vTaskDelay(pdMS_TO_TICKS(20));
+}
+
+#define EXPANDER_PIN_NUM    16
+#define EXPANDER_INT_IO_NUM 4
+
+/**< expander on a mock bus, the input ports are port and each transaction is counted */
+typedef struct {
+    uint16_t port;
+    int reads;
+} mock_expander_t;
+
+static int s_expander_press_cnt[EXPANDER_PIN_NUM];
+
+static esp_err_t mock_expander_read(void *bus_ctx, uint8_t reg, uint8_t *data, size_t len)
+{
+    mock_expander_t *mock = (mock_expander_t *)bus_ctx;
+    mock->reads++;
+    for (size_t i = 0; i < len; i++) {
+        data[i] = mock->port >> (8 * i);
+    }
+    return ESP_OK;
+}
+
+static void onExpanderButtonPressDownCb(void *button_handle, void *usr_data)
+{
+    s_expander_press_cnt[(intptr_t)usr_data]++;
+}
+
+static void expander_buttons_create(const button_expander_bus_config_t *bus, button_handle_t *btns)
+{
+    memset(s_expander_press_cnt, 0, sizeof(s_expander_press_cnt));
+    for (int i = 0; i < EXPANDER_PIN_NUM; i++) {
+        button_config_t cfg = {};
+        cfg.type = BUTTON_TYPE_EXPANDER;
+        cfg.expander_button_config.bus = bus;
+        cfg.expander_button_config.pin = i;
+        cfg.expander_button_config.active_level = 0;
+        btns[i] = iot_button_create(&cfg);
+        TEST_ASSERT_NOT_NULL(btns[i]);
+        TEST_ASSERT_EQUAL(ESP_OK, iot_button_register_cb(btns[i], BUTTON_PRESS_DOWN, onExpanderButtonPressDownCb, (void *)(intptr_t)i));
+    }
+}
+
+TEST_CASE("expander button batched read test", "[button][expander]")
+{
+    mock_expander_t mock = {0xffff, 0};
+    button_expander_bus_config_t bus = {mock_expander_read, &mock, 0x00, 2, -1};
+    button_handle_t btns[EXPANDER_PIN_NUM];
+    expander_buttons_create(&bus, btns);
+    /**< read once when the first button is added */
+    TEST_ASSERT_EQUAL(1, mock.reads);
+
+    /**< one bus transaction per scan for the 16 buttons */
+    int reads = mock.reads;
+    int64_t start = esp_timer_get_time();
+    vTaskDelay(pdMS_TO_TICKS(CONFIG_BUTTON_PERIOD_TIME_MS * 40));
+    int scans = (esp_timer_get_time() - start) / (CONFIG_BUTTON_PERIOD_TIME_MS * 1000);
+    ESP_LOGI(TAG, "%d scans, %d bus reads", scans, mock.reads - reads);
+    TEST_ASSERT_INT_WITHIN(2, scans, mock.reads - reads);
+
+    mock.port = ~((1 << 3) | (1 << 12)) & 0xffff;
+    vTaskDelay(pdMS_TO_TICKS(CONFIG_BUTTON_PERIOD_TIME_MS * 10));
+    for (int i = 0; i < EXPANDER_PIN_NUM; i++) {
+        TEST_ASSERT_EQUAL(i == 3 || i == 12, s_expander_press_cnt[i]);
+    }
+    mock.port = 0xffff;
+    vTaskDelay(pdMS_TO_TICKS(CONFIG_BUTTON_SHORT_PRESS_TIME_MS * 2));
+
+    /**< the pins of an expander are used once */
+    button_config_t cfg = {};
+    cfg.type = BUTTON_TYPE_EXPANDER;
+    cfg.expander_button_config.bus = &bus;
+    cfg.expander_button_config.pin = 3;
+    TEST_ASSERT_NULL(iot_button_create(&cfg));
+
+    for (int i = 0; i < EXPANDER_PIN_NUM; i++) {
+        TEST_ASSERT_EQUAL(ESP_OK, iot_button_delete(btns[i]));
+    }
+}
+
+TEST_CASE("expander button INT test", "[button][expander]")
+{
+    mock_expander_t mock = {0xffff, 0};
+    button_expander_bus_config_t bus = {mock_expander_read, &mock, 0x00, 2, EXPANDER_INT_IO_NUM};
+    button_handle_t btns[EXPANDER_PIN_NUM];
+    expander_buttons_create(&bus, btns);
+    /**< INT is driven by the test, read back by the input */
+    gpio_set_direction((gpio_num_t)EXPANDER_INT_IO_NUM, GPIO_MODE_INPUT_OUTPUT);
+    gpio_set_level((gpio_num_t)EXPANDER_INT_IO_NUM, 1);
+
+    /**< no bus transaction while INT is released */
+    int reads = mock.reads;
+    vTaskDelay(pdMS_TO_TICKS(CONFIG_BUTTON_PERIOD_TIME_MS * 20));
+    TEST_ASSERT_EQUAL(reads, mock.reads);
+
+    mock.port = ~(1 << 7) & 0xffff;
+    vTaskDelay(pdMS_TO_TICKS(CONFIG_BUTTON_PERIOD_TIME_MS * 10));
+    TEST_ASSERT_EQUAL(0, s_expander_press_cnt[7]);
+    gpio_set_level((gpio_num_t)EXPANDER_INT_IO_NUM, 0);
+    vTaskDelay(pdMS_TO_TICKS(CONFIG_BUTTON_PERIOD_TIME_MS * 2));
+    gpio_set_level((gpio_num_t)EXPANDER_INT_IO_NUM, 1);
+    vTaskDelay(pdMS_TO_TICKS(CONFIG_BUTTON_PERIOD_TIME_MS * 10));
+    TEST_ASSERT_EQUAL(1, s_expander_press_cnt[7]);
+    TEST_ASSERT_GREATER_THAN(reads, mock.reads);
+
+    for (int i = 0; i < EXPANDER_PIN_NUM; i++) {
+        TEST_ASSERT_EQUAL(ESP_OK, iot_button_delete(btns[i]));
+    }
+}
+
+#define SHIFT_CHAIN_MAX     8
+#define SHIFT_BENCH_IO_NUM  4
+
+/**< chain of 74HC165 on a mock transport, inputs[0] is shifted in first, each transfer is counted */
+typedef struct {
+    uint8_t inputs[SHIFT_CHAIN_MAX];
+    int transfers;
+    int bits;
+} mock_shift_chain_t;
+
+static int s_shift_press_cnt[8 * SHIFT_CHAIN_MAX];
+
+static esp_err_t mock_shift_read(void *ctx, uint8_t *data, size_t len)
+{
+    mock_shift_chain_t *mock = (mock_shift_chain_t *)ctx;
+    mock->transfers++;
+    mock->bits += 8 * len;
+    memcpy(data, mock->inputs, len);
+    return ESP_OK;
+}
+
+/**< same as mock_shift_read with the GPIO calls of a bit-banged chain */
+static esp_err_t bench_shift_read(void *ctx, uint8_t *data, size_t len)
+{
+    mock_shift_chain_t *mock = (mock_shift_chain_t *)ctx;
+    mock->transfers++;
+    gpio_set_level((gpio_num_t)SHIFT_BENCH_IO_NUM, 0);
+    gpio_set_level((gpio_num_t)SHIFT_BENCH_IO_NUM, 1);
+    for (size_t i = 0; i < len; i++) {
+        uint8_t byte = 0;
+        for (int bit = 7; bit >= 0; bit--) {
+            byte |= (gpio_get_level((gpio_num_t)SHIFT_BENCH_IO_NUM) & (mock->inputs[i] >> bit) & 1) << bit;
+            gpio_set_level((gpio_num_t)SHIFT_BENCH_IO_NUM, 1);
+            gpio_set_level((gpio_num_t)SHIFT_BENCH_IO_NUM, 0);
+            mock->bits++;
+        }
+        data[i] = byte;
+    }
+    return ESP_OK;
+}
+
+static void onShiftButtonPressDownCb(void *button_handle, void *usr_data)
+{
+    s_shift_press_cnt[(intptr_t)usr_data]++;
+}
+
+TEST_CASE("shift register button test", "[button][shift]")
+{
+    mock_shift_chain_t mock = {};
+    memset(mock.inputs, 0xff, sizeof(mock.inputs));
+    button_shift_chain_config_t chain = {};
+    chain.read = mock_shift_read;
+    chain.ctx = &mock;
+    chain.chain_len = 2;
+    button_handle_t btns[16];
+    memset(s_shift_press_cnt, 0, sizeof(s_shift_press_cnt));
+    for (int i = 0; i < 16; i++) {
+        button_config_t cfg = {};
+        cfg.type = BUTTON_TYPE_SHIFT_REG;
+        cfg.shift_button_config.chain = &chain;
+        cfg.shift_button_config.pin = i;
+        cfg.shift_button_config.active_level = 0;
+        btns[i] = iot_button_create(&cfg);
+        TEST_ASSERT_NOT_NULL(btns[i]);
+        TEST_ASSERT_EQUAL(ESP_OK, iot_button_register_cb(btns[i], BUTTON_PRESS_DOWN, onShiftButtonPressDownCb, (void *)(intptr_t)i));
+    }
+    /**< read once when the first button is added */
+    TEST_ASSERT_EQUAL(1, mock.transfers);
+
+    /**< one transfer per scan for the 16 buttons */
+    int transfers = mock.transfers;
+    int64_t start = esp_timer_get_time();
+    vTaskDelay(pdMS_TO_TICKS(CONFIG_BUTTON_PERIOD_TIME_MS * 40));
+    int scans = (esp_timer_get_time() - start) / (CONFIG_BUTTON_PERIOD_TIME_MS * 1000);
+    TEST_ASSERT_INT_WITHIN(2, scans, mock.transfers - transfers);
+
+    /**< input A of the first register and input H of the second one */
+    mock.inputs[0] = 0xfe;
+    mock.inputs[1] = 0x7f;
+    vTaskDelay(pdMS_TO_TICKS(CONFIG_BUTTON_PERIOD_TIME_MS * 10));
+    for (int i = 0; i < 16; i++) {
+        TEST_ASSERT_EQUAL(i == 0 || i == 15, s_shift_press_cnt[i]);
+    }
+    memset(mock.inputs, 0xff, sizeof(mock.inputs));
+    vTaskDelay(pdMS_TO_TICKS(CONFIG_BUTTON_SHORT_PRESS_TIME_MS * 2));
+
+    for (int i = 0; i < 16; i++) {
+        TEST_ASSERT_EQUAL(ESP_OK, iot_button_delete(btns[i]));
+    }
+}
+
+#define SHIFT_BENCH_SCANS   20
+
+TEST_CASE("shift register chain length benchmark", "[button][shift][benchmark]")
+{
+    gpio_config_t io_conf = {};
+    io_conf.mode = GPIO_MODE_INPUT_OUTPUT;
+    io_conf.pin_bit_mask = 1ULL << SHIFT_BENCH_IO_NUM;
+    gpio_config(&io_conf);
+    /**< the chain reads once per pass of the scan, which runs while a button exists */
+    button_config_t scan_cfg = {};
+    scan_cfg.type = BUTTON_TYPE_VIRTUAL;
+    button_handle_t scan_btn = iot_button_create(&scan_cfg);
+    TEST_ASSERT_NOT_NULL(scan_btn);
+
+    for (int len = 1; len <= SHIFT_CHAIN_MAX; len *= 2) {
+        mock_shift_chain_t mock = {};
+        memset(mock.inputs, 0xff, sizeof(mock.inputs));
+        button_shift_chain_config_t chain = {};
+        chain.read = bench_shift_read;
+        chain.ctx = &mock;
+        chain.chain_len = len;
+        void *hardware_data[8 * SHIFT_CHAIN_MAX];
+        for (int i = 0; i < 8 * len; i++) {
+            button_shift_config_t cfg = {&chain, (uint16_t)i, 0};
+            TEST_ASSERT_EQUAL(ESP_OK, button_shift_init(&cfg, &hardware_data[i]));
+        }
+
+        /**< a scan of every button of the chain, one transfer shared by all */
+        int64_t shared_us = 0;
+        mock.bits = 0;
+        for (int s = 0; s < SHIFT_BENCH_SCANS; s++) {
+            vTaskDelay(pdMS_TO_TICKS(CONFIG_BUTTON_PERIOD_TIME_MS));
+            int64_t start = esp_timer_get_time();
+            for (int i = 0; i < 8 * len; i++) {
+                button_shift_get_key_level(hardware_data[i]);
+            }
+            shared_us += esp_timer_get_time() - start;
+        }
+        int shared_total = mock.bits;
+        int shared_bits = shared_total / SHIFT_BENCH_SCANS;
+
+        /**< the same scan with a custom button per input, each one clocking the whole chain */
+        uint8_t data[SHIFT_CHAIN_MAX];
+        int64_t start = esp_timer_get_time();
+        mock.bits = 0;
+        for (int s = 0; s < SHIFT_BENCH_SCANS; s++) {
+            for (int i = 0; i < 8 * len; i++) {
+                bench_shift_read(&mock, data, len);
+            }
+        }
+        int64_t custom_us = esp_timer_get_time() - start;
+        int custom_bits = mock.bits / SHIFT_BENCH_SCANS;
+
+        printf("%d registers, %d buttons: shared %d bits %d us/scan, per button %d bits %d us/scan\n", len, 8 * len,
+               shared_bits, (int)(shared_us / SHIFT_BENCH_SCANS), custom_bits, (int)(custom_us / SHIFT_BENCH_SCANS));
+        /**< a pass of the scan may fall in the middle of the reads of the test */
+        TEST_ASSERT_INT_WITHIN(8 * len * 2, 8 * len * SHIFT_BENCH_SCANS, shared_total);
+        TEST_ASSERT_EQUAL(64 * len * len, custom_bits);
+        for (int i = 0; i < 8 * len; i++) {
+            TEST_ASSERT_EQUAL(ESP_OK, button_shift_deinit(hardware_data[i]));
+        }
+    }
+    TEST_ASSERT_EQUAL(ESP_OK, iot_button_delete(scan_btn));
+    gpio_reset_pin((gpio_num_t)SHIFT_BENCH_IO_NUM);
+}
+
+TEST_CASE("touch button baseline tracking test", "[button][touch]")
+{
+    button_touch_tracker_t tracker;
+
+    /* falling readings, the ESP32 touch sensor */
+    button_touch_tracker_init(&tracker, 100, false);
+    TEST_ASSERT_FALSE(button_touch_tracker_update(&tracker, 0));
+    TEST_ASSERT_FALSE(button_touch_tracker_update(&tracker, 1000));
+    TEST_ASSERT_EQUAL(900, button_touch_tracker_threshold(&tracker));
+    /* a slow drift past the first threshold is not a touch */
+    for (int reading = 1000; reading >= 850; reading--) {
+        for (int i = 0; i < 4; i++) {
+            TEST_ASSERT_FALSE(button_touch_tracker_update(&tracker, reading));
+        }
+    }
+    for (int i = 0; i < 1500; i++) {
+        TEST_ASSERT_FALSE(button_touch_tracker_update(&tracker, 850));
+    }
+    uint32_t threshold = button_touch_tracker_threshold(&tracker);
+    TEST_ASSERT_INT_WITHIN(2, 765, (int)threshold);
+    TEST_ASSERT_TRUE(button_touch_tracker_update(&tracker, threshold));
+    /* frozen while touched, released under 3/4 of the threshold */
+    for (int i = 0; i < 1000; i++) {
+        TEST_ASSERT_TRUE(button_touch_tracker_update(&tracker, threshold + 10));
+    }
+    TEST_ASSERT_EQUAL(threshold, button_touch_tracker_threshold(&tracker));
+    TEST_ASSERT_FALSE(button_touch_tracker_update(&tracker, threshold + 30));
+    /* a reading further from a touch is followed at once */
+    for (int i = 0; i < 40; i++) {
+        button_touch_tracker_update(&tracker, 950);
+    }
+    TEST_ASSERT_EQUAL(855, button_touch_tracker_threshold(&tracker));
+
+    /* rising readings, the ESP32-S2 and ESP32-S3 touch sensor */
+    button_touch_tracker_init(&tracker, 50, true);
+    TEST_ASSERT_FALSE(button_touch_tracker_update(&tracker, 20000));
+    TEST_ASSERT_EQUAL(21000, button_touch_tracker_threshold(&tracker));
+    TEST_ASSERT_FALSE(button_touch_tracker_update(&tracker, 20999));
+    TEST_ASSERT_TRUE(button_touch_tracker_update(&tracker, 21100));
+    TEST_ASSERT_FALSE(button_touch_tracker_update(&tracker, 20000));
+}
+
+#define ENCODER_A_IO_NUM    4
+#define ENCODER_B_IO_NUM    5
+
+/* A in bit 0 and B in bit 1, from the detent of an encoder pulled up */
+static const uint8_t s_encoder_cw[] = {2, 0, 1, 3};
+static const uint8_t s_encoder_ccw[] = {1, 0, 2, 3};
+
+static int encoder_feed(button_encoder_t *encoder, const uint8_t *ab, size_t len)
+{
+    int steps = 0;
+    for (size_t i = 0; i < len; i++) {
+        if (button_encoder_scan(encoder, ab[i]) & BUTTON_ENCODER_REPORT_STEP) {
+            steps += encoder->steps;
+        }
+    }
+    return steps;
+}
+
+TEST_CASE("encoder quadrature decode test", "[button][encoder]")
+{
+    button_encoder_t encoder = {};
+    encoder.gpio_a = 0;
+    encoder.gpio_b = 1;
+    encoder.per_detent = 4;
+    encoder.ab = 3;
+
+    TEST_ASSERT_EQUAL(1, encoder_feed(&encoder, s_encoder_cw, sizeof(s_encoder_cw)));
+    TEST_ASSERT_EQUAL(-1, encoder_feed(&encoder, s_encoder_ccw, sizeof(s_encoder_ccw)));
+    /* bounce of A on the detent */
+    const uint8_t bounce[] = {2, 3, 2, 3, 2, 0, 2, 3};
+    TEST_ASSERT_EQUAL(0, encoder_feed(&encoder, bounce, sizeof(bounce)));
+    /* 01 is missed between two scans, the turn goes on the same way */
+    const uint8_t skip[] = {2, 1, 3};
+    TEST_ASSERT_EQUAL(1, encoder_feed(&encoder, skip, sizeof(skip)));
+    TEST_ASSERT_EQUAL(1, encoder.position);
+
+    encoder.reverse = 1;
+    TEST_ASSERT_EQUAL(-1, encoder_feed(&encoder, s_encoder_cw, sizeof(s_encoder_cw)));
+    encoder.reverse = 0;
+
+    /* two transitions per detent, the detents are 11 and 00 */
+    encoder.per_detent = 2;
+    TEST_ASSERT_EQUAL(2, encoder_feed(&encoder, s_encoder_cw, sizeof(s_encoder_cw)));
+
+    /* 20 detents per second, then stopped */
+    button_encoder_t still = {};
+    encoder = still;
+    encoder.gpio_a = 0;
+    encoder.gpio_b = 1;
+    encoder.per_detent = 4;
+    encoder.ab = 3;
+    int reports = 0;
+    int16_t velocity = 0;
+    for (int i = 0; i < 4 * CONFIG_ENCODER_VELOCITY_WINDOW_MS / CONFIG_BUTTON_PERIOD_TIME_MS; i++) {
+        uint8_t ab = encoder.ab;
+        /* a detent every 50 ms during two windows */
+        if (i < 2 * CONFIG_ENCODER_VELOCITY_WINDOW_MS / CONFIG_BUTTON_PERIOD_TIME_MS) {
+            ab = s_encoder_cw[(i * CONFIG_BUTTON_PERIOD_TIME_MS * 4 / 50) % 4];
+        }
+        if (button_encoder_scan(&encoder, ab) & BUTTON_ENCODER_REPORT_VELOCITY) {
+            if (reports++ == 1) {
+                velocity = encoder.velocity;
+            }
+        }
+    }
+    TEST_ASSERT_INT_WITHIN(10, 20, velocity);
+    TEST_ASSERT_EQUAL(0, encoder.velocity);
+    TEST_ASSERT_EQUAL(0, encoder.window_ticks);
+}
+
+static int s_encoder_steps;
+static int s_encoder_velocity_cnt;
+static int32_t s_encoder_position;
+
+static void encoder_step_cb(const button_event_info_t *info, void *usr_data)
+{
+    TEST_ASSERT_EQUAL(BUTTON_ENCODER_STEP, info->event);
+    s_encoder_steps += info->encoder_steps;
+    s_encoder_position = info->encoder_position;
+}
+
+static void encoder_velocity_cb(const button_event_info_t *info, void *usr_data)
+{
+    s_encoder_velocity_cnt++;
+}
+
+static void encoder_turn(const uint8_t *ab, size_t len)
+{
+    for (size_t i = 0; i < len; i++) {
+        gpio_set_level((gpio_num_t)ENCODER_A_IO_NUM, ab[i] & 1);
+        gpio_set_level((gpio_num_t)ENCODER_B_IO_NUM, ab[i] >> 1);
+        vTaskDelay(pdMS_TO_TICKS(CONFIG_BUTTON_PERIOD_TIME_MS * 3));
+    }
+}
+
+TEST_CASE("encoder button event test", "[button][encoder]")
+{
+    gpio_config_t io_conf = {};
+    io_conf.mode = GPIO_MODE_INPUT_OUTPUT;
+    io_conf.pin_bit_mask = (1ULL << ENCODER_A_IO_NUM) | (1ULL << ENCODER_B_IO_NUM);
+    gpio_config(&io_conf);
+    gpio_set_level((gpio_num_t)ENCODER_A_IO_NUM, 1);
+    gpio_set_level((gpio_num_t)ENCODER_B_IO_NUM, 1);
+
+    button_config_t cfg = {};
+    cfg.type = BUTTON_TYPE_ENCODER;
+    cfg.encoder_config.gpio_a = ENCODER_A_IO_NUM;
+    cfg.encoder_config.gpio_b = ENCODER_B_IO_NUM;
+    button_handle_t encoder = iot_button_create(&cfg);
+    TEST_ASSERT_NOT_NULL(encoder);
+    /* the encoder init sets the GPIOs as inputs, drive them again */
+    gpio_set_direction((gpio_num_t)ENCODER_A_IO_NUM, GPIO_MODE_INPUT_OUTPUT);
+    gpio_set_direction((gpio_num_t)ENCODER_B_IO_NUM, GPIO_MODE_INPUT_OUTPUT);
+
+    button_event_config_t event_cfg = {};
+    event_cfg.event = BUTTON_ENCODER_STEP;
+    TEST_ASSERT_EQUAL(ESP_OK, iot_button_register_info_cb(encoder, event_cfg, encoder_step_cb, NULL));
+    event_cfg.event = BUTTON_ENCODER_VELOCITY;
+    TEST_ASSERT_EQUAL(ESP_OK, iot_button_register_info_cb(encoder, event_cfg, encoder_velocity_cb, NULL));
+    s_encoder_steps = 0;
+    s_encoder_velocity_cnt = 0;
+
+    for (int i = 0; i < 3; i++) {
+        encoder_turn(s_encoder_cw, sizeof(s_encoder_cw));
+    }
+    TEST_ASSERT_EQUAL(3, s_encoder_steps);
+    encoder_turn(s_encoder_ccw, sizeof(s_encoder_ccw));
+    TEST_ASSERT_EQUAL(2, s_encoder_steps);
+    TEST_ASSERT_EQUAL(2, s_encoder_position);
+    /* the velocity windows of the turn, then one with a velocity of 0 */
+    vTaskDelay(pdMS_TO_TICKS(CONFIG_ENCODER_VELOCITY_WINDOW_MS * 3));
+    TEST_ASSERT_GREATER_OR_EQUAL(2, s_encoder_velocity_cnt);
+    int velocity_cnt = s_encoder_velocity_cnt;
+    vTaskDelay(pdMS_TO_TICKS(CONFIG_ENCODER_VELOCITY_WINDOW_MS * 2));
+    TEST_ASSERT_EQUAL(velocity_cnt, s_encoder_velocity_cnt);
+    /* never a press */
+    TEST_ASSERT_EQUAL(BUTTON_NONE_PRESS, iot_button_get_event(encoder));
+
+    TEST_ASSERT_EQUAL(ESP_OK, iot_button_delete(encoder));
+}
+
+#define RAII_CYCLES     2000
+
+static std::array<Button, 4> s_buttons;
+
+TEST_CASE("button raii move test", "[button][raii]")
+{
+    button_virtual_config_t config = {};
+    config.active_level = 1;
+    esp_log_level_set("arduino-button", ESP_LOG_WARN);
+
+    for (int i = 0; i < RAII_CYCLES; i++) {
+        button_handle_t handles[3];
+        {
+            Button a(config);
+            handles[0] = a.getHandle();
+            TEST_ASSERT_NOT_NULL(handles[0]);
+
+            /**< a move hands the handle over, the moved-from button is empty */
+            Button b(std::move(a));
+            TEST_ASSERT_NULL(a.getHandle());
+            TEST_ASSERT_EQUAL_PTR(handles[0], b.getHandle());
+
+            /**< assigning to a button deletes the handle it owned */
+            s_buttons[i % s_buttons.size()] = std::move(b);
+            s_buttons[(i + 1) % s_buttons.size()] = Button(config);
+            handles[1] = s_buttons[(i + 1) % s_buttons.size()].getHandle();
+            Button c(config);
+            handles[2] = c.getHandle();
+            c = std::move(s_buttons[i % s_buttons.size()]);
+            TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, iot_button_delete(handles[2]));
+            TEST_ASSERT_NULL(s_buttons[i % s_buttons.size()].getHandle());
+            TEST_ASSERT_EQUAL(0, c.countCallBack());
+
+            /**< del() before the destructor deletes once */
+            b = Button(config);
+            b.del();
+            TEST_ASSERT_NULL(b.getHandle());
+        }
+        /**< out of scope, each handle was deleted exactly once */
+        TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, iot_button_delete(handles[0]));
+        TEST_ASSERT_EQUAL_PTR(handles[1], s_buttons[(i + 1) % s_buttons.size()].getHandle());
+    }
+    for (Button &btn : s_buttons) {
+        btn = Button();
+    }
+    esp_log_level_set("arduino-button", ESP_LOG_INFO);
+}
+
+TEST_CASE("button lambda callback test", "[button][function]")
+{
+    button_virtual_config_t config = {};
+    config.active_level = 1;
+    int press_down = 0;
+    int clicks[2] = {0, 0};
+
+    /**< more attaches than slots over the cycles, slots are released with the buttons */
+    for (int i = 0; i < CONFIG_BUTTON_CALLBACK_SLOTS * 2; i++) {
+        Button btn(config);
+        btn.attachPressDownEventCb([&press_down](void *button_handle) {
+            press_down++;
+        });
+        btn.attachSingleClickEventCb([&clicks, i](void *button_handle) {
+            clicks[i & 1]++;
+        });
+        TEST_ASSERT_EQUAL(2, btn.countCallBack());
+
+        /**< the callables stay in place when the button is moved */
+        Button moved(std::move(btn));
+        moved.injectLevel(1);
+        moved.injectLevel(0);
+        vTaskDelay(pdMS_TO_TICKS(CONFIG_BUTTON_SHORT_PRESS_TIME_MS * 2));
+        moved.detachPressDownEvent();
+        TEST_ASSERT_EQUAL(1, moved.countCallBack());
+    }
+    TEST_ASSERT_EQUAL(CONFIG_BUTTON_CALLBACK_SLOTS * 2, press_down);
+    TEST_ASSERT_EQUAL(CONFIG_BUTTON_CALLBACK_SLOTS, clicks[0]);
+    TEST_ASSERT_EQUAL(CONFIG_BUTTON_CALLBACK_SLOTS, clicks[1]);
+}
+
+#define FUNCTION_BENCH_CALLS    1000000
+
+static volatile int s_bench_cnt = 0;
+
+static void onBenchCb(void *button_handle, void *usr_data)
+{
+    s_bench_cnt += *(int *)usr_data;
+}
+
+static int64_t run_dispatch_bench(button_cb_t cb, void *usr_data)
+{
+    /**< the scan calls through the callback table, so does the benchmark */
+    button_cb_t volatile table_cb = cb;
+    void *volatile table_usr_data = usr_data;
+    int64_t start = esp_timer_get_time();
+    for (int i = 0; i < FUNCTION_BENCH_CALLS; i++) {
+        table_cb(NULL, table_usr_data);
+    }
+    return esp_timer_get_time() - start;
+}
+
+TEST_CASE("button lambda callback benchmark", "[button][function][benchmark]")
+{
+    int step = 1;
+    s_bench_cnt = 0;
+    int64_t raw_us = run_dispatch_bench(onBenchCb, &step);
+
+    ButtonFunction function([&step](void *button_handle) {
+        s_bench_cnt += step;
+    });
+    int64_t function_us = run_dispatch_bench(function.invoker(), function.storage());
+    TEST_ASSERT_EQUAL(2 * FUNCTION_BENCH_CALLS, s_bench_cnt);
+
+    printf("%d calls: function pointer %lld us, lambda %lld us, %u bytes per callable\n",
+           FUNCTION_BENCH_CALLS, raw_us, function_us, (unsigned)sizeof(ButtonFunction));
+}
+
+static volatile int s_high_cb_cnt = 0;
+static volatile int s_background_cb_cnt = 0;
+static volatile int s_press_up_cnt = 0;
+static button_event_t s_background_event = BUTTON_EVENT_MAX;
+
+static void onCustomButtonPressUpCb(void *button_handle, void *usr_data)
+{
+    s_press_up_cnt++;
+}
+
+static void onHighContextCb(void *button_handle, void *usr_data)
+{
+    s_high_cb_cnt++;
+}
+
+static void onBackgroundContextCb(const button_event_info_t *info, void *usr_data)
+{
+    /**< a slow handler, e.g. a display redraw */
+    vTaskDelay(pdMS_TO_TICKS(200));
+    s_background_event = info->event;
+    s_background_cb_cnt++;
+}
+
+TEST_CASE("custom button callback context test", "[button][context]")
+{
+    button_config_t cfg = {};
+    cfg.type = BUTTON_TYPE_CUSTOM;
+    cfg.custom_button_config.active_level = 1;
+    cfg.custom_button_config.button_custom_get_key_value = custom_button_get_level;
+    cfg.custom_button_config.priv = &s_custom_level;
+    s_custom_level = 0;
+
+    button_handle_t btn = iot_button_create(&cfg);
+    TEST_ASSERT_NOT_NULL(btn);
+    button_event_config_t event_cfg = {};
+    event_cfg.event = BUTTON_PRESS_DOWN;
+    event_cfg.context = BUTTON_CB_CONTEXT_BACKGROUND;
+    TEST_ASSERT_EQUAL(ESP_OK, iot_button_register_info_cb(btn, event_cfg, onBackgroundContextCb, NULL));
+    event_cfg.event = BUTTON_PRESS_UP;
+    event_cfg.context = BUTTON_CB_CONTEXT_HIGH;
+    TEST_ASSERT_EQUAL(ESP_OK, iot_button_register_event_cb(btn, event_cfg, onHighContextCb, NULL));
+    event_cfg.context = BUTTON_CB_CONTEXT_MAX;
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, iot_button_register_event_cb(btn, event_cfg, onHighContextCb, NULL));
+    TEST_ASSERT_EQUAL(ESP_OK, iot_button_register_cb(btn, BUTTON_PRESS_UP, onCustomButtonPressUpCb, NULL));
+    s_high_cb_cnt = 0;
+    s_background_cb_cnt = 0;
+    s_press_up_cnt = 0;
+
+    /**< the slow background handler delays neither the scan nor the high priority handler */
+    custom_button_click(3);
+    TEST_ASSERT_EQUAL(3, s_press_up_cnt);
+    TEST_ASSERT_EQUAL(3, s_high_cb_cnt);
+    TEST_ASSERT_LESS_THAN(3, s_background_cb_cnt);
+
+    vTaskDelay(pdMS_TO_TICKS(3 * 200 + 100));
+    TEST_ASSERT_EQUAL(3, s_background_cb_cnt);
+    TEST_ASSERT_EQUAL(BUTTON_PRESS_DOWN, s_background_event);
+
+    /**< the workers exit with the last button, give the idle task time to free them */
+    TEST_ASSERT_EQUAL(ESP_OK, iot_button_delete(btn));
+    vTaskDelay(pdMS_TO_TICKS(100));
+}
+
+#define GROUP_BUTTON_NUM    8
+#define BENCH_BUTTON_NUM    500
+
+static uint8_t s_group_level[GROUP_BUTTON_NUM];
+static void *s_last_pressed = NULL;
+
+static void onGroupButtonPressDownCb(void *button_handle, void *usr_data)
+{
+    s_last_pressed = button_handle;
+    s_press_down_cnt++;
+}
+
+static void fill_custom_configs(button_config_t *cfgs, size_t num, uint8_t *levels)
+{
+    for (size_t i = 0; i < num; i++) {
+        memset(&cfgs[i], 0, sizeof(button_config_t));
+        cfgs[i].type = BUTTON_TYPE_CUSTOM;
+        cfgs[i].custom_button_config.active_level = 1;
+        cfgs[i].custom_button_config.button_custom_get_key_value = custom_button_get_level;
+        cfgs[i].custom_button_config.priv = &levels[i];
+    }
+}
+
+TEST_CASE("custom button group test", "[button][group]")
+{
+    button_config_t cfgs[GROUP_BUTTON_NUM];
+    button_handle_t btns[GROUP_BUTTON_NUM];
+    memset(s_group_level, 0, sizeof(s_group_level));
+    fill_custom_configs(cfgs, GROUP_BUTTON_NUM, s_group_level);
+
+    button_group_handle_t group = iot_button_create_group(cfgs, GROUP_BUTTON_NUM, btns);
+    TEST_ASSERT_NOT_NULL(group);
+    button_event_config_t event_cfg = {};
+    event_cfg.event = BUTTON_PRESS_DOWN;
+    TEST_ASSERT_EQUAL(ESP_OK, iot_button_group_register_event_cb(group, event_cfg, onGroupButtonPressDownCb, NULL));
+    for (int i = 0; i < GROUP_BUTTON_NUM; i++) {
+        TEST_ASSERT_EQUAL(1, iot_button_count_event(btns[i], BUTTON_PRESS_DOWN));
+    }
+
+    s_press_down_cnt = 0;
+    s_group_level[3] = 1;
+    vTaskDelay(pdMS_TO_TICKS(50));
+    s_group_level[3] = 0;
+    vTaskDelay(pdMS_TO_TICKS(50));
+    TEST_ASSERT_EQUAL(1, s_press_down_cnt);
+    TEST_ASSERT_EQUAL(btns[3], s_last_pressed);
+
+    /* a button registering alone gets its own table, the others keep the shared one */
+    TEST_ASSERT_EQUAL(ESP_OK, iot_button_register_cb(btns[0], BUTTON_PRESS_DOWN, onCustomButtonPressDownCb, NULL));
+    TEST_ASSERT_EQUAL(2, iot_button_count_event(btns[0], BUTTON_PRESS_DOWN));
+    TEST_ASSERT_EQUAL(1, iot_button_count_event(btns[1], BUTTON_PRESS_DOWN));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_STATE, iot_button_group_register_event_cb(group, event_cfg, onGroupButtonPressDownCb, NULL));
+
+    /* a group callback of another event reaches the button with its own table too */
+    event_cfg.event = BUTTON_PRESS_UP;
+    TEST_ASSERT_EQUAL(ESP_OK, iot_button_group_register_event_cb(group, event_cfg, onGroupButtonPressDownCb, NULL));
+    TEST_ASSERT_EQUAL(3, iot_button_count_cb(btns[0]));
+    TEST_ASSERT_EQUAL(2, iot_button_count_cb(btns[1]));
+    TEST_ASSERT_EQUAL(ESP_OK, iot_button_unregister_cb(btns[1], BUTTON_PRESS_DOWN));
+    TEST_ASSERT_EQUAL(1, iot_button_count_cb(btns[1]));
+    TEST_ASSERT_EQUAL(1, iot_button_count_event(btns[2], BUTTON_PRESS_DOWN));
+
+    TEST_ASSERT_EQUAL(ESP_OK, iot_button_delete(btns[5]));
+    TEST_ASSERT_EQUAL(ESP_OK, iot_button_delete_group(group));
+}
+
+static int s_profile_long_cnt[2];
+
+static void onProfileLongPressCb(void *button_handle, void *usr_data)
+{
+    s_profile_long_cnt[(intptr_t)usr_data]++;
+}
+
+TEST_CASE("button profile apply test", "[button][profile]")
+{
+    button_config_t cfgs[GROUP_BUTTON_NUM];
+    button_handle_t btns[GROUP_BUTTON_NUM];
+    memset(s_group_level, 0, sizeof(s_group_level));
+    fill_custom_configs(cfgs, GROUP_BUTTON_NUM, s_group_level);
+    button_group_handle_t group = iot_button_create_group(cfgs, GROUP_BUTTON_NUM, btns);
+    TEST_ASSERT_NOT_NULL(group);
+    s_custom_level = 0;
+    button_config_t cfg = {};
+    cfg.type = BUTTON_TYPE_CUSTOM;
+    cfg.custom_button_config.active_level = 1;
+    cfg.custom_button_config.button_custom_get_key_value = custom_button_get_level;
+    cfg.custom_button_config.priv = &s_custom_level;
+    button_handle_t btn = iot_button_create(&cfg);
+    TEST_ASSERT_NOT_NULL(btn);
+    button_profile_targets_t targets = {};
+    targets.buttons = &btn;
+    targets.button_num = 1;
+    targets.groups = &group;
+    targets.group_num = 1;
+
+    /* entries in order: all the buttons, then the group, then the single button */
+    button_profile_entry_t entries[3] = {};
+    entries[0].target = BUTTON_PROFILE_ALL;
+    entries[0].long_press_ms = 1000;
+    entries[0].serial_ms = 50;
+    entries[1].target = BUTTON_PROFILE_GROUP;
+    entries[1].long_press_ms = 600;
+    entries[2].target = BUTTON_PROFILE_BUTTON;
+    entries[2].debounce_ticks = 1;
+    entries[2].long_press_ms = 300;
+    uint8_t profile[BUTTON_PROFILE_HEADER_SIZE + 3 * BUTTON_PROFILE_ENTRY_SIZE];
+    TEST_ASSERT_EQUAL(sizeof(profile), button_profile_pack(entries, 3, profile, sizeof(profile)));
+
+    /* a damaged profile or an unknown target is rejected before anything is applied */
+    profile[BUTTON_PROFILE_HEADER_SIZE + 4] ^= 1;
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_CRC, iot_button_apply_profile(profile, sizeof(profile), &targets));
+    profile[BUTTON_PROFILE_HEADER_SIZE + 4] ^= 1;
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_SIZE, iot_button_apply_profile(profile, sizeof(profile) - 1, &targets));
+    targets.button_num = 0;
+    TEST_ASSERT_EQUAL(ESP_ERR_NOT_FOUND, iot_button_apply_profile(profile, sizeof(profile), &targets));
+    targets.button_num = 1;
+
+    TEST_ASSERT_EQUAL(ESP_OK, iot_button_apply_profile(profile, sizeof(profile), &targets));
+    /* the long press callbacks registered afterwards default to the time of the profile */
+    TEST_ASSERT_EQUAL(ESP_OK, iot_button_register_cb(btn, BUTTON_LONG_PRESS_START, onProfileLongPressCb, (void *)0));
+    button_event_config_t event_cfg = {};
+    event_cfg.event = BUTTON_LONG_PRESS_START;
+    TEST_ASSERT_EQUAL(ESP_OK, iot_button_group_register_event_cb(group, event_cfg, onProfileLongPressCb, (void *)1));
+
+    s_profile_long_cnt[0] = 0;
+    s_profile_long_cnt[1] = 0;
+    s_custom_level = 1;
+    s_group_level[2] = 1;
+    vTaskDelay(pdMS_TO_TICKS(450));
+    TEST_ASSERT_EQUAL(1, s_profile_long_cnt[0]);
+    TEST_ASSERT_EQUAL(0, s_profile_long_cnt[1]);
+    vTaskDelay(pdMS_TO_TICKS(300));
+    TEST_ASSERT_EQUAL(1, s_profile_long_cnt[1]);
+    /* the hold rate follows the serial time of the profile */
+    uint16_t hold_cnt = iot_button_get_long_press_hold_cnt(btn);
+    vTaskDelay(pdMS_TO_TICKS(500));
+    TEST_ASSERT_INT_WITHIN(2, 10, iot_button_get_long_press_hold_cnt(btn) - hold_cnt);
+    s_custom_level = 0;
+    s_group_level[2] = 0;
+    vTaskDelay(pdMS_TO_TICKS(50));
+
+    TEST_ASSERT_EQUAL(ESP_OK, iot_button_delete(btn));
+    TEST_ASSERT_EQUAL(ESP_OK, iot_button_delete_group(group));
+}
+
+TEST_CASE("custom button timing set test", "[button][timing]")
+{
+    s_custom_level = 0;
+    button_config_t cfg = {};
+    cfg.type = BUTTON_TYPE_CUSTOM;
+    cfg.custom_button_config.active_level = 1;
+    cfg.custom_button_config.button_custom_get_key_value = custom_button_get_level;
+    cfg.custom_button_config.priv = &s_custom_level;
+    button_handle_t btn = iot_button_create(&cfg);
+    TEST_ASSERT_NOT_NULL(btn);
+
+    button_timing_config_t timing = {};
+    TEST_ASSERT_EQUAL(ESP_OK, iot_button_get_timing(btn, &timing));
+    TEST_ASSERT_EQUAL(CONFIG_BUTTON_LONG_PRESS_TIME_MS, timing.long_press_time);
+    TEST_ASSERT_EQUAL(CONFIG_BUTTON_SERIAL_TIME_MS, timing.serial_time);
+    TEST_ASSERT_EQUAL(CONFIG_BUTTON_DEBOUNCE_TICKS, timing.debounce_press_ticks);
+
+    /* the fields at 0 are kept */
+    button_timing_config_t set = {};
+    set.long_press_time = 300;
+    set.serial_time = 50;
+    set.debounce_press_ticks = 10;
+    TEST_ASSERT_EQUAL(ESP_OK, iot_button_set_timing(btn, &set));
+    TEST_ASSERT_EQUAL(ESP_OK, iot_button_get_timing(btn, &timing));
+    TEST_ASSERT_EQUAL(300, timing.long_press_time);
+    TEST_ASSERT_EQUAL(CONFIG_BUTTON_SHORT_PRESS_TIME_MS, timing.short_press_time);
+    TEST_ASSERT_EQUAL(10, timing.debounce_press_ticks);
+    TEST_ASSERT_EQUAL(CONFIG_BUTTON_DEBOUNCE_TICKS, timing.debounce_release_ticks);
+    TEST_ASSERT_EQUAL(ESP_OK, iot_button_set_param(btn, BUTTON_LONG_PRESS_TOLERANCE_MS, (void *)40));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, iot_button_set_param(btn, BUTTON_PARAM_MAX, (void *)40));
+    TEST_ASSERT_EQUAL(ESP_OK, iot_button_get_timing(btn, &timing));
+    TEST_ASSERT_EQUAL(40, timing.long_press_tolerance);
+    TEST_ASSERT_EQUAL(300, timing.long_press_time);
+
+    /* a press shorter than 10 debounce ticks is not seen */
+    s_custom_level = 1;
+    vTaskDelay(pdMS_TO_TICKS(10 * CONFIG_BUTTON_PERIOD_TIME_MS / 2));
+    s_custom_level = 0;
+    vTaskDelay(pdMS_TO_TICKS(100));
+    TEST_ASSERT_EQUAL(BUTTON_NONE_PRESS, iot_button_get_event(btn));
+
+    /* the long press starts after 300 ms and repeats every 50 ms */
+    s_custom_level = 1;
+    vTaskDelay(pdMS_TO_TICKS(10 * CONFIG_BUTTON_PERIOD_TIME_MS + 200));
+    TEST_ASSERT_EQUAL(BUTTON_PRESS_DOWN, iot_button_get_event(btn));
+    vTaskDelay(pdMS_TO_TICKS(150));
+    TEST_ASSERT_NOT_EQUAL(BUTTON_PRESS_DOWN, iot_button_get_event(btn));
+    uint16_t hold_cnt = iot_button_get_long_press_hold_cnt(btn);
+    vTaskDelay(pdMS_TO_TICKS(500));
+    TEST_ASSERT_INT_WITHIN(2, 10, iot_button_get_long_press_hold_cnt(btn) - hold_cnt);
+    s_custom_level = 0;
+    vTaskDelay(pdMS_TO_TICKS(100));
+
+    /* a long press callback with a shorter press_time lowers the long press, later setters keep it */
+    button_event_config_t event_cfg = {};
+    event_cfg.event = BUTTON_LONG_PRESS_START;
+    event_cfg.event_data.long_press.press_time = 200;
+    TEST_ASSERT_EQUAL(ESP_OK, iot_button_register_event_cb(btn, event_cfg, onCustomButtonPressDownCb, NULL));
+    TEST_ASSERT_EQUAL(ESP_OK, iot_button_set_param(btn, BUTTON_SERIAL_TIME_MS, (void *)40));
+    TEST_ASSERT_EQUAL(ESP_OK, iot_button_get_timing(btn, &timing));
+    TEST_ASSERT_EQUAL(200, timing.long_press_time);
+
+    TEST_ASSERT_EQUAL(ESP_OK, iot_button_delete(btn));
+}
+
+TEST_CASE("button group create benchmark", "[button][group][benchmark]")
+{
+    button_config_t *cfgs = (button_config_t *)calloc(BENCH_BUTTON_NUM, sizeof(button_config_t));
+    button_handle_t *btns = (button_handle_t *)calloc(BENCH_BUTTON_NUM, sizeof(button_handle_t));
+    uint8_t *levels = (uint8_t *)calloc(BENCH_BUTTON_NUM, sizeof(uint8_t));
+    TEST_ASSERT(cfgs && btns && levels);
+    fill_custom_configs(cfgs, BENCH_BUTTON_NUM, levels);
+
+    int64_t start = esp_timer_get_time();
+    for (int i = 0; i < BENCH_BUTTON_NUM; i++) {
+        btns[i] = iot_button_create(&cfgs[i]);
+        TEST_ASSERT_NOT_NULL(btns[i]);
+    }
+    int64_t created = esp_timer_get_time();
+    for (int i = 0; i < BENCH_BUTTON_NUM; i++) {
+        iot_button_delete(btns[i]);
+    }
+    int64_t deleted = esp_timer_get_time();
+    printf("%d buttons one by one: create %lld us, delete %lld us\n", BENCH_BUTTON_NUM, created - start, deleted - created);
+
+    start = esp_timer_get_time();
+    button_group_handle_t group = iot_button_create_group(cfgs, BENCH_BUTTON_NUM, btns);
+    TEST_ASSERT_NOT_NULL(group);
+    created = esp_timer_get_time();
+    TEST_ASSERT_EQUAL(ESP_OK, iot_button_delete_group(group));
+    deleted = esp_timer_get_time();
+    printf("%d buttons as a group: create %lld us, delete %lld us\n", BENCH_BUTTON_NUM, created - start, deleted - created);
+
+    free(levels);
+    free(btns);
+    free(cfgs);
+}
+
+/* raw level sampled on each scan, the press bounces before it settles */
+static const uint8_t s_bounce_trace[] = {0, 1, 0, 1, 1, 0, 1, 0, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1};
+
+static int run_debounce_trace(button_debounce_t *db)
+{
+    int edges = 0;
+    uint8_t last = 0;
+    for (size_t i = 0; i < sizeof(s_bounce_trace); i++) {
+        if (s_bounce_trace[i] != last) {
+            /* what the GPIO interrupt reports on the hardware path */
+            button_debounce_notify_edge(db, esp_timer_get_time());
+            last = s_bounce_trace[i];
+        }
+        if (button_debounce_update(db, s_bounce_trace[i])) {
+            edges++;
+        }
+        vTaskDelay(pdMS_TO_TICKS(CONFIG_BUTTON_PERIOD_TIME_MS));
+    }
+    return edges;
+}
+
+TEST_CASE("debounce backend trace test", "[button][debounce]")
+{
+    button_debounce_t db;
+
+    TEST_ASSERT_EQUAL(ESP_OK, button_debounce_init(&db, BUTTON_DEBOUNCE_SOFTWARE, -1, 0));
+    TEST_ASSERT_EQUAL(1, run_debounce_trace(&db));
+    TEST_ASSERT_EQUAL(1, db.level);
+    button_debounce_deinit(&db);
+
+    /* no GPIO, so the edge backend runs without interrupt and is fed by the trace */
+    TEST_ASSERT_EQUAL(ESP_OK, button_debounce_init(&db, BUTTON_DEBOUNCE_SOFTWARE, -1, 0));
+    db.type = BUTTON_DEBOUNCE_GPIO_EDGE;
+    TEST_ASSERT_EQUAL(1, run_debounce_trace(&db));
+    TEST_ASSERT_EQUAL(1, db.level);
+    button_debounce_deinit(&db);
+}
+
+#define TRACE_LEN           4000
+#define TRACE_PRESS_LEN     40
+#define TRACE_PERIOD        100
+#define TRACE_BOUNCE_LEN    4
+
+static uint8_t s_noisy_trace[TRACE_LEN];
+
+/* press every TRACE_PERIOD scans, bounce after each edge and random spikes of noise_permille */
+static void make_noisy_trace(uint32_t seed, int noise_permille)
+{
+    for (int i = 0; i < TRACE_LEN; i++) {
+        int phase = i % TRACE_PERIOD;
+        uint8_t level = phase < TRACE_PRESS_LEN;
+        seed = seed * 1664525 + 1013904223;
+        if ((phase < TRACE_BOUNCE_LEN || (phase >= TRACE_PRESS_LEN && phase < TRACE_PRESS_LEN + TRACE_BOUNCE_LEN)) && (seed >> 31)) {
+            level = !level;
+        } else if ((int)((seed >> 8) % 1000) < noise_permille) {
+            level = !level;
+        }
+        s_noisy_trace[i] = level;
+    }
+}
+
+TEST_CASE("debounce algorithm replay benchmark", "[button][debounce][benchmark]")
+{
+    const char *names[] = {"counter", "integrator", "asymmetric", "eager"};
+    const button_debounce_config_t cfgs[] = {
+        {BUTTON_DEBOUNCE_ALGO_COUNTER, 2, 0},
+        {BUTTON_DEBOUNCE_ALGO_INTEGRATOR, 3, 0},
+        {BUTTON_DEBOUNCE_ALGO_ASYMMETRIC, 2, 4},
+        {BUTTON_DEBOUNCE_ALGO_EAGER, 0, 4},
+    };
+    const int noise[] = {0, 20, 60};
+    const int presses = TRACE_LEN / TRACE_PERIOD;
+    int latency_x100[sizeof(cfgs) / sizeof(cfgs[0])];
+    int false_x[sizeof(cfgs) / sizeof(cfgs[0])];
+
+    for (size_t n = 0; n < sizeof(noise) / sizeof(noise[0]); n++) {
+        make_noisy_trace(n + 1, noise[n]);
+        for (size_t a = 0; a < sizeof(cfgs) / sizeof(cfgs[0]); a++) {
+            button_debounce_t db;
+            button_debounce_init(&db, BUTTON_DEBOUNCE_SOFTWARE, -1, 0);
+            TEST_ASSERT_EQUAL(ESP_OK, button_debounce_set_algo(&db, &cfgs[a]));
+
+            int edges = 0;
+            int latency = 0;
+            int detected = 0;
+            bool pending = false;
+            int64_t start = esp_timer_get_time();
+            for (int i = 0; i < TRACE_LEN; i++) {
+                if (i % TRACE_PERIOD == 0) {
+                    pending = true;
+                }
+                if (button_debounce_update(&db, s_noisy_trace[i])) {
+                    edges++;
+                    if (pending && db.level && i % TRACE_PERIOD < TRACE_PRESS_LEN) {
+                        latency += i % TRACE_PERIOD + 1;
+                        detected++;
+                        pending = false;
+                    }
+                }
+            }
+            int64_t cost = esp_timer_get_time() - start;
+            int false_events = edges > 2 * detected ? edges - 2 * detected : 0;
+            printf("noise %2d%%o %-10s: detected %d/%d, avg latency %d.%02d scans, false events %d, %d ns/scan\n",
+                   noise[n], names[a], detected, presses, detected ? latency / detected : 0,
+                   detected ? latency * 100 / detected % 100 : 0, false_events, (int)(cost * 1000 / TRACE_LEN));
+            if (noise[n] == 0) {
+                /* only bounce, every algorithm must find every press */
+                TEST_ASSERT_EQUAL(presses, detected);
+                latency_x100[a] = latency * 100 / detected;
+            }
+            false_x[a] = false_events;
+        }
+    }
+    /* eager reacts first on clean presses, the integrator rejects the most noise */
+    for (size_t a = 0; a < sizeof(cfgs) / sizeof(cfgs[0]); a++) {
+        TEST_ASSERT_LESS_OR_EQUAL(latency_x100[a], latency_x100[BUTTON_DEBOUNCE_ALGO_EAGER]);
+        TEST_ASSERT_GREATER_OR_EQUAL(false_x[BUTTON_DEBOUNCE_ALGO_INTEGRATOR], false_x[a]);
+    }
+}
+
+#define HOLD_BENCH_MS   3000
+
+static int s_hold_cb_cnt = 0;
+static int s_hold_repeats = 0;
+static int s_hold_first_gap = 0;
+static int s_hold_last_gap = 0;
+static int s_hold_last_time = 0;
+
+static void onHoldInfoCb(const button_event_info_t *info, void *usr_data)
+{
+    if (s_hold_cb_cnt) {
+        int gap = info->ticks_time - s_hold_last_time;
+        if (1 == s_hold_cb_cnt) {
+            s_hold_first_gap = gap;
+        }
+        s_hold_last_gap = gap;
+    }
+    s_hold_last_time = info->ticks_time;
+    s_hold_cb_cnt++;
+    s_hold_repeats += info->hold_repeats;
+}
+
+TEST_CASE("long press hold rate benchmark", "[button][hold][benchmark]")
+{
+    const char *names[] = {"fixed", "curve", "curve coalesced"};
+    const button_hold_config_t cfgs[] = {
+        {0, 0, 0, 0},
+        {200, 10, 1000, 0},
+        {200, 10, 1000, 100},
+    };
+    int cb_cnt[sizeof(cfgs) / sizeof(cfgs[0])];
+
+    for (size_t a = 0; a < sizeof(cfgs) / sizeof(cfgs[0]); a++) {
+        button_config_t cfg = {};
+        cfg.type = BUTTON_TYPE_CUSTOM;
+        cfg.custom_button_config.active_level = 1;
+        cfg.custom_button_config.button_custom_get_key_value = custom_button_get_level;
+        cfg.custom_button_config.priv = &s_custom_level;
+        cfg.hold_config = cfgs[a];
+
+        s_custom_level = 0;
+        button_handle_t btn = iot_button_create(&cfg);
+        TEST_ASSERT_NOT_NULL(btn);
+        button_event_config_t event_cfg = {};
+        event_cfg.event = BUTTON_LONG_PRESS_HOLD;
+        TEST_ASSERT_EQUAL(ESP_OK, iot_button_register_info_cb(btn, event_cfg, onHoldInfoCb, NULL));
+
+        s_hold_cb_cnt = 0;
+        s_hold_repeats = 0;
+        s_custom_level = 1;
+        vTaskDelay(pdMS_TO_TICKS(CONFIG_BUTTON_LONG_PRESS_TIME_MS + HOLD_BENCH_MS));
+        uint16_t hold_cnt = iot_button_get_long_press_hold_cnt(btn);
+        s_custom_level = 0;
+        vTaskDelay(pdMS_TO_TICKS(50));
+
+        printf("hold %-15s: %d callbacks/s, %d repeats/s, first gap %d ms, last gap %d ms\n", names[a],
+               s_hold_cb_cnt * 1000 / HOLD_BENCH_MS, s_hold_repeats * 1000 / HOLD_BENCH_MS, s_hold_first_gap, s_hold_last_gap);
+        /* every repeat is delivered, whether one per callback or coalesced */
+        TEST_ASSERT_GREATER_OR_EQUAL(hold_cnt, s_hold_repeats);
+        TEST_ASSERT_GREATER_THAN(0, hold_cnt);
+        cb_cnt[a] = s_hold_cb_cnt;
+        if (0 == cfgs[a].coalesce_ms) {
+            TEST_ASSERT_EQUAL(s_hold_repeats, s_hold_cb_cnt);
+        } else {
+            TEST_ASSERT_LESS_OR_EQUAL(HOLD_BENCH_MS / cfgs[a].coalesce_ms + 2, s_hold_cb_cnt);
+        }
+        if (cfgs[a].ramp_ms) {
+            /* the curve accelerates */
+            TEST_ASSERT_GREATER_THAN(s_hold_last_gap, s_hold_first_gap);
+        }
+        TEST_ASSERT_EQUAL(ESP_OK, iot_button_delete(btn));
+    }
+    /* the fixed rate is CONFIG_BUTTON_SERIAL_TIME_MS */
+    TEST_ASSERT_INT_WITHIN(2, HOLD_BENCH_MS / CONFIG_BUTTON_SERIAL_TIME_MS, cb_cnt[0]);
+    TEST_ASSERT_LESS_THAN(cb_cnt[1], cb_cnt[2]);
+}
+
 static size_t before_free_8bit;
 static size_t before_free_32bit;
 
@@ -0,0 +1,103 @@
+/* SPDX-FileCopyrightText: 2022-2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * Host test of the baseline tracking of the touch buttons.
+ *
+ * Each trace is replayed through the tracker, one filtered reading per line with the expected
+ * state: 1 touched, 0 not touched, x either (the edges of a touch). The same readings are
+ * compared with a fixed threshold from the first reading, as without tracking. Exits non-zero
+ * if the tracker misses a touch or reports a false one.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "esp_timer.h"
+#include "arduino_config.h"
+#include "button_touch.h"
+
+int64_t esp_timer_get_time(void)
+{
+    return 0;
+}
+
+typedef struct {
+    unsigned samples;
+    unsigned missed;        /**< touched readings reported untouched */
+    unsigned false_touch;   /**< untouched readings reported touched */
+} trace_result_t;
+
+static void trace_count(trace_result_t *result, char expected, bool touched)
+{
+    result->samples++;
+    if ('1' == expected && !touched) {
+        result->missed++;
+    } else if ('0' == expected && touched) {
+        result->false_touch++;
+    }
+}
+
+static int replay(const char *path)
+{
+    FILE *f = fopen(path, "r");
+    if (NULL == f) {
+        printf("%s: cannot open\n", path);
+        return 1;
+    }
+    bool rising = false;
+    uint16_t permille = CONFIG_TOUCH_BUTTON_THRESHOLD_PERMILLE;
+    button_touch_tracker_t tracker;
+    uint32_t fixed = 0;
+    trace_result_t tracked = {0}, untracked = {0};
+    char line[128];
+    bool started = false;
+    while (fgets(line, sizeof(line), f)) {
+        if ('#' == line[0]) {
+            unsigned value = 0;
+            if (0 == strncmp(line, "# rising", 8)) {
+                rising = true;
+            } else if (1 == sscanf(line, "# threshold %u", &value)) {
+                permille = value;
+            }
+            continue;
+        }
+        unsigned reading = 0;
+        char expected = 0;
+        if (2 != sscanf(line, "%u %c", &reading, &expected)) {
+            continue;
+        }
+        if (!started) {
+            started = true;
+            button_touch_tracker_init(&tracker, permille, rising);
+        }
+        bool touched = button_touch_tracker_update(&tracker, reading);
+        if (0 == fixed) {
+            fixed = button_touch_tracker_threshold(&tracker);
+        }
+        trace_count(&tracked, expected, touched);
+        trace_count(&untracked, expected, rising ? reading >= fixed : reading <= fixed);
+    }
+    fclose(f);
+
+    printf("%s: %u readings, tracked baseline: %u missed %u false, fixed threshold: %u missed %u false\n",
+           path, tracked.samples, tracked.missed, tracked.false_touch, untracked.missed, untracked.false_touch);
+    return tracked.samples && 0 == tracked.missed && 0 == tracked.false_touch ? 0 : 1;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2) {
+        printf("usage: %s trace...\n", argv[0]);
+        return 2;
+    }
+    int failed = 0;
+    for (int i = 1; i < argc; i++) {
+        failed += replay(argv[i]);
+    }
+    printf("%d of %d traces failed\n", failed, argc - 1);
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,210 @@
+/* SPDX-FileCopyrightText: 2022-2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * Host tool of the button timing profiles, see src/original/button_profile.h.
+ *
+ *   button_profile_tool pack profile.txt profile.bin    pack a text profile, checked as the firmware does
+ *   button_profile_tool check profile.bin               check a packed profile and print its entries
+ *
+ * One entry per line of the text profile, in the order they are applied:
+ *
+ *   all|group <n>|button <n>  debounce_ticks short_ms long_ms serial_ms tolerance_ms
+ *
+ * with - for a timing the entry keeps. # starts a comment.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "button_profile.h"
+
+#define TOOL_MAX_ENTRY  1024
+#define TOOL_MAX_SIZE   (BUTTON_PROFILE_HEADER_SIZE + BUTTON_PROFILE_ENTRY_SIZE * TOOL_MAX_ENTRY)
+
+static const char *s_target_name[BUTTON_PROFILE_TARGET_MAX] = {"all", "group", "button"};
+
+static const char *tool_err_name(esp_err_t err)
+{
+    switch (err) {
+    case ESP_ERR_INVALID_SIZE:
+        return "truncated";
+    case ESP_ERR_INVALID_VERSION:
+        return "not a profile or unsupported version";
+    case ESP_ERR_INVALID_CRC:
+        return "crc error";
+    case ESP_ERR_INVALID_STATE:
+        return "invalid target or timing, short must be less than long and no time under CONFIG_BUTTON_PERIOD_TIME_MS";
+    default:
+        return "invalid";
+    }
+}
+
+static int tool_parse_value(const char *token, unsigned max, unsigned *value)
+{
+    if (0 == strcmp(token, "-")) {
+        *value = 0;
+        return 0;
+    }
+    char *end;
+    unsigned long v = strtoul(token, &end, 0);
+    if (*end || 0 == v || v > max) {
+        return -1;
+    }
+    *value = v;
+    return 0;
+}
+
+static int tool_parse_line(char *line, button_profile_entry_t *entry)
+{
+    char *token[7] = {NULL};
+    int num = 0;
+    for (char *t = strtok(line, " \t\r\n"); t && num < 7; t = strtok(NULL, " \t\r\n")) {
+        token[num++] = t;
+    }
+    if (0 == num || strtok(NULL, " \t\r\n")) {
+        return -1;
+    }
+
+    memset(entry, 0, sizeof(*entry));
+    int first;
+    if (0 == strcmp(token[0], "all") && 6 == num) {
+        entry->target = BUTTON_PROFILE_ALL;
+        first = 1;
+    } else if ((0 == strcmp(token[0], "group") || 0 == strcmp(token[0], "button")) && 7 == num) {
+        entry->target = 'g' == token[0][0] ? BUTTON_PROFILE_GROUP : BUTTON_PROFILE_BUTTON;
+        char *end;
+        unsigned long index = strtoul(token[1], &end, 0);
+        if (*end || index > UINT16_MAX) {
+            return -1;
+        }
+        entry->index = index;
+        first = 2;
+    } else {
+        return -1;
+    }
+
+    unsigned v[5];
+    for (int i = 0; i < 5; i++) {
+        if (tool_parse_value(token[first + i], 0 == i ? UINT8_MAX : UINT16_MAX, &v[i])) {
+            return -1;
+        }
+    }
+    entry->debounce_ticks = v[0];
+    entry->short_press_ms = v[1];
+    entry->long_press_ms = v[2];
+    entry->serial_ms = v[3];
+    entry->tolerance_ms = v[4];
+    return 0;
+}
+
+static void tool_print_value(unsigned value)
+{
+    if (value) {
+        printf(" %6u", value);
+    } else {
+        printf(" %6s", "-");
+    }
+}
+
+static int tool_pack(const char *in, const char *out)
+{
+    FILE *f = fopen(in, "r");
+    if (!f) {
+        perror(in);
+        return 1;
+    }
+    static button_profile_entry_t entries[TOOL_MAX_ENTRY];
+    uint16_t num = 0;
+    char line[256];
+    for (int line_num = 1; fgets(line, sizeof(line), f); line_num++) {
+        char *comment = strchr(line, '#');
+        if (comment) {
+            *comment = '\0';
+        }
+        if (strspn(line, " \t\r\n") == strlen(line)) {
+            continue;
+        }
+        if (TOOL_MAX_ENTRY == num || tool_parse_line(line, &entries[num])) {
+            fprintf(stderr, "%s:%d: invalid entry\n", in, line_num);
+            fclose(f);
+            return 1;
+        }
+        num++;
+    }
+    fclose(f);
+
+    static uint8_t profile[TOOL_MAX_SIZE];
+    size_t len = button_profile_pack(entries, num, profile, sizeof(profile));
+    /**< the firmware check, so a packed profile is never rejected at startup for its values */
+    uint16_t entry_num;
+    esp_err_t err = button_profile_check(profile, len, &entry_num);
+    if (ESP_OK != err) {
+        fprintf(stderr, "%s: %s\n", in, tool_err_name(err));
+        return 1;
+    }
+    f = fopen(out, "wb");
+    if (!f || fwrite(profile, 1, len, f) != len) {
+        perror(out);
+        if (f) {
+            fclose(f);
+        }
+        return 1;
+    }
+    fclose(f);
+    printf("%s: %u entries, %zu bytes\n", out, entry_num, len);
+    return 0;
+}
+
+static int tool_check(const char *in)
+{
+    FILE *f = fopen(in, "rb");
+    if (!f) {
+        perror(in);
+        return 1;
+    }
+    static uint8_t profile[TOOL_MAX_SIZE];
+    size_t len = fread(profile, 1, sizeof(profile), f);
+    fclose(f);
+
+    uint16_t entry_num;
+    esp_err_t err = button_profile_check(profile, len, &entry_num);
+    if (ESP_OK != err) {
+        fprintf(stderr, "%s: %s\n", in, tool_err_name(err));
+        return 1;
+    }
+    printf("%s: version %u, %u entries, %zu bytes\n", in, profile[4], entry_num, button_profile_size(profile));
+    printf("target        debounce  short   long serial    tol\n");
+    for (uint16_t i = 0; i < entry_num; i++) {
+        button_profile_entry_t entry;
+        button_profile_get_entry(profile, i, &entry);
+        if (BUTTON_PROFILE_ALL == entry.target) {
+            printf("%-13s", s_target_name[entry.target]);
+        } else {
+            printf("%-6s %6u", s_target_name[entry.target], entry.index);
+        }
+        tool_print_value(entry.debounce_ticks);
+        printf("  ");
+        tool_print_value(entry.short_press_ms);
+        tool_print_value(entry.long_press_ms);
+        tool_print_value(entry.serial_ms);
+        tool_print_value(entry.tolerance_ms);
+        printf("\n");
+    }
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    if (4 == argc && 0 == strcmp(argv[1], "pack")) {
+        return tool_pack(argv[2], argv[3]);
+    }
+    if (3 == argc && 0 == strcmp(argv[1], "check")) {
+        return tool_check(argv[2]);
+    }
+    fprintf(stderr, "usage: %s pack profile.txt profile.bin\n"
+            "       %s check profile.bin\n", argv[0], argv[0]);
+    return 2;
+}